@@ -0,0 +1,94 @@
+#include "cacheStruct.h"
+#include "cacheIOHandler.h"
+#include "replacementPolicy.h"
+
+// ARC：T1 存只访问过一次的块，T2 存多次访问的块，B1/B2 记录二者最近淘汰的块号；
+// 容量随全局预算浮动，这里以分片当前驻留块数作为 c
+#define ARC_T1 0
+#define ARC_T2 1
+#define ARC_B1 0
+#define ARC_B2 1
+
+
+static void arcInsert(ReplacementState* rs, cache* entry, long key)
+{
+    size_t c = replacementSize(rs) + 1;
+    size_t b1 = ghostSize(&(rs->ghosts[ARC_B1]));
+    size_t b2 = ghostSize(&(rs->ghosts[ARC_B2]));
+
+    if (takeGhost(&(rs->ghosts[ARC_B1]), key))
+    {
+        // 刚从 T1 淘汰的块又被访问，说明 T1 太小
+        size_t delta = MAX(b2 / b1, (size_t)1);
+        rs->target = MIN(rs->target + delta, c);
+        policyListPush(rs, ARC_T2, entry);
+    }
+    else if (takeGhost(&(rs->ghosts[ARC_B2]), key))
+    {
+        size_t delta = MAX(b1 / b2, (size_t)1);
+        rs->target = (rs->target > delta) ? rs->target - delta : 0;
+        policyListPush(rs, ARC_T2, entry);
+    }
+    else
+    {
+        policyListPush(rs, ARC_T1, entry);
+    }
+}
+
+static void arcHit(ReplacementState* rs, cache* entry)
+{
+    if (entry->policyList == ARC_T2)
+    {
+        moveToHead(&(rs->lists[ARC_T2]), entry);
+        return;
+    }
+    policyListRemove(rs, entry);
+    policyListPush(rs, ARC_T2, entry);
+}
+
+static cache* arcVictim(ReplacementState* rs)
+{
+    size_t t1 = (size_t)rs->lists[ARC_T1].size;
+    size_t target = MIN(rs->target, replacementSize(rs));
+    cache* victim = NULL;
+
+    if (t1 > 0 && (t1 > target || rs->lists[ARC_T2].size == 0))
+    {
+        victim = policyListVictim(rs, ARC_T1);
+    }
+    if (victim == NULL)
+    {
+        victim = policyListVictim(rs, ARC_T2);
+    }
+    if (victim == NULL)
+    {
+        victim = policyListVictim(rs, ARC_T1);
+    }
+    return victim;
+}
+
+static void arcEvict(ReplacementState* rs, cache* entry, long key)
+{
+    int list = entry->policyList;
+    size_t c = replacementSize(rs);
+
+    policyListRemove(rs, entry);
+    addGhost(&(rs->ghosts[list == ARC_T1 ? ARC_B1 : ARC_B2]), key, c);
+}
+
+static cache* arcNext(ReplacementState* rs, cache* entry)
+{
+    return policyListsNext(rs, entry, 2);
+}
+
+const ReplacementPolicyOps arcPolicyOps =
+{
+    "arc",
+    0,
+    arcInsert,
+    arcHit,
+    arcVictim,
+    arcEvict,
+    policyListRemove,
+    arcNext,
+};
@@ -0,0 +1,841 @@
+// blkcache-bench：在普通文件（或 tmpfs、loop 设备上的文件）上按给定负载分别测直接 pread/pwrite 与经过缓存的读写，
+// 报告 IOPS、带宽、命中率与延迟分位数，不需要真实的块设备
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <getopt.h>
+#include <math.h>
+#include <pthread.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include "cacheIOHandler.h"
+#include "hashTable.h"
+#include "flusher.h"
+#include "ioEngine.h"
+#include "cacheTrace.h"
+
+#define BENCH_PATTERN_UNIFORM 0
+#define BENCH_PATTERN_ZIPF 1
+#define BENCH_PATTERN_HOTSPOT 2
+#define BENCH_PATTERN_SEQ 3
+
+#define BENCH_MODE_RAW 0x1
+#define BENCH_MODE_CACHE 0x2
+
+// 延迟直方图：每个 2 的幂区间再等分 2^BENCH_SUB_BITS 份，相对误差约 3%
+#define BENCH_SUB_BITS 5
+#define BENCH_LAT_BUCKETS ((64 - BENCH_SUB_BITS + 1) << BENCH_SUB_BITS)
+
+typedef struct BenchConfig
+{
+    const char* path;
+    size_t fileBytes;
+    size_t workingSetBytes;
+    size_t requestBytes;
+    int pattern;
+    double zipfTheta;
+    double hotFraction;     // hotspot：热区占工作集的比例
+    double hotAccess;       // hotspot：落在热区的访问比例
+    int readPercent;
+    int threads;
+    double runtime;         // 秒，ops 为 0 时按时间结束
+    unsigned long ops;      // 每个线程的操作数
+    double warmup;          // 不计入结果的预热时间（秒）
+    int modes;
+    int direct;
+    unsigned long seed;
+    size_t cacheMemory;
+    CacheOptions cacheOptions;
+    int flusher;
+    int ioEngine;
+    const char* tracePath;  // 记录缓存模式下的访问，供 blkcache-sim 回放
+} BenchConfig;
+
+typedef struct BenchHistogram
+{
+    unsigned long long count;
+    unsigned long long buckets[BENCH_LAT_BUCKETS];
+} BenchHistogram;
+
+// Zipf 分布的预计算参数（Gray 等人的方法，与 YCSB 相同），排名经过散列后映射到块上，热块不会全挤在文件开头
+typedef struct ZipfState
+{
+    unsigned long items;
+    double theta;
+    double alpha;
+    double zetan;
+    double eta;
+} ZipfState;
+
+typedef struct BenchThread
+{
+    int id;
+    int fd;
+    int useCache;
+    const BenchConfig* config;
+    const ZipfState* zipf;
+    pthread_barrier_t* barrier;
+    unsigned long long deadlineNs;  // 由主线程在预热结束后设置
+    unsigned long long rng;
+    off_t cursor;
+    void* buf;
+    unsigned long long reads;
+    unsigned long long writes;
+    unsigned long long errors;
+    BenchHistogram readLatency;
+    BenchHistogram writeLatency;
+    pthread_t thread;
+} BenchThread;
+
+typedef struct BenchResult
+{
+    double seconds;
+    unsigned long long reads;
+    unsigned long long writes;
+    unsigned long long errors;
+    BenchHistogram readLatency;
+    BenchHistogram writeLatency;
+    CacheStats stats;       // 只在缓存模式下有效，为测量期间的增量
+    double closeSeconds;    // 关闭 fd（写回脏块）的耗时
+} BenchResult;
+
+
+static unsigned long long nowNs(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (unsigned long long)ts.tv_sec * 1000000000ULL + (unsigned long long)ts.tv_nsec;
+}
+
+static unsigned long long nextRandom(unsigned long long* state)
+{
+    // xorshift64*
+    unsigned long long x = *state;
+    x ^= x >> 12;
+    x ^= x << 25;
+    x ^= x >> 27;
+    *state = x;
+    return x * 0x2545F4914F6CDD1DULL;
+}
+
+static double nextUnit(unsigned long long* state)
+{
+    return (double)(nextRandom(state) >> 11) * (1.0 / 9007199254740992.0);
+}
+
+static unsigned long long mixHash(unsigned long long x)
+{
+    x ^= x >> 33;
+    x *= 0xff51afd7ed558ccdULL;
+    x ^= x >> 33;
+    x *= 0xc4ceb9fe1a85ec53ULL;
+    x ^= x >> 33;
+    return x;
+}
+
+static void initZipf(ZipfState* zipf, unsigned long items, double theta)
+{
+    double zeta2 = 1.0 + pow(0.5, theta);
+
+    zipf->items = items;
+    zipf->theta = theta;
+    zipf->zetan = 0;
+    for (unsigned long i = 1; i <= items; i++)
+    {
+        zipf->zetan += 1.0 / pow((double)i, theta);
+    }
+    zipf->alpha = 1.0 / (1.0 - theta);
+    zipf->eta = (1.0 - pow(2.0 / (double)items, 1.0 - theta)) / (1.0 - zeta2 / zipf->zetan);
+}
+
+static unsigned long nextZipf(const ZipfState* zipf, unsigned long long* state)
+{
+    double u = nextUnit(state);
+    double uz = u * zipf->zetan;
+    unsigned long rank;
+
+    if (uz < 1.0)
+    {
+        rank = 0;
+    }
+    else if (uz < 1.0 + pow(0.5, zipf->theta))
+    {
+        rank = 1;
+    }
+    else
+    {
+        rank = (unsigned long)((double)zipf->items * pow(zipf->eta * u - zipf->eta + 1.0, zipf->alpha));
+    }
+    return (unsigned long)(mixHash(MIN(rank, zipf->items - 1)) % zipf->items);
+}
+
+static int latencyBucket(unsigned long long ns)
+{
+    if (ns < (1ULL << BENCH_SUB_BITS))
+    {
+        return (int)ns;
+    }
+    int shift = 63 - __builtin_clzll(ns) - BENCH_SUB_BITS;
+    return ((shift + 1) << BENCH_SUB_BITS) + (int)((ns >> shift) - (1ULL << BENCH_SUB_BITS));
+}
+
+// 桶内取中值
+static double bucketValue(int bucket)
+{
+    if (bucket < (1 << BENCH_SUB_BITS))
+    {
+        return (double)bucket;
+    }
+    int shift = (bucket >> BENCH_SUB_BITS) - 1;
+    unsigned long long low = ((1ULL << BENCH_SUB_BITS) + (unsigned long long)(bucket & ((1 << BENCH_SUB_BITS) - 1))) << shift;
+    return (double)low + (double)(1ULL << shift) / 2.0;
+}
+
+static void recordLatency(BenchHistogram* histogram, unsigned long long ns)
+{
+    histogram->buckets[latencyBucket(ns)]++;
+    histogram->count++;
+}
+
+static void mergeHistogram(BenchHistogram* total, const BenchHistogram* histogram)
+{
+    total->count += histogram->count;
+    for (int i = 0; i < BENCH_LAT_BUCKETS; i++)
+    {
+        total->buckets[i] += histogram->buckets[i];
+    }
+}
+
+// 返回微秒
+static double histogramPercentile(const BenchHistogram* histogram, double fraction)
+{
+    if (histogram->count == 0)
+    {
+        return 0;
+    }
+
+    unsigned long long target = (unsigned long long)ceil(fraction * (double)histogram->count);
+    unsigned long long seen = 0;
+    for (int i = 0; i < BENCH_LAT_BUCKETS; i++)
+    {
+        seen += histogram->buckets[i];
+        if (seen >= target && seen > 0)
+        {
+            return bucketValue(i) / 1000.0;
+        }
+    }
+    return 0;
+}
+
+static off_t nextOffset(BenchThread* t)
+{
+    const BenchConfig* config = t->config;
+    unsigned long slots = (unsigned long)(config->workingSetBytes / config->requestBytes);
+    unsigned long slot;
+
+    switch (config->pattern)
+    {
+    case BENCH_PATTERN_ZIPF:
+        slot = nextZipf(t->zipf, &(t->rng));
+        break;
+    case BENCH_PATTERN_HOTSPOT:
+    {
+        unsigned long hotSlots = MAX((unsigned long)((double)slots * config->hotFraction), 1UL);
+        if (nextUnit(&(t->rng)) < config->hotAccess || hotSlots == slots)
+        {
+            slot = (unsigned long)(nextRandom(&(t->rng)) % hotSlots);
+        }
+        else
+        {
+            slot = hotSlots + (unsigned long)(nextRandom(&(t->rng)) % (slots - hotSlots));
+        }
+        break;
+    }
+    case BENCH_PATTERN_SEQ:
+    {
+        off_t offset = t->cursor;
+        t->cursor += (off_t)config->requestBytes;
+        if (t->cursor + (off_t)config->requestBytes > (off_t)config->workingSetBytes)
+        {
+            t->cursor = 0;
+        }
+        return offset;
+    }
+    default:
+        slot = (unsigned long)(nextRandom(&(t->rng)) % slots);
+        break;
+    }
+    return (off_t)slot * (off_t)config->requestBytes;
+}
+
+static void runOne(BenchThread* t, int record)
+{
+    const BenchConfig* config = t->config;
+    off_t offset = nextOffset(t);
+    int isWrite = (int)(nextRandom(&(t->rng)) % 100) >= config->readPercent;
+    unsigned long long start = nowNs();
+    ssize_t done;
+
+    if (isWrite)
+    {
+        done = t->useCache ? writeWithCache(t->fd, t->buf, config->requestBytes, offset)
+                           : pwrite(t->fd, t->buf, config->requestBytes, offset);
+    }
+    else
+    {
+        done = t->useCache ? readWithCache(t->fd, t->buf, config->requestBytes, offset)
+                           : pread(t->fd, t->buf, config->requestBytes, offset);
+    }
+
+    if (!record)
+    {
+        return;
+    }
+    if (done != (ssize_t)config->requestBytes)
+    {
+        t->errors++;
+    }
+    if (isWrite)
+    {
+        recordLatency(&(t->writeLatency), nowNs() - start);
+        t->writes++;
+    }
+    else
+    {
+        recordLatency(&(t->readLatency), nowNs() - start);
+        t->reads++;
+    }
+}
+
+static void* benchThreadMain(void* arg)
+{
+    BenchThread* t = (BenchThread*)arg;
+    const BenchConfig* config = t->config;
+
+    pthread_barrier_wait(t->barrier);
+    if (config->warmup > 0)
+    {
+        unsigned long long warmupEnd = nowNs() + (unsigned long long)(config->warmup * 1e9);
+        while (nowNs() < warmupEnd)
+        {
+            runOne(t, 0);
+        }
+    }
+
+    // 主线程在两次同步之间读取统计并设置截止时间
+    pthread_barrier_wait(t->barrier);
+    pthread_barrier_wait(t->barrier);
+
+    if (config->ops > 0)
+    {
+        for (unsigned long i = 0; i < config->ops; i++)
+        {
+            runOne(t, 1);
+        }
+    }
+    else
+    {
+        while (nowNs() < t->deadlineNs)
+        {
+            runOne(t, 1);
+        }
+    }
+    return NULL;
+}
+
+static int openTarget(const BenchConfig* config, int useCache)
+{
+    int flags = O_RDWR | (config->direct ? O_DIRECT : 0);
+
+    if (!useCache)
+    {
+        int fd = open(config->path, flags);
+        if (fd < 0)
+        {
+            fprintf(stderr, "Error: Failed to open %s: %s\n", config->path, strerror(errno));
+        }
+        return fd;
+    }
+
+    if (config->cacheMemory != 0)
+    {
+        setCacheMemoryLimit(config->cacheMemory);
+    }
+    int fd = openWithCache(config->path, flags, 0, CACHE_TYPE_HOST, &(config->cacheOptions));
+    if (fd < 0)
+    {
+        fprintf(stderr, "Error: Failed to open %s with cache\n", config->path);
+    }
+    return fd;
+}
+
+static int runBench(const BenchConfig* config, const ZipfState* zipf, int useCache, BenchResult* result)
+{
+    int fd = openTarget(config, useCache);
+    if (fd < 0)
+    {
+        return -1;
+    }
+
+    BenchThread* threads = (BenchThread*)calloc((size_t)config->threads, sizeof(BenchThread));
+    if (threads == NULL)
+    {
+        perror("Failed to allocate bench threads");
+        useCache ? closeWithCache(fd) : close(fd);
+        return -1;
+    }
+
+    pthread_barrier_t barrier;
+    pthread_barrier_init(&barrier, NULL, (unsigned int)config->threads + 1);
+
+    int started = 0;
+    for (int i = 0; i < config->threads; i++)
+    {
+        BenchThread* t = &threads[i];
+        t->id = i;
+        t->fd = fd;
+        t->useCache = useCache;
+        t->config = config;
+        t->zipf = zipf;
+        t->barrier = &barrier;
+        t->rng = mixHash(config->seed + (unsigned long long)i * 0x9E3779B97F4A7C15ULL) | 1;
+        // 顺序负载各线程从工作集的不同位置开始
+        t->cursor = (off_t)(config->workingSetBytes / config->requestBytes / (size_t)config->threads) * i * (off_t)config->requestBytes;
+        if (posix_memalign(&(t->buf), 4096, config->requestBytes) != 0)
+        {
+            fprintf(stderr, "Error: Failed to allocate bench buffer\n");
+            t->buf = NULL;
+            break;
+        }
+        memset(t->buf, 0xA5 ^ i, config->requestBytes);
+        if (pthread_create(&(t->thread), NULL, benchThreadMain, t) != 0)
+        {
+            perror("Failed to start bench thread");
+            free(t->buf);
+            t->buf = NULL;
+            break;
+        }
+        started++;
+    }
+
+    if (started < config->threads)
+    {
+        // 已启动的线程在第一次同步处等待，无法让它们退出，直接结束进程
+        fprintf(stderr, "Error: Only %d of %d bench threads started\n", started, config->threads);
+        exit(EXIT_FAILURE);
+    }
+
+    CacheStats before;
+    memset(&before, 0, sizeof(before));
+
+    pthread_barrier_wait(&barrier);
+    pthread_barrier_wait(&barrier);
+    if (useCache)
+    {
+        getCacheStats(fd, &before);
+    }
+    unsigned long long start = nowNs();
+    unsigned long long deadline = start + (unsigned long long)(config->runtime * 1e9);
+    for (int i = 0; i < config->threads; i++)
+    {
+        threads[i].deadlineNs = deadline;
+    }
+    pthread_barrier_wait(&barrier);
+
+    for (int i = 0; i < config->threads; i++)
+    {
+        pthread_join(threads[i].thread, NULL);
+    }
+    unsigned long long end = nowNs();
+
+    memset(result, 0, sizeof(*result));
+    result->seconds = (double)(end - start) / 1e9;
+    for (int i = 0; i < config->threads; i++)
+    {
+        result->reads += threads[i].reads;
+        result->writes += threads[i].writes;
+        result->errors += threads[i].errors;
+        mergeHistogram(&(result->readLatency), &(threads[i].readLatency));
+        mergeHistogram(&(result->writeLatency), &(threads[i].writeLatency));
+        free(threads[i].buf);
+    }
+
+    if (useCache)
+    {
+        CacheStats after;
+        getCacheStats(fd, &after);
+        result->stats = after;
+        result->stats.hits -= before.hits;
+        result->stats.misses -= before.misses;
+        result->stats.readaheadHits -= before.readaheadHits;
+        result->stats.cleanEvictions -= before.cleanEvictions;
+        result->stats.dirtyEvictions -= before.dirtyEvictions;
+        result->stats.deviceReadBytes -= before.deviceReadBytes;
+        result->stats.deviceWriteBytes -= before.deviceWriteBytes;
+        result->stats.writeBackBatches -= before.writeBackBatches;
+
+        unsigned long long closeStart = nowNs();
+        closeWithCache(fd);
+        result->closeSeconds = (double)(nowNs() - closeStart) / 1e9;
+    }
+    else
+    {
+        close(fd);
+    }
+
+    pthread_barrier_destroy(&barrier);
+    free(threads);
+    return 0;
+}
+
+static void printLatencyLine(const char* label, const BenchHistogram* histogram)
+{
+    if (histogram->count == 0)
+    {
+        return;
+    }
+    printf("  %-5s lat(us): p50 %.1f  p99 %.1f  p99.9 %.1f\n", label, histogramPercentile(histogram, 0.50),
+           histogramPercentile(histogram, 0.99), histogramPercentile(histogram, 0.999));
+}
+
+static void printResult(const char* mode, const BenchConfig* config, const BenchResult* result)
+{
+    unsigned long long ops = result->reads + result->writes;
+    double iops = (result->seconds > 0) ? (double)ops / result->seconds : 0;
+    double mbps = iops * (double)config->requestBytes / (1024.0 * 1024.0);
+    BenchHistogram all = result->readLatency;
+
+    mergeHistogram(&all, &(result->writeLatency));
+    printf("%-5s %10llu ops  %10.0f IOPS  %9.1f MiB/s", mode, ops, iops, mbps);
+    if (strcmp(mode, "cache") == 0)
+    {
+        unsigned long long lookups = result->stats.hits + result->stats.misses;
+        printf("  hit %5.1f%%", (lookups > 0) ? 100.0 * (double)result->stats.hits / (double)lookups : 0.0);
+    }
+    if (result->errors > 0)
+    {
+        printf("  errors %llu", result->errors);
+    }
+    printf("\n");
+    printLatencyLine("all", &all);
+    if (result->readLatency.count > 0 && result->writeLatency.count > 0)
+    {
+        printLatencyLine("read", &(result->readLatency));
+        printLatencyLine("write", &(result->writeLatency));
+    }
+
+    if (strcmp(mode, "cache") == 0)
+    {
+        const CacheStats* s = &(result->stats);
+        printf("  cache: readahead hits %llu, evictions %llu clean / %llu dirty, write-back batches %llu\n",
+               s->readaheadHits, s->cleanEvictions, s->dirtyEvictions, s->writeBackBatches);
+        printf("  device: read %.1f MiB, written %.1f MiB; resident %.1f MiB, dirty %.1f MiB; close %.3fs\n",
+               (double)s->deviceReadBytes / 1048576.0, (double)s->deviceWriteBytes / 1048576.0,
+               (double)s->residentBytes / 1048576.0, (double)s->dirtyBytes / 1048576.0, result->closeSeconds);
+    }
+}
+
+// 文件不存在或小于 fileBytes 时补足，内容为非零的伪随机数据
+static int prepareFile(const BenchConfig* config)
+{
+    struct stat st;
+    if (stat(config->path, &st) == 0 && (S_ISBLK(st.st_mode) || (size_t)st.st_size >= config->fileBytes))
+    {
+        return 0;
+    }
+
+    int fd = open(config->path, O_RDWR | O_CREAT, 0644);
+    if (fd < 0)
+    {
+        fprintf(stderr, "Error: Failed to create %s: %s\n", config->path, strerror(errno));
+        return -1;
+    }
+
+    size_t chunk = 1UL << 20;
+    unsigned long long* buf = (unsigned long long*)malloc(chunk);
+    if (buf == NULL)
+    {
+        perror("Failed to allocate fill buffer");
+        close(fd);
+        return -1;
+    }
+
+    unsigned long long rng = config->seed | 1;
+    off_t pos = (stat(config->path, &st) == 0) ? st.st_size - st.st_size % (off_t)chunk : 0;
+    printf("preparing %s (%zu MiB)\n", config->path, config->fileBytes >> 20);
+    while ((size_t)pos < config->fileBytes)
+    {
+        size_t length = MIN(chunk, config->fileBytes - (size_t)pos);
+        for (size_t i = 0; i < length / sizeof(*buf); i++)
+        {
+            buf[i] = nextRandom(&rng);
+        }
+        if (pwrite(fd, buf, length, pos) != (ssize_t)length)
+        {
+            fprintf(stderr, "Error: Failed to fill %s: %s\n", config->path, strerror(errno));
+            free(buf);
+            close(fd);
+            return -1;
+        }
+        pos += (off_t)length;
+    }
+    free(buf);
+    fsync(fd);
+    close(fd);
+    return 0;
+}
+
+static int parseSize(const char* text, size_t* value)
+{
+    char* end = NULL;
+    double number = strtod(text, &end);
+    if (end == text || number < 0)
+    {
+        return -1;
+    }
+
+    switch (*end)
+    {
+    case 'k': case 'K': number *= 1024.0; end++; break;
+    case 'm': case 'M': number *= 1024.0 * 1024.0; end++; break;
+    case 'g': case 'G': number *= 1024.0 * 1024.0 * 1024.0; end++; break;
+    default: break;
+    }
+    if (*end != '\0')
+    {
+        return -1;
+    }
+    *value = (size_t)number;
+    return 0;
+}
+
+static int parseName(const char* text, const char* const* names, int count)
+{
+    for (int i = 0; i < count; i++)
+    {
+        if (strcmp(text, names[i]) == 0)
+        {
+            return i;
+        }
+    }
+    return -1;
+}
+
+static void usage(const char* program)
+{
+    fprintf(stderr,
+            "Usage: %s --file PATH [options]\n"
+            "Workload:\n"
+            "  --size BYTES           file size, created and filled if smaller (default 1G)\n"
+            "  --working-set BYTES    bytes at the start of the file the workload touches (default --size)\n"
+            "  --bs BYTES             request size (default 4k)\n"
+            "  --pattern NAME         uniform | zipf | hotspot | seq (default uniform)\n"
+            "  --zipf-theta T         zipf skew, 0 < T < 1 (default 0.99)\n"
+            "  --hot-fraction F       hotspot: hot share of the working set (default 0.1)\n"
+            "  --hot-access F         hotspot: share of accesses to the hot set (default 0.9)\n"
+            "  --read-pct N           percentage of reads (default 100)\n"
+            "  --threads N            (default 1)\n"
+            "  --runtime SEC          measured run time (default 5)\n"
+            "  --ops N                fixed ops per thread instead of --runtime\n"
+            "  --warmup SEC           run unmeasured first (default 0)\n"
+            "  --mode NAME            raw | cache | both (default both)\n"
+            "  --direct               open with O_DIRECT (not supported on tmpfs)\n"
+            "  --seed N\n"
+            "Cache:\n"
+            "  --cache-mem BYTES      global cache memory limit (default 64M)\n"
+            "  --block-size BYTES     cache block size\n"
+            "  --policy NAME          lru | arc | 2q | s3fifo | clock\n"
+            "  --write-policy NAME    back | through | around\n"
+            "  --readahead BYTES      readahead window, 0 to disable\n"
+            "  --shards N\n"
+            "  --flusher              run the background flusher\n"
+            "  --io-engine            use the io_uring engine\n"
+            "  --trace PATH           record the cached run for blkcache-sim\n"
+            "Raw and cached runs share the kernel page cache; use --direct or a file larger than RAM\n"
+            "to compare against the device itself. Build with CFLAGS='-O2' for meaningful numbers.\n",
+            program);
+}
+
+int main(int argc, char** argv)
+{
+    static const char* const patternNames[] = { "uniform", "zipf", "hotspot", "seq" };
+    static const char* const policyNames[] = { "lru", "arc", "2q", "s3fifo", "clock" };
+    static const char* const writePolicyNames[] = { "back", "through", "around" };
+    static const struct option longOptions[] =
+    {
+        { "file", required_argument, NULL, 'f' },
+        { "size", required_argument, NULL, 's' },
+        { "working-set", required_argument, NULL, 'w' },
+        { "bs", required_argument, NULL, 'b' },
+        { "pattern", required_argument, NULL, 'p' },
+        { "zipf-theta", required_argument, NULL, 'z' },
+        { "hot-fraction", required_argument, NULL, 'H' },
+        { "hot-access", required_argument, NULL, 'A' },
+        { "read-pct", required_argument, NULL, 'r' },
+        { "threads", required_argument, NULL, 't' },
+        { "runtime", required_argument, NULL, 'T' },
+        { "ops", required_argument, NULL, 'n' },
+        { "warmup", required_argument, NULL, 'W' },
+        { "mode", required_argument, NULL, 'm' },
+        { "direct", no_argument, NULL, 'd' },
+        { "seed", required_argument, NULL, 'S' },
+        { "cache-mem", required_argument, NULL, 'M' },
+        { "block-size", required_argument, NULL, 'B' },
+        { "policy", required_argument, NULL, 'P' },
+        { "write-policy", required_argument, NULL, 'Y' },
+        { "readahead", required_argument, NULL, 'R' },
+        { "shards", required_argument, NULL, 'C' },
+        { "flusher", no_argument, NULL, 'F' },
+        { "io-engine", no_argument, NULL, 'E' },
+        { "trace", required_argument, NULL, 'L' },
+        { "help", no_argument, NULL, 'h' },
+        { NULL, 0, NULL, 0 }
+    };
+
+    BenchConfig config;
+    memset(&config, 0, sizeof(config));
+    config.fileBytes = 1UL << 30;
+    config.requestBytes = 4096;
+    config.pattern = BENCH_PATTERN_UNIFORM;
+    config.zipfTheta = 0.99;
+    config.hotFraction = 0.1;
+    config.hotAccess = 0.9;
+    config.readPercent = 100;
+    config.threads = 1;
+    config.runtime = 5;
+    config.modes = BENCH_MODE_RAW | BENCH_MODE_CACHE;
+    config.seed = 1;
+
+    int option;
+    int bad = 0;
+    while ((option = getopt_long(argc, argv, "", longOptions, NULL)) != -1)
+    {
+        size_t size = 0;
+        switch (option)
+        {
+        case 'f': config.path = optarg; break;
+        case 's': bad |= parseSize(optarg, &(config.fileBytes)); break;
+        case 'w': bad |= parseSize(optarg, &(config.workingSetBytes)); break;
+        case 'b': bad |= parseSize(optarg, &(config.requestBytes)); break;
+        case 'p': bad |= (config.pattern = parseName(optarg, patternNames, 4)) < 0; break;
+        case 'z': config.zipfTheta = atof(optarg); break;
+        case 'H': config.hotFraction = atof(optarg); break;
+        case 'A': config.hotAccess = atof(optarg); break;
+        case 'r': config.readPercent = atoi(optarg); break;
+        case 't': config.threads = atoi(optarg); break;
+        case 'T': config.runtime = atof(optarg); break;
+        case 'n': config.ops = strtoul(optarg, NULL, 0); break;
+        case 'W': config.warmup = atof(optarg); break;
+        case 'm':
+            if (strcmp(optarg, "raw") == 0) config.modes = BENCH_MODE_RAW;
+            else if (strcmp(optarg, "cache") == 0) config.modes = BENCH_MODE_CACHE;
+            else if (strcmp(optarg, "both") == 0) config.modes = BENCH_MODE_RAW | BENCH_MODE_CACHE;
+            else bad = 1;
+            break;
+        case 'd': config.direct = 1; break;
+        case 'S': config.seed = strtoul(optarg, NULL, 0); break;
+        case 'M': bad |= parseSize(optarg, &(config.cacheMemory)); break;
+        case 'B': bad |= parseSize(optarg, &(config.cacheOptions.blockSize)); break;
+        case 'P': bad |= (config.cacheOptions.policy = parseName(optarg, policyNames, 5)) < 0; break;
+        case 'Y': bad |= (config.cacheOptions.writePolicy = parseName(optarg, writePolicyNames, 3)) < 0; break;
+        case 'R':
+            bad |= parseSize(optarg, &size);
+            config.cacheOptions.readaheadBytes = (size == 0) ? CACHE_READAHEAD_DISABLED : size;
+            break;
+        case 'C': config.cacheOptions.shardCount = (unsigned int)atoi(optarg); break;
+        case 'F': config.flusher = 1; break;
+        case 'E': config.ioEngine = 1; break;
+        case 'L': config.tracePath = optarg; break;
+        default: bad = 1; break;
+        }
+    }
+
+    if (config.workingSetBytes == 0 || config.workingSetBytes > config.fileBytes)
+    {
+        config.workingSetBytes = config.fileBytes;
+    }
+    if (bad || config.path == NULL || config.requestBytes == 0 || config.threads <= 0 ||
+        config.readPercent < 0 || config.readPercent > 100 || config.workingSetBytes < config.requestBytes ||
+        config.zipfTheta <= 0 || config.zipfTheta >= 1 || config.hotFraction <= 0 || config.hotFraction > 1)
+    {
+        usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+    if (config.direct && (config.requestBytes % 4096) != 0)
+    {
+        fprintf(stderr, "Error: --direct needs a request size that is a multiple of 4096\n");
+        return EXIT_FAILURE;
+    }
+
+    if (prepareFile(&config) < 0)
+    {
+        return EXIT_FAILURE;
+    }
+
+    ZipfState zipf;
+    memset(&zipf, 0, sizeof(zipf));
+    if (config.pattern == BENCH_PATTERN_ZIPF)
+    {
+        initZipf(&zipf, (unsigned long)(config.workingSetBytes / config.requestBytes), config.zipfTheta);
+    }
+
+    printf("file %s, working set %zu MiB, bs %zu, pattern %s, read %d%%, threads %d, %s\n", config.path,
+           config.workingSetBytes >> 20, config.requestBytes, patternNames[config.pattern], config.readPercent,
+           config.threads, config.direct ? "O_DIRECT" : "buffered");
+
+    BenchResult result;
+    if (config.modes & BENCH_MODE_RAW)
+    {
+        if (runBench(&config, &zipf, 0, &result) < 0)
+        {
+            return EXIT_FAILURE;
+        }
+        printResult("raw", &config, &result);
+    }
+
+    if (config.modes & BENCH_MODE_CACHE)
+    {
+        if (config.ioEngine)
+        {
+            IoEngineOptions engineOptions;
+            memset(&engineOptions, 0, sizeof(engineOptions));
+            if (startIoEngine(&engineOptions) < 0)
+            {
+                fprintf(stderr, "Warning: io_uring engine unavailable, using synchronous I/O\n");
+            }
+        }
+        if (config.flusher && startCacheFlusher(NULL) < 0)
+        {
+            fprintf(stderr, "Warning: Failed to start cache flusher\n");
+        }
+
+        if (config.tracePath != NULL && startCacheTrace(config.tracePath) < 0)
+        {
+            return EXIT_FAILURE;
+        }
+        int ret = runBench(&config, &zipf, 1, &result);
+        if (config.tracePath != NULL)
+        {
+            stopCacheTrace();
+        }
+        if (config.flusher)
+        {
+            stopCacheFlusher();
+        }
+        if (config.ioEngine)
+        {
+            stopIoEngine();
+        }
+        if (ret < 0)
+        {
+            return EXIT_FAILURE;
+        }
+        printResult("cache", &config, &result);
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,203 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "blockIndex.h"
+
+#define BLOCK_INDEX_HASH(key, shift) ((size_t)(((unsigned long)(key) * 0x9E3779B97F4A7C15UL) >> (shift)))
+
+
+static unsigned int capacityToShift(size_t capacity)
+{
+    unsigned int bits = 0;
+    while (((size_t)1 << bits) < capacity)
+    {
+        bits++;
+    }
+    return (unsigned int)(sizeof(unsigned long) * 8) - bits;
+}
+
+static BlockIndexSlot* allocSlots(size_t capacity)
+{
+    BlockIndexSlot* slots = (BlockIndexSlot*)malloc(capacity * sizeof(BlockIndexSlot));
+    if (slots == NULL)
+    {
+        return NULL;
+    }
+
+    for (size_t i = 0; i < capacity; i++)
+    {
+        slots[i].key = BLOCK_INDEX_EMPTY_KEY;
+        slots[i].entry = NULL;
+    }
+    return slots;
+}
+
+static void placeSlot(BlockIndexSlot* slots, size_t mask, unsigned int shift, long key, struct cache* entry)
+{
+    size_t i = BLOCK_INDEX_HASH(key, shift);
+    while (slots[i].key != BLOCK_INDEX_EMPTY_KEY)
+    {
+        i = (i + 1) & mask;
+    }
+    slots[i].key = key;
+    slots[i].entry = entry;
+}
+
+static int resizeBlockIndex(BlockIndex* index, size_t newCapacity)
+{
+    BlockIndexSlot* newSlots = allocSlots(newCapacity);
+    if (newSlots == NULL)
+    {
+        perror("Failed to resize block index");
+        return -1;
+    }
+
+    unsigned int newShift = capacityToShift(newCapacity);
+    for (size_t i = 0; i < index->capacity; i++)
+    {
+        if (index->slots[i].key != BLOCK_INDEX_EMPTY_KEY)
+        {
+            placeSlot(newSlots, newCapacity - 1, newShift, index->slots[i].key, index->slots[i].entry);
+        }
+    }
+
+    free(index->slots);
+    index->slots = newSlots;
+    index->capacity = newCapacity;
+    index->shift = newShift;
+    return 0;
+}
+
+
+BlockIndex* createBlockIndex(size_t initialCapacity)
+{
+    size_t capacity = BLOCK_INDEX_MIN_CAPACITY;
+    while (capacity < initialCapacity)
+    {
+        capacity <<= 1;
+    }
+
+    BlockIndex* index = (BlockIndex*)malloc(sizeof(BlockIndex));
+    if (index == NULL)
+    {
+        return NULL;
+    }
+
+    index->slots = allocSlots(capacity);
+    if (index->slots == NULL)
+    {
+        free(index);
+        return NULL;
+    }
+
+    index->capacity = capacity;
+    index->size = 0;
+    index->shift = capacityToShift(capacity);
+    return index;
+}
+
+struct cache* lookupBlockIndex(const BlockIndex* index, long key)
+{
+    size_t mask = index->capacity - 1;
+    size_t i = BLOCK_INDEX_HASH(key, index->shift);
+
+    while (index->slots[i].key != BLOCK_INDEX_EMPTY_KEY)
+    {
+        if (index->slots[i].key == key)
+        {
+            return index->slots[i].entry;
+        }
+        i = (i + 1) & mask;
+    }
+    return NULL;
+}
+
+int insertBlockIndex(BlockIndex* index, long key, struct cache* entry)
+{
+    if (key < 0)
+    {
+        fprintf(stderr, "Error: Invalid block key %ld\n", key);
+        return -1;
+    }
+
+    if (index->size + 1 > BLOCK_INDEX_MAX_LOAD(index->capacity))
+    {
+        if (resizeBlockIndex(index, index->capacity << 1) < 0)
+        {
+            return -1;
+        }
+    }
+
+    size_t mask = index->capacity - 1;
+    size_t i = BLOCK_INDEX_HASH(key, index->shift);
+    while (index->slots[i].key != BLOCK_INDEX_EMPTY_KEY)
+    {
+        if (index->slots[i].key == key)
+        {
+            index->slots[i].entry = entry;
+            return 0;
+        }
+        i = (i + 1) & mask;
+    }
+
+    index->slots[i].key = key;
+    index->slots[i].entry = entry;
+    index->size++;
+    return 0;
+}
+
+struct cache* removeBlockIndex(BlockIndex* index, long key)
+{
+    size_t mask = index->capacity - 1;
+    size_t i = BLOCK_INDEX_HASH(key, index->shift);
+
+    while (index->slots[i].key != key)
+    {
+        if (index->slots[i].key == BLOCK_INDEX_EMPTY_KEY)
+        {
+            return NULL;
+        }
+        i = (i + 1) & mask;
+    }
+
+    struct cache* entry = index->slots[i].entry;
+
+    // 向后移位删除，避免留下墓碑
+    size_t j = i;
+    while (1)
+    {
+        j = (j + 1) & mask;
+        if (index->slots[j].key == BLOCK_INDEX_EMPTY_KEY)
+        {
+            break;
+        }
+
+        size_t home = BLOCK_INDEX_HASH(index->slots[j].key, index->shift);
+        if (((j - home) & mask) >= ((j - i) & mask))
+        {
+            index->slots[i] = index->slots[j];
+            i = j;
+        }
+    }
+
+    index->slots[i].key = BLOCK_INDEX_EMPTY_KEY;
+    index->slots[i].entry = NULL;
+    index->size--;
+
+    if (index->capacity > BLOCK_INDEX_MIN_CAPACITY && index->size < index->capacity / 8)
+    {
+        resizeBlockIndex(index, index->capacity >> 1);
+    }
+
+    return entry;
+}
+
+void destroyBlockIndex(BlockIndex* index)
+{
+    if (index == NULL)
+    {
+        return;
+    }
+    free(index->slots);
+    free(index);
+}
@@ -0,0 +1,34 @@
+#ifndef BLOCK_INDEX_H
+#define BLOCK_INDEX_H
+
+#include <stddef.h>
+
+struct cache;
+
+#define BLOCK_INDEX_EMPTY_KEY (-1L)
+#define BLOCK_INDEX_MIN_CAPACITY 64
+#define BLOCK_INDEX_MAX_LOAD(cap) ((cap) / 4 * 3)
+
+typedef struct BlockIndexSlot
+{
+    long key;
+    struct cache* entry;
+} BlockIndexSlot;
+
+// 开放寻址（线性探测）哈希表，按块号索引缓存项，容量始终为 2 的幂
+typedef struct BlockIndex
+{
+    size_t capacity;
+    size_t size;
+    unsigned int shift;
+    BlockIndexSlot* slots;
+} BlockIndex;
+
+
+BlockIndex* createBlockIndex(size_t initialCapacity);
+struct cache* lookupBlockIndex(const BlockIndex* index, long key);
+int insertBlockIndex(BlockIndex* index, long key, struct cache* entry);
+struct cache* removeBlockIndex(BlockIndex* index, long key);
+void destroyBlockIndex(BlockIndex* index);
+
+#endif
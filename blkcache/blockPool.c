@@ -0,0 +1,251 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "cacheStruct.h"
+#include "blockPool.h"
+#include "ioEngine.h"
+
+typedef struct ThreadBlockCache
+{
+    unsigned long generation;
+    int count;
+    cache* items[BLOCK_POOL_TLS_MAX];
+} ThreadBlockCache;
+
+static __thread ThreadBlockCache threadCaches[BLOCK_POOL_MAX];
+static __thread int threadRegistered = 0;
+
+static BlockPool* registeredPools[BLOCK_POOL_MAX];
+static unsigned long nextGeneration = 1;
+static pthread_mutex_t registryLock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_key_t threadKey;
+static pthread_once_t threadKeyOnce = PTHREAD_ONCE_INIT;
+
+
+// 线程退出时把本线程缓存的空闲记录归还给对应的池
+static void flushThreadCaches(void* unused)
+{
+    (void)unused;
+
+    pthread_mutex_lock(&registryLock);
+    for (int i = 0; i < BLOCK_POOL_MAX; i++)
+    {
+        ThreadBlockCache* tc = &threadCaches[i];
+        BlockPool* pool = registeredPools[i];
+
+        if (pool != NULL && tc->generation == pool->generation && tc->count > 0)
+        {
+            pthread_mutex_lock(&(pool->lock));
+            while (tc->count > 0)
+            {
+                cache* record = tc->items[--tc->count];
+                record->lruNext = pool->freeList;
+                pool->freeList = record;
+                pool->freeCount++;
+            }
+            pthread_mutex_unlock(&(pool->lock));
+        }
+        tc->count = 0;
+    }
+    pthread_mutex_unlock(&registryLock);
+}
+
+static void createThreadKey(void)
+{
+    pthread_key_create(&threadKey, flushThreadCaches);
+}
+
+static ThreadBlockCache* getThreadCache(BlockPool* pool)
+{
+    if (!threadRegistered)
+    {
+        pthread_once(&threadKeyOnce, createThreadKey);
+        pthread_setspecific(threadKey, (void*)1);
+        threadRegistered = 1;
+    }
+
+    ThreadBlockCache* tc = &threadCaches[pool->slot];
+    if (tc->generation != pool->generation)
+    {
+        tc->generation = pool->generation;
+        tc->count = 0;
+    }
+    return tc;
+}
+
+// 调用者需持有 pool->lock
+static int growBlockPool(BlockPool* pool)
+{
+    BlockArena* arena = (BlockArena*)malloc(sizeof(BlockArena));
+    if (arena == NULL)
+    {
+        perror("Failed to allocate block arena");
+        return -1;
+    }
+
+    if (posix_memalign(&(arena->data), BLOCK_POOL_ALIGN, pool->blocksPerArena * pool->blockSize) != 0)
+    {
+        perror("Failed to allocate block arena data");
+        free(arena);
+        return -1;
+    }
+
+    arena->records = (cache*)calloc(pool->blocksPerArena, sizeof(cache));
+    if (arena->records == NULL)
+    {
+        perror("Failed to allocate block arena records");
+        free(arena->data);
+        free(arena);
+        return -1;
+    }
+
+    arena->count = pool->blocksPerArena;
+    arena->ioSlot = registerIoBuffer(arena->data, arena->count * pool->blockSize);
+    for (size_t i = 0; i < arena->count; i++)
+    {
+        cache* record = &(arena->records[i]);
+        record->data = (char*)arena->data + i * pool->blockSize;
+        record->bufferSlot = (unsigned short)arena->ioSlot;
+        record->lruNext = pool->freeList;
+        pool->freeList = record;
+    }
+
+    arena->next = pool->arenas;
+    pool->arenas = arena;
+    pool->totalBlocks += arena->count;
+    pool->freeCount += arena->count;
+    return 0;
+}
+
+
+BlockPool* createBlockPool(size_t blockSize, size_t preallocBlocks)
+{
+    BlockPool* pool = (BlockPool*)calloc(1, sizeof(BlockPool));
+    if (pool == NULL)
+    {
+        perror("Failed to allocate block pool");
+        return NULL;
+    }
+
+    pool->blockSize = blockSize;
+    pool->blocksPerArena = BLOCK_POOL_ARENA_BYTES / blockSize;
+    if (pool->blocksPerArena == 0)
+    {
+        pool->blocksPerArena = 1;
+    }
+    pthread_mutex_init(&(pool->lock), NULL);
+
+    pthread_mutex_lock(&registryLock);
+    pool->slot = -1;
+    for (int i = 0; i < BLOCK_POOL_MAX; i++)
+    {
+        if (registeredPools[i] == NULL)
+        {
+            pool->slot = i;
+            break;
+        }
+    }
+    if (pool->slot < 0)
+    {
+        pthread_mutex_unlock(&registryLock);
+        fprintf(stderr, "Error: Too many block pools\n");
+        pthread_mutex_destroy(&(pool->lock));
+        free(pool);
+        return NULL;
+    }
+    pool->generation = nextGeneration++;
+    registeredPools[pool->slot] = pool;
+    pthread_mutex_unlock(&registryLock);
+
+    pthread_mutex_lock(&(pool->lock));
+    while (pool->totalBlocks < preallocBlocks)
+    {
+        if (growBlockPool(pool) < 0)
+        {
+            break;
+        }
+    }
+    pthread_mutex_unlock(&(pool->lock));
+
+    return pool;
+}
+
+cache* allocBlock(BlockPool* pool)
+{
+    ThreadBlockCache* tc = getThreadCache(pool);
+
+    if (tc->count == 0)
+    {
+        pthread_mutex_lock(&(pool->lock));
+        if (pool->freeCount == 0 && growBlockPool(pool) < 0)
+        {
+            pthread_mutex_unlock(&(pool->lock));
+            return NULL;
+        }
+        while (tc->count < BLOCK_POOL_TLS_BATCH && pool->freeList != NULL)
+        {
+            tc->items[tc->count++] = pool->freeList;
+            pool->freeList = pool->freeList->lruNext;
+            pool->freeCount--;
+        }
+        pthread_mutex_unlock(&(pool->lock));
+    }
+
+    cache* record = tc->items[--tc->count];
+    record->offset = 0;
+    record->flags = 0;
+    record->pins = 0;
+    record->lruPre = record->lruNext = NULL;
+    return record;
+}
+
+void freeBlock(BlockPool* pool, cache* record)
+{
+    if (record == NULL)
+    {
+        return;
+    }
+
+    ThreadBlockCache* tc = getThreadCache(pool);
+
+    if (tc->count == BLOCK_POOL_TLS_MAX)
+    {
+        pthread_mutex_lock(&(pool->lock));
+        while (tc->count > BLOCK_POOL_TLS_MAX - BLOCK_POOL_TLS_BATCH)
+        {
+            cache* spilled = tc->items[--tc->count];
+            spilled->lruNext = pool->freeList;
+            pool->freeList = spilled;
+            pool->freeCount++;
+        }
+        pthread_mutex_unlock(&(pool->lock));
+    }
+
+    tc->items[tc->count++] = record;
+}
+
+void destroyBlockPool(BlockPool* pool)
+{
+    if (pool == NULL)
+    {
+        return;
+    }
+
+    pthread_mutex_lock(&registryLock);
+    registeredPools[pool->slot] = NULL;
+    pthread_mutex_unlock(&registryLock);
+
+    BlockArena* arena = pool->arenas;
+    while (arena != NULL)
+    {
+        BlockArena* next = arena->next;
+        unregisterIoBuffer(arena->ioSlot);
+        free(arena->records);
+        free(arena->data);
+        free(arena);
+        arena = next;
+    }
+
+    pthread_mutex_destroy(&(pool->lock));
+    free(pool);
+}
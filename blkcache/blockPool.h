@@ -0,0 +1,44 @@
+#ifndef BLOCK_POOL_H
+#define BLOCK_POOL_H
+
+#include <stddef.h>
+#include <pthread.h>
+
+struct cache;
+
+#define BLOCK_POOL_MAX 16
+#define BLOCK_POOL_ALIGN 4096
+#define BLOCK_POOL_ARENA_BYTES (4UL << 20)
+#define BLOCK_POOL_TLS_MAX 64
+#define BLOCK_POOL_TLS_BATCH 32
+
+// 一次性分配的一段连续块数据及其定长元数据记录
+typedef struct BlockArena
+{
+    struct BlockArena* next;
+    void* data;
+    struct cache* records;
+    size_t count;
+    unsigned int ioSlot;
+} BlockArena;
+
+typedef struct BlockPool
+{
+    int slot;
+    unsigned long generation;
+    size_t blockSize;
+    size_t blocksPerArena;
+    size_t totalBlocks;
+    size_t freeCount;
+    BlockArena* arenas;
+    struct cache* freeList;
+    pthread_mutex_t lock;
+} BlockPool;
+
+
+BlockPool* createBlockPool(size_t blockSize, size_t preallocBlocks);
+struct cache* allocBlock(BlockPool* pool);
+void freeBlock(BlockPool* pool, struct cache* record);
+void destroyBlockPool(BlockPool* pool);
+
+#endif
@@ -0,0 +1,26 @@
+#ifndef BYPASS_H
+#define BYPASS_H
+
+#include <stddef.h>
+#include <pthread.h>
+#include <sys/types.h>
+
+#include "streamTable.h"
+
+// 大请求与长顺序流不经过缓存，通过 O_DIRECT 旁路 fd 直接读写设备
+typedef struct BypassState
+{
+    int directFd;           // 文件系统不支持 O_DIRECT 时为 -1，退回原 fd
+    size_t blockSize;
+    size_t requestBytes;    // 单次请求达到该值即绕过，0 表示不按大小绕过
+    size_t streamBytes;     // 顺序流累计超过该值后绕过，0 表示不按顺序流绕过
+    StreamTable table;
+    pthread_mutex_t lock;
+} BypassState;
+
+
+BypassState* createBypass(const char* pathname, int flags, size_t blockSize, size_t requestBytes, size_t streamBytes);
+int shouldBypass(BypassState* bp, off_t offset, size_t count);
+void destroyBypass(BypassState* bp);
+
+#endif
@@ -0,0 +1,540 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <limits.h>
+#include <pthread.h>
+#include <sys/eventfd.h>
+
+#include "cacheAsync.h"
+#include "cacheIOHandler.h"
+#include "singleCacheHandler.h"
+#include "hashTable.h"
+#include "flusher.h"
+#include "ioEngine.h"
+
+typedef struct CacheAsyncRequest
+{
+    int fd;
+    int isWrite;
+    int isPrefetch;             // 预读请求没有回调，读入缓存即完成
+    void* buf;
+    size_t count;
+    off_t offset;
+    size_t served;              // 提交前已从缓存复制的字节数，本请求只负责其后的部分
+    HashTableFdNode* node;      // asyncPending 未归零前节点不会被释放
+    off_t scanOffset;           // 下一批未命中检查的起点
+    off_t scanEnd;
+    MissBatch* batch;
+    ssize_t result;
+    CacheIOCallback callback;
+    void* arg;
+    struct CacheAsyncRequest* next;
+} CacheAsyncRequest;
+
+typedef struct CacheAsyncQueue
+{
+    CacheAsyncRequest* head;
+    CacheAsyncRequest* tail;
+} CacheAsyncQueue;
+
+// asyncLock 保护两个队列、各节点的 asyncPending 与后台线程状态
+static pthread_mutex_t asyncLock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t asyncWorkCond = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t asyncIdleCond = PTHREAD_COND_INITIALIZER;
+static CacheAsyncQueue workQueue;
+static CacheAsyncQueue doneQueue;
+static unsigned int workerCount = 0;       // 正在运行的后台线程
+static unsigned int workerTarget = CACHE_ASYNC_DEFAULT_WORKERS;
+static int completionFd = -1;
+
+
+static void pushAsyncRequest(CacheAsyncQueue* queue, CacheAsyncRequest* request)
+{
+    request->next = NULL;
+    if (queue->tail != NULL)
+    {
+        queue->tail->next = request;
+    }
+    else
+    {
+        queue->head = request;
+    }
+    queue->tail = request;
+}
+
+static CacheAsyncRequest* popAsyncRequest(CacheAsyncQueue* queue)
+{
+    CacheAsyncRequest* request = queue->head;
+    if (request != NULL)
+    {
+        queue->head = request->next;
+        if (queue->head == NULL)
+        {
+            queue->tail = NULL;
+        }
+    }
+    return request;
+}
+
+static void signalCompletionFd(void)
+{
+    uint64_t one = 1;
+    if (write(completionFd, &one, sizeof(one)) < 0 && errno != EAGAIN)
+    {
+        perror("Failed to signal completion eventfd");
+    }
+}
+
+// 先让 fd 可以关闭，再通知调用者，回调里关闭该 fd 也不会死锁
+static void finishAsyncRequest(CacheAsyncRequest* request)
+{
+    pthread_mutex_lock(&asyncLock);
+    if (--request->node->asyncPending == 0)
+    {
+        pthread_cond_broadcast(&asyncIdleCond);
+    }
+
+    if (request->isPrefetch)
+    {
+        pthread_mutex_unlock(&asyncLock);
+        free(request);
+        return;
+    }
+    if (completionFd >= 0)
+    {
+        pushAsyncRequest(&doneQueue, request);
+        pthread_mutex_unlock(&asyncLock);
+        signalCompletionFd();
+        return;
+    }
+    pthread_mutex_unlock(&asyncLock);
+
+    request->callback(request->fd, request->result, request->arg);
+    free(request);
+}
+
+static void runAsyncRequest(CacheAsyncRequest* request)
+{
+    if (request->isPrefetch)
+    {
+        if (acquireFdNode(request->fd) != NULL)
+        {
+            prefetchHostCache(request->fd, request->offset, request->count);
+            releaseFdNode();
+        }
+        finishAsyncRequest(request);
+        return;
+    }
+
+    request->result = request->isWrite ? writeWithCache(request->fd, request->buf, request->count, request->offset)
+                                       : readWithCache(request->fd, request->buf, request->count, request->offset);
+    if (request->served > 0)
+    {
+        request->result = (request->result < 0) ? (ssize_t)request->served : request->result + (ssize_t)request->served;
+    }
+    finishAsyncRequest(request);
+}
+
+static void* asyncWorkerMain(void* unused)
+{
+    (void)unused;
+
+    pthread_mutex_lock(&asyncLock);
+    while (1)
+    {
+        // 线程数调小后多出的线程在空闲时退出
+        if (workerCount > workerTarget)
+        {
+            workerCount--;
+            break;
+        }
+        CacheAsyncRequest* request = popAsyncRequest(&workQueue);
+        if (request == NULL)
+        {
+            pthread_cond_wait(&asyncWorkCond, &asyncLock);
+            continue;
+        }
+        pthread_mutex_unlock(&asyncLock);
+        runAsyncRequest(request);
+        pthread_mutex_lock(&asyncLock);
+    }
+    pthread_mutex_unlock(&asyncLock);
+    return NULL;
+}
+
+// 调用者持有 asyncLock；后台线程在第一次需要时创建，补足到 workerTarget 个
+static int startAsyncWorkers(void)
+{
+    while (workerCount < workerTarget)
+    {
+        pthread_t thread;
+        int ret = pthread_create(&thread, NULL, asyncWorkerMain, NULL);
+        if (ret != 0)
+        {
+            fprintf(stderr, "Error: Failed to create cache async worker: %s\n", strerror(ret));
+            // 不再反复重试，按已有的线程数运行
+            workerTarget = workerCount;
+            break;
+        }
+        pthread_detach(thread);
+        workerCount++;
+    }
+    return (workerCount > 0) ? 0 : -1;
+}
+
+int setCacheAsyncWorkers(unsigned int count)
+{
+    if (count == 0)
+    {
+        count = CACHE_ASYNC_DEFAULT_WORKERS;
+    }
+    if (count > CACHE_ASYNC_MAX_WORKERS)
+    {
+        count = CACHE_ASYNC_MAX_WORKERS;
+    }
+
+    pthread_mutex_lock(&asyncLock);
+    workerTarget = count;
+    int ret = 0;
+    if (workerCount > 0)
+    {
+        ret = startAsyncWorkers();
+        pthread_cond_broadcast(&asyncWorkCond);
+    }
+    pthread_mutex_unlock(&asyncLock);
+    return ret;
+}
+
+// 调用者持有 fdTableLock 读锁
+static CacheAsyncRequest* createAsyncRequest(HashTableFdNode* node, int isWrite, void* buf, size_t count, off_t offset,
+                                             CacheIOCallback callback, void* arg)
+{
+    CacheAsyncRequest* request = (CacheAsyncRequest*)calloc(1, sizeof(CacheAsyncRequest));
+    if (request == NULL)
+    {
+        perror("Failed to allocate async request");
+        return NULL;
+    }
+
+    request->fd = node->fd;
+    request->isWrite = isWrite;
+    request->buf = buf;
+    request->count = count;
+    request->offset = offset;
+    request->node = node;
+    request->callback = callback;
+    request->arg = arg;
+
+    pthread_mutex_lock(&asyncLock);
+    node->asyncPending++;
+    pthread_mutex_unlock(&asyncLock);
+    return request;
+}
+
+// 调用者持有 fdTableLock 读锁，释放读锁后请求由后台线程执行
+static ssize_t queueAsyncRequest(CacheAsyncRequest* request)
+{
+    pthread_mutex_lock(&asyncLock);
+    if (startAsyncWorkers() < 0)
+    {
+        request->node->asyncPending--;
+        pthread_mutex_unlock(&asyncLock);
+        free(request);
+        return -1;
+    }
+    pushAsyncRequest(&workQueue, request);
+    pthread_cond_signal(&asyncWorkCond);
+    pthread_mutex_unlock(&asyncLock);
+    return CACHE_ASYNC_PENDING;
+}
+
+// 调用者持有 fdTableLock 读锁
+static int isRangeResident(CacheSet* set, off_t offset, size_t count)
+{
+    off_t end = offset + (off_t)count;
+    for (off_t pos = ROUND_DOWN_TO_BLOCK(offset, set->blockSize); pos < end; pos += (off_t)set->blockSize)
+    {
+        if (!isCacheResident(set, pos))
+        {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+static void asyncReadDone(void* arg);
+
+// 调用者持有 fdTableLock 读锁；为 scanOffset 之后的下一批未命中块提交读请求，
+// 已没有未命中块时返回 0，由调用者完成复制
+static int submitAsyncMisses(CacheAsyncRequest* request)
+{
+    size_t blockSize = request->node->set->blockSize;
+
+    while (request->scanOffset < request->scanEnd)
+    {
+        off_t blocks = MIN((request->scanEnd - request->scanOffset) / (off_t)blockSize, (off_t)INT_MAX);
+        int covered = 0;
+        unsigned int flags = request->isPrefetch ? CACHE_FLAG_READAHEAD : CACHE_FLAG_FRESH;
+        int missing = prepareMissBatch(request->fd, request->scanOffset, (int)blocks, flags, &covered, &(request->batch));
+        request->scanOffset += (off_t)covered * (off_t)blockSize;
+        if (missing < 0)
+        {
+            return -1;
+        }
+        if (missing == 0)
+        {
+            continue;
+        }
+
+        if (submitIoAsync(request->batch->requests, request->batch->requestCount, asyncReadDone, request) < 0)
+        {
+            if (request->isPrefetch)
+            {
+                // 引擎已停止，预读不值得同步等待，直接放弃
+                discardMissBatch(request->batch);
+                request->batch = NULL;
+                return 0;
+            }
+            // 引擎已停止，这一批改为同步读
+            submitIoBatch(request->batch->requests, request->batch->requestCount);
+            completeMissBatch(request->batch);
+            request->batch = NULL;
+            continue;
+        }
+        return 1;
+    }
+    return 0;
+}
+
+// 在 I/O 引擎的完成线程中执行，复制与用户回调交给后台线程，完成线程只负责装入缓存和提交下一批
+static void asyncReadDone(void* arg)
+{
+    CacheAsyncRequest* request = (CacheAsyncRequest*)arg;
+
+    lockFdTableShared();
+    int filled = completeMissBatch(request->batch);
+    request->batch = NULL;
+    if (request->isPrefetch && filled > 0 && request->node->ra != NULL)
+    {
+        noteReadaheadPrefetched(request->node->ra, (unsigned long)filled);
+    }
+    int submitted = submitAsyncMisses(request);
+    unlockFdTableShared();
+
+    if (submitted <= 0 && request->isPrefetch)
+    {
+        finishAsyncRequest(request);
+    }
+    else if (submitted <= 0)
+    {
+        // 未命中块都已读入，复制过程中少数被淘汰的块由同步路径补读
+        pthread_mutex_lock(&asyncLock);
+        int ret = startAsyncWorkers();
+        if (ret == 0)
+        {
+            pushAsyncRequest(&workQueue, request);
+            pthread_cond_signal(&asyncWorkCond);
+        }
+        pthread_mutex_unlock(&asyncLock);
+        if (ret < 0)
+        {
+            runAsyncRequest(request);
+        }
+    }
+}
+
+
+void prefetchHostCacheAsync(int fd, off_t offset, size_t length)
+{
+    HashTableFdNode* node = findFdNode(fd);
+    CacheSet* set = node->set;
+
+    length = limitPrefetchBytes(set, length);
+    CacheAsyncRequest* request = createAsyncRequest(node, 0, NULL, length, offset, NULL, NULL);
+    if (request == NULL)
+    {
+        return;
+    }
+    request->isPrefetch = 1;
+
+    if (!isIoEngineRunning())
+    {
+        queueAsyncRequest(request);
+        return;
+    }
+
+    request->scanOffset = ROUND_DOWN_TO_BLOCK(offset, set->blockSize);
+    request->scanEnd = ROUND_UP_TO_BLOCK(offset + (off_t)length, set->blockSize);
+    if (submitAsyncMisses(request) <= 0)
+    {
+        finishAsyncRequest(request);
+    }
+}
+
+ssize_t readWithCacheAsync(int fd, void* buf, size_t count, off_t offset, CacheIOCallback callback, void* arg)
+{
+    if (callback == NULL)
+    {
+        fprintf(stderr, "Error: Async read requires a callback\n");
+        return -1;
+    }
+
+    // 驻留的部分在分片锁下一次复制完，途中遇到未驻留的块就把其余部分作为异步请求，
+    // 调用者线程上不会读设备
+    ssize_t served = readResidentWithCache(fd, buf, count, offset);
+    if (served < 0 || (size_t)served == count)
+    {
+        return served;
+    }
+    buf = (char*)buf + served;
+    count -= (size_t)served;
+    offset += (off_t)served;
+
+    HashTableFdNode* node = acquireFdNode(fd);
+    if (node == NULL)
+    {
+        fprintf(stderr, "Error: Failed to find FD node in hash table\n");
+        return -1;
+    }
+
+    CacheAsyncRequest* request = createAsyncRequest(node, 0, buf, count, offset, callback, arg);
+    if (request == NULL)
+    {
+        releaseFdNode();
+        return -1;
+    }
+    request->served = (size_t)served;
+
+    // 会绕过缓存的大请求不必把未命中块读进缓存
+    int bypass = node->bypass != NULL && node->bypass->requestBytes != 0 && count >= node->bypass->requestBytes;
+    if (node->cacheType != CACHE_TYPE_HOST || !isIoEngineRunning() || bypass)
+    {
+        ssize_t ret = queueAsyncRequest(request);
+        releaseFdNode();
+        return ret;
+    }
+
+    request->scanOffset = ROUND_DOWN_TO_BLOCK(offset, node->set->blockSize);
+    request->scanEnd = ROUND_UP_TO_BLOCK(offset + (off_t)count, node->set->blockSize);
+    int submitted = submitAsyncMisses(request);
+    if (submitted <= 0)
+    {
+        // 扫描期间未命中块已被其他线程读入，或分配失败，交给后台线程走同步路径
+        ssize_t ret = queueAsyncRequest(request);
+        releaseFdNode();
+        return ret;
+    }
+    releaseFdNode();
+    return CACHE_ASYNC_PENDING;
+}
+
+ssize_t writeWithCacheAsync(int fd, const void* buf, size_t count, off_t offset, CacheIOCallback callback, void* arg)
+{
+    if (callback == NULL)
+    {
+        fprintf(stderr, "Error: Async write requires a callback\n");
+        return -1;
+    }
+
+    HashTableFdNode* node = acquireFdNode(fd);
+    if (node == NULL)
+    {
+        fprintf(stderr, "Error: Failed to find FD node in hash table\n");
+        return -1;
+    }
+
+    // 写回模式下全部命中且不会被回写节流时只是内存复制
+    if (node->cacheType == CACHE_TYPE_HOST && node->set->writePolicy == CACHE_WRITE_BACK && !isDirtyThrottled() &&
+        isRangeResident(node->set, offset, count))
+    {
+        releaseFdNode();
+        return writeWithCache(fd, buf, count, offset);
+    }
+
+    CacheAsyncRequest* request = createAsyncRequest(node, 1, (void*)buf, count, offset, callback, arg);
+    ssize_t ret = (request != NULL) ? queueAsyncRequest(request) : -1;
+    releaseFdNode();
+    return ret;
+}
+
+int getCacheCompletionFd(void)
+{
+    pthread_mutex_lock(&asyncLock);
+    if (completionFd < 0)
+    {
+        completionFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        if (completionFd < 0)
+        {
+            perror("Failed to create completion eventfd");
+        }
+    }
+    int fd = completionFd;
+    pthread_mutex_unlock(&asyncLock);
+    return fd;
+}
+
+int reapCacheCompletions(int max)
+{
+    uint64_t value;
+    CacheAsyncQueue ready = {NULL, NULL};
+    int reaped = 0;
+
+    if (completionFd < 0)
+    {
+        return 0;
+    }
+    if (read(completionFd, &value, sizeof(value)) < 0 && errno != EAGAIN)
+    {
+        perror("Failed to read completion eventfd");
+    }
+
+    pthread_mutex_lock(&asyncLock);
+    while (max <= 0 || reaped < max)
+    {
+        CacheAsyncRequest* request = popAsyncRequest(&doneQueue);
+        if (request == NULL)
+        {
+            break;
+        }
+        pushAsyncRequest(&ready, request);
+        reaped++;
+    }
+    int remaining = (doneQueue.head != NULL);
+    pthread_mutex_unlock(&asyncLock);
+
+    // 没取完的留到下一次，重新让 eventfd 可读
+    if (remaining)
+    {
+        signalCompletionFd();
+    }
+
+    CacheAsyncRequest* request;
+    while ((request = popAsyncRequest(&ready)) != NULL)
+    {
+        request->callback(request->fd, request->result, request->arg);
+        free(request);
+    }
+    return reaped;
+}
+
+// 等待时不能持有 fdTableLock 读锁：完成线程要取读锁，而它可能排在等待中的写者后面。
+// 节点只在关闭时释放，调用者就是关闭它的线程，释放读锁后节点仍然有效
+void waitCacheAsyncIdle(int fd)
+{
+    HashTableFdNode* node = acquireFdNode(fd);
+    if (node == NULL)
+    {
+        return;
+    }
+    releaseFdNode();
+
+    pthread_mutex_lock(&asyncLock);
+    while (node->asyncPending > 0)
+    {
+        pthread_cond_wait(&asyncIdleCond, &asyncLock);
+    }
+    pthread_mutex_unlock(&asyncLock);
+}
@@ -0,0 +1,35 @@
+#ifndef CACHE_ASYNC_H
+#define CACHE_ASYNC_H
+
+#include <sys/types.h>
+
+#define CACHE_ASYNC_PENDING (-2)
+#define CACHE_ASYNC_DEFAULT_WORKERS 4
+#define CACHE_ASYNC_MAX_WORKERS 256
+
+// 异步请求完成时的回调，result 与同步接口的返回值含义相同
+typedef void (*CacheIOCallback)(int fd, ssize_t result, void* arg);
+
+// 全部命中时同步完成并返回字节数，不再调用回调；否则返回 CACHE_ASYNC_PENDING，完成后调用回调；
+// 出错返回 -1。I/O 引擎运行时读未命中直接提交给 io_uring，其余情况交给后台线程执行同步路径。
+// 请求完成前 buf 必须保持有效，请求未完成的 fd 在关闭时会等待它们
+ssize_t readWithCacheAsync(int fd, void* buf, size_t count, off_t offset, CacheIOCallback callback, void* arg);
+ssize_t writeWithCacheAsync(int fd, const void* buf, size_t count, off_t offset, CacheIOCallback callback, void* arg);
+
+// 调用者持有 fdTableLock 读锁。发起预读后立即返回：I/O 引擎运行时直接提交给 io_uring，否则交给后台线程；
+// 预读完成前关闭 fd 会等待它
+void prefetchHostCacheAsync(int fd, off_t offset, size_t length);
+
+// 调用 getCacheCompletionFd 之后，回调不再在内部线程中执行，而是排队并通知返回的 eventfd，
+// 由调用者在 eventfd 可读时调用 reapCacheCompletions 执行；max 为 0 时执行全部
+int getCacheCompletionFd(void);
+int reapCacheCompletions(int max);
+
+// 设置执行同步路径与异步读复制的后台线程数，0 使用默认值；线程已启动时立即增减，空闲线程随后退出。
+// 引擎未运行时线程数就是同时执行同步路径的异步请求数，应不少于期望的并发未命中数
+int setCacheAsyncWorkers(unsigned int count);
+
+// 供关闭 fd 时调用，调用者不持有 fdTableLock
+void waitCacheAsyncIdle(int fd);
+
+#endif
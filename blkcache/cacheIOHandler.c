@@ -2,18 +2,91 @@
 #include <fcntl.h>
 #include <stdlib.h>
 #include <unistd.h>
+#include <errno.h>
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <string.h>
+#include <stdint.h>
+#include <limits.h>
 #include <pthread.h>
+#include <sys/ioctl.h>
+#include <sys/uio.h>
+#include <linux/fs.h>
 
 #include "singleCacheHandler.h"
 #include "hashTable.h"
 #include "cacheIOHandler.h"
+#include "flusher.h"
+#include "cacheAsync.h"
+#include "cacheTrace.h"
 
+// 保护各节点的 warmup 字段：预热可以在持 fdTableLock 读锁时启动或取下
+static pthread_mutex_t warmupLock = PTHREAD_MUTEX_INITIALIZER;
 
+// 块大小需与底层设备的逻辑/物理块大小匹配
+static size_t resolveBlockSize(int fd, size_t requested)
+{
+    size_t logicalSize = 512;
+    size_t preferredSize = CACHE_DEFAULT_BLOCK_SIZE;
+    struct stat st;
+
+    if (fstat(fd, &st) == 0)
+    {
+        if (S_ISBLK(st.st_mode))
+        {
+            int logical = 0;
+            unsigned int physical = 0;
+            if (ioctl(fd, BLKSSZGET, &logical) == 0 && logical > 0)
+            {
+                logicalSize = (size_t)logical;
+            }
+            if (ioctl(fd, BLKPBSZGET, &physical) == 0 && IS_POWER_OF_TWO(physical))
+            {
+                preferredSize = MAX(preferredSize, (size_t)physical);
+            }
+        }
+        else if (IS_POWER_OF_TWO((size_t)st.st_blksize))
+        {
+            preferredSize = MAX(preferredSize, (size_t)st.st_blksize);
+        }
+    }
+    preferredSize = MIN(preferredSize, CACHE_MAX_BLOCK_SIZE);
+
+    if (requested == 0)
+    {
+        return preferredSize;
+    }
+
+    if (!IS_POWER_OF_TWO(requested) || requested < CACHE_MIN_BLOCK_SIZE ||
+        requested > CACHE_MAX_BLOCK_SIZE || requested % logicalSize != 0)
+    {
+        fprintf(stderr, "Error: Invalid cache block size %zu (device logical block size %zu)\n", requested, logicalSize);
+        return 0;
+    }
+    return requested;
+}
+
+static off_t getOriginSize(int fd)
+{
+    struct stat st;
+    if (fstat(fd, &st) < 0)
+    {
+        return 0;
+    }
+
+    if (S_ISBLK(st.st_mode))
+    {
+        unsigned long long bytes = 0;
+        if (ioctl(fd, BLKGETSIZE64, &bytes) == 0)
+        {
+            return (off_t)bytes;
+        }
+    }
+    return st.st_size;
+}
 
-int openWithCache(const char *pathname, int flags, mode_t mode ,int cacheType)
+// 调用者持有 fdTableLock 写锁
+static int openWithCacheLocked(const char *pathname, int flags, mode_t mode ,int cacheType, const CacheOptions* options)
 {
     if (pathname == NULL) 
     {
@@ -38,21 +111,110 @@ int openWithCache(const char *pathname, int flags, mode_t mode ,int cacheType)
         return -1;
     }
 
-    LRUHash* Hash = createHash();
-    if (Hash == NULL) 
+    size_t blockSize = resolveBlockSize(fd, options != NULL ? options->blockSize : 0);
+    if (blockSize == 0)
+    {
+        close(fd);
+        return -1;
+    }
+
+    int writeMissPolicy = (options != NULL) ? options->writeMissPolicy : CACHE_WRITE_ALLOCATE;
+    if (writeMissPolicy != CACHE_WRITE_ALLOCATE && writeMissPolicy != CACHE_WRITE_NO_ALLOCATE)
+    {
+        fprintf(stderr, "Error: Invalid write miss policy %d\n", writeMissPolicy);
+        close(fd);
+        return -1;
+    }
+
+    int writePolicy = (options != NULL) ? options->writePolicy : CACHE_WRITE_BACK;
+    if (writePolicy != CACHE_WRITE_BACK && writePolicy != CACHE_WRITE_THROUGH && writePolicy != CACHE_WRITE_AROUND)
+    {
+        fprintf(stderr, "Error: Invalid write policy %d\n", writePolicy);
+        close(fd);
+        return -1;
+    }
+
+    size_t tierBytes = (options != NULL && cacheType == CACHE_TYPE_DEVICE) ? options->deviceTierBytes : 0;
+    int tierPolicy = (options != NULL) ? options->deviceTierPolicy : CACHE_POLICY_LRU;
+    if (tierBytes != 0 && (tierBytes < blockSize || tierPolicy < 0 || tierPolicy >= CACHE_POLICY_COUNT))
+    {
+        fprintf(stderr, "Error: Invalid device tier capacity %zu or policy %d\n", tierBytes, tierPolicy);
+        close(fd);
+        return -1;
+    }
+    off_t tierMetaOffset = (tierBytes != 0) ? options->deviceTierMetaOffset : 0;
+    if (tierMetaOffset < 0 || tierMetaOffset % (off_t)MAX(blockSize, TIER_META_PAGE) != 0)
+    {
+        fprintf(stderr, "Error: Device tier metadata offset %lld is not block aligned\n", (long long)tierMetaOffset);
+        close(fd);
+        return -1;
+    }
+
+    BlockPool* pool = getBlockPoolForSize(blockSize);
+    if (pool == NULL)
+    {
+        fprintf(stderr, "Error: Failed to get block pool\n");
+        close(fd);
+        return -1;
+    }
+
+    size_t maxIOBytes = (options != NULL && options->maxIOBytes != 0) ? options->maxIOBytes : CACHE_MAX_IO_BYTES;
+    CacheSet* set = createCacheSet(pool, blockSize, options != NULL ? options->capacityBytes : 0, maxIOBytes,
+                                   options != NULL ? options->shardCount : 0,
+                                   options != NULL ? options->policy : CACHE_POLICY_LRU);
+    if (set == NULL) 
     {
-        fprintf(stderr, "Error: Failed to create LRUHash\n");
+        fprintf(stderr, "Error: Failed to create cache set\n");
         close(fd);
         return -1;
     }
 
-    AVLTreeNode* root = NULL;
-    createAndInsertFdNode(fd, Hash, root, cacheType);
-  
+    set->writeMissPolicy = writeMissPolicy;
+    set->writePolicy = writePolicy;
+
+    HashTableFdNode* hashTableFdNode = createAndInsertFdNode(fd, set, cacheType);
+
+    size_t readaheadBytes = (options != NULL) ? options->readaheadBytes : 0;
+    if (cacheType == CACHE_TYPE_HOST && readaheadBytes != CACHE_READAHEAD_DISABLED)
+    {
+        hashTableFdNode->ra = createReadahead(blockSize, readaheadBytes != 0 ? readaheadBytes : READAHEAD_DEFAULT_MAX_WINDOW, getOriginSize(fd));
+    }
+
+    if (cacheType == CACHE_TYPE_HOST && options != NULL && (options->bypassBytes != 0 || options->bypassStreamBytes != 0))
+    {
+        hashTableFdNode->bypass = createBypass(pathname, flags, blockSize, options->bypassBytes, options->bypassStreamBytes);
+    }
+
+    if (tierBytes != 0)
+    {
+        // 元数据恢复失败时不能忽略分区上可能存在的脏块，打开失败
+        hashTableFdNode->tier = createDeviceTier(fd, &(hashTableFdNode->ioLock), blockSize, tierBytes, tierPolicy,
+                                                 tierMetaOffset);
+        if (hashTableFdNode->tier == NULL)
+        {
+            cleanUpCache(set);
+            hashTableFdNode->set = NULL;
+            deleteFdNode(fd);
+            close(fd);
+            return -1;
+        }
+    }
+
+    if (cacheType == CACHE_TYPE_HOST && options != NULL && options->hotSetPath != NULL)
+    {
+        hashTableFdNode->hotSetPath = strdup(options->hotSetPath);
+        if (hashTableFdNode->hotSetPath != NULL && options->hotSetWarmup)
+        {
+            hashTableFdNode->warmup = startHotSetWarmup(fd, hashTableFdNode->hotSetPath, blockSize, options->hotSetWarmupRate);
+        }
+    }
+
+    TRACE_CACHE_ACCESS(fd, CACHE_TRACE_OPEN, getOriginSize(fd), blockSize, getMonotonicNs());
     return fd;
 }
 
-int closeWithCache(int fd)
+// 调用者持有 fdTableLock 写锁，此时没有其他线程在读写或回写该 fd
+static int closeWithCacheLocked(int fd)
 {
     if (fd < 0) 
     {
@@ -67,6 +229,11 @@ int closeWithCache(int fd)
         return -1;
     }
 
+    TRACE_CACHE_ACCESS(fd, CACHE_TRACE_CLOSE, 0, 0, getMonotonicNs());
+    if (hashTableFdNode->hotSetPath != NULL)
+    {
+        saveHotSet(hashTableFdNode->set, hashTableFdNode->hotSetPath);
+    }
     writeBackAndCleanUpCache(fd);
    
     int deleteResult = deleteFdNode(fd);
@@ -90,102 +257,1002 @@ int closeWithCache(int fd)
     return result;
 }
 
-ssize_t readWithCache(int fd, void *buf, size_t count, off_t offset)
+// 在调用者的 iovec 数组上顺序前进；一段数据落在同一个 iovec 内时直接使用其内存，
+// 跨越多个 iovec 时经由 bounce 缓冲区分散或收集
+typedef struct IovCursor
+{
+    const struct iovec* iov;
+    int iovcnt;
+    int index;
+    size_t offset;      // 在 iov[index] 内的偏移
+    void* bounce;       // 一个缓存块大小，第一次需要时分配
+} IovCursor;
+
+// 前进 count 字节，并跳过已用完或长度为 0 的 iovec
+static void advanceIovCursor(IovCursor* cursor, size_t count)
+{
+    while (cursor->index < cursor->iovcnt)
+    {
+        size_t step = MIN(cursor->iov[cursor->index].iov_len - cursor->offset, count);
+        cursor->offset += step;
+        count -= step;
+        if (cursor->offset < cursor->iov[cursor->index].iov_len)
+        {
+            break;
+        }
+        cursor->index++;
+        cursor->offset = 0;
+    }
+}
+
+static void initIovCursor(IovCursor* cursor, const struct iovec* iov, int iovcnt)
+{
+    cursor->iov = iov;
+    cursor->iovcnt = iovcnt;
+    cursor->index = 0;
+    cursor->offset = 0;
+    cursor->bounce = NULL;
+    advanceIovCursor(cursor, 0);
+}
+
+// 接下来的 count 字节在同一个 iovec 内时返回其地址，否则返回 bounce 缓冲区
+static void* getIovCursorSpan(IovCursor* cursor, size_t count, size_t blockSize)
+{
+    if (cursor->index < cursor->iovcnt && cursor->iov[cursor->index].iov_len - cursor->offset >= count)
+    {
+        return (char*)cursor->iov[cursor->index].iov_base + cursor->offset;
+    }
+
+    if (cursor->bounce == NULL)
+    {
+        cursor->bounce = malloc(blockSize);
+        if (cursor->bounce == NULL)
+        {
+            perror("Failed to allocate bounce buffer");
+        }
+    }
+    return cursor->bounce;
+}
+
+// 接下来的 count 字节在同一个 iovec 内且地址按 alignment 对齐时返回其地址，否则返回 NULL
+static void* getIovCursorAligned(IovCursor* cursor, size_t count, size_t alignment)
+{
+    if (cursor->index < cursor->iovcnt && cursor->iov[cursor->index].iov_len - cursor->offset >= count)
+    {
+        char* base = (char*)cursor->iov[cursor->index].iov_base + cursor->offset;
+        if (((uintptr_t)base & (alignment - 1)) == 0)
+        {
+            return base;
+        }
+    }
+    return NULL;
+}
+
+static void copyToIovCursor(IovCursor* cursor, const void* src, size_t count)
+{
+    const char* from = (const char*)src;
+    while (count > 0 && cursor->index < cursor->iovcnt)
+    {
+        size_t step = MIN(cursor->iov[cursor->index].iov_len - cursor->offset, count);
+        memcpy((char*)cursor->iov[cursor->index].iov_base + cursor->offset, from, step);
+        from += step;
+        count -= step;
+        advanceIovCursor(cursor, step);
+    }
+}
+
+static void copyFromIovCursor(IovCursor* cursor, void* dst, size_t count)
+{
+    char* to = (char*)dst;
+    while (count > 0 && cursor->index < cursor->iovcnt)
+    {
+        size_t step = MIN(cursor->iov[cursor->index].iov_len - cursor->offset, count);
+        memcpy(to, (const char*)cursor->iov[cursor->index].iov_base + cursor->offset, step);
+        to += step;
+        count -= step;
+        advanceIovCursor(cursor, step);
+    }
+}
+
+// 读：数据已放入 span，若 span 是 bounce 缓冲区则分散到各 iovec
+static void finishIovCursorRead(IovCursor* cursor, const void* span, size_t count)
+{
+    if (span != cursor->bounce)
+    {
+        advanceIovCursor(cursor, count);
+        return;
+    }
+    copyToIovCursor(cursor, span, count);
+}
+
+// 写：返回接下来 count 字节的连续副本（或原地址），并前进游标
+static const void* takeIovCursorWrite(IovCursor* cursor, size_t count, size_t blockSize)
+{
+    void* span = getIovCursorSpan(cursor, count, blockSize);
+    if (span == NULL || span != cursor->bounce)
+    {
+        advanceIovCursor(cursor, count);
+        return span;
+    }
+    copyFromIovCursor(cursor, span, count);
+    return span;
+}
+
+static ssize_t getIovTotalLength(const struct iovec* iov, int iovcnt)
+{
+    if (iovcnt < 0 || (iov == NULL && iovcnt > 0))
+    {
+        fprintf(stderr, "Error: Invalid iovec array\n");
+        return -1;
+    }
+
+    size_t total = 0;
+    for (int i = 0; i < iovcnt; i++)
+    {
+        if (iov[i].iov_len > (size_t)SSIZE_MAX - total)
+        {
+            fprintf(stderr, "Error: Total iovec length overflows\n");
+            return -1;
+        }
+        total += iov[i].iov_len;
+    }
+    return (ssize_t)total;
+}
+
+// 调用者持有 fdTableLock 读锁；offset 起的 count 字节位于同一个缓存块内，写入设备失败时返回 -1
+static int writeCacheBlock(HashTableFdNode* hashTableFdNode, const void* buf, off_t offset, size_t count)
+{
+    CacheSet* set = hashTableFdNode->set;
+    int fd = hashTableFdNode->fd;
+    off_t alignedOffset = ROUND_DOWN_TO_BLOCK(offset, set->blockSize);
+    off_t offsetInCache = offset - alignedOffset;
+
+    if (hashTableFdNode->cacheType == CACHE_TYPE_HOST && set->writePolicy != CACHE_WRITE_BACK)
+    {
+        return writeHostThrough(fd, buf, offset, count, set->writePolicy == CACHE_WRITE_THROUGH);
+    }
+
+    CacheShard* shard = lockCacheShard(set, alignedOffset);
+    cache* cache = findCache(set, alignedOffset);
+
+    if(hashTableFdNode->cacheType == CACHE_TYPE_HOST)
+    {
+        if(cache != NULL)
+        {
+            cache->flags &= ~(CACHE_FLAG_READAHEAD | CACHE_FLAG_FRESH);
+            writeHostWithCache(set, cache, buf, offsetInCache, count);
+            unlockCacheShard(shard);
+        }
+        else
+        {
+            unlockCacheShard(shard);
+            return writeHostWithoutCache(fd, buf, offset, count);
+        }
+    }
+    else
+    {
+        if(cache == NULL)
+        {
+            unlockCacheShard(shard);
+            cache = loadDevBlock(fd, alignedOffset, count != set->blockSize, &shard);
+            if (cache == NULL)
+            {
+                return -1;
+            }
+        }
+        writeHostWithCache(set, cache, buf, offsetInCache, count);
+        unlockCacheShard(shard);
+    }
+    return 0;
+}
+
+// 旁路读写一段对齐的区间。O_DIRECT 下短读只发生在文件末尾，不再续读（续读的偏移不对齐）；
+// 文件系统在 I/O 时才拒绝 O_DIRECT 的，改用原 fd
+static ssize_t transferBypass(HashTableFdNode* hashTableFdNode, int isWrite, void* buf, size_t length, off_t offset)
+{
+    int fd = (hashTableFdNode->bypass->directFd >= 0) ? hashTableFdNode->bypass->directFd : hashTableFdNode->fd;
+    size_t done = 0;
+
+    while (done < length)
+    {
+        ssize_t n = isWrite ? pwrite(fd, (char*)buf + done, length - done, offset + (off_t)done)
+                            : pread(fd, (char*)buf + done, length - done, offset + (off_t)done);
+        if (n < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            if (errno == EINVAL && fd != hashTableFdNode->fd)
+            {
+                fd = hashTableFdNode->fd;
+                continue;
+            }
+            perror("Bypass I/O failed");
+            return (done > 0) ? (ssize_t)done : -1;
+        }
+        done += (size_t)n;
+        if (!isWrite && (n == 0 || done < length))
+        {
+            break;
+        }
+    }
+
+    CacheShard* shard = CACHE_SHARD_OF(hashTableFdNode->set, offset);
+    if (isWrite && done > 0)
+    {
+        noteDeviceWrite(hashTableFdNode->set, offset, done);
+    }
+    ATOMIC_ADD(isWrite ? &(shard->stats.deviceWriteBytes) : &(shard->stats.deviceReadBytes), done);
+    ATOMIC_ADD(&(shard->stats.bypassBytes), done);
+    return (ssize_t)done;
+}
+
+// 调用者持有 fdTableLock 读锁；用 [pos, pos+length) 内驻留的块覆盖 buf，缓存中的数据总是最新的
+static void overlayResidentBlocks(CacheSet* set, char* buf, off_t pos, size_t length)
 {
+    if (ATOMIC_LOAD(&(set->residentBytes)) == 0)
+    {
+        return;
+    }
+
+    for (size_t done = 0; done < length; done += set->blockSize)
+    {
+        CacheShard* shard = lockCacheShardShared(set, pos + (off_t)done);
+        cache* cache = findCache(set, pos + (off_t)done);
+        if (cache != NULL)
+        {
+            memcpy(buf + done, cache->data, set->blockSize);
+        }
+        unlockCacheShard(shard);
+    }
+}
+
+// 调用者持有 fdTableLock 读锁；把 buf 中的新数据同步到 [pos, pos+length) 内驻留的块。
+// 正在写回的块旧数据可能晚于本次写入落盘，重新标脏；markDirty 时全部标脏，由回写补上
+static void updateResidentBlocks(CacheSet* set, const char* buf, off_t pos, size_t length, int markDirty)
+{
+    if (ATOMIC_LOAD(&(set->residentBytes)) == 0)
+    {
+        return;
+    }
+
+    for (size_t done = 0; done < length; done += set->blockSize)
+    {
+        CacheShard* shard = lockCacheShard(set, pos + (off_t)done);
+        cache* cache = findCache(set, pos + (off_t)done);
+        if (cache != NULL)
+        {
+            memcpy(cache->data, buf + done, set->blockSize);
+            if (markDirty || (cache->flags & CACHE_FLAG_WRITEBACK))
+            {
+                markCacheDirty(set, cache);
+            }
+        }
+        unlockCacheShard(shard);
+    }
+}
+
+static size_t getBypassChunkBytes(CacheSet* set)
+{
+    size_t chunkBytes = set->maxIOBytes & ~(set->blockSize - 1);
+    return MAX(chunkBytes, set->blockSize);
+}
 
-    off_t alignedDownOffset = ROUND_DOWN_TO_4096(offset);
+// 调用者持有 fdTableLock 读锁。按 maxIOBytes 分段直接从设备读入，再用驻留块覆盖；
+// 用户缓冲区对齐且完整覆盖一段时直接读入，否则经过对齐的 bounce 缓冲区。
+// 读盘期间脏块可能被写回并淘汰，覆盖时已找不到它，读到的却是写回前的旧数据，此时重读这一段
+static ssize_t readBypassRange(HashTableFdNode* hashTableFdNode, IovCursor* cursor, size_t count, off_t offset)
+{
+    CacheSet* set = hashTableFdNode->set;
+    size_t blockSize = set->blockSize;
+    size_t chunkBytes = getBypassChunkBytes(set);
+    off_t alignedEnd = ROUND_UP_TO_BLOCK(offset + (off_t)count, blockSize);
+    char* bounce = NULL;
     size_t processedData = 0;
 
-    HashTableFdNode* hashTableFdNode = findFdNode(fd);
+    for (off_t pos = ROUND_DOWN_TO_BLOCK(offset, blockSize); processedData < count; )
+    {
+        size_t length = MIN(chunkBytes, (size_t)(alignedEnd - pos));
+        size_t skip = (offset > pos) ? (size_t)(offset - pos) : 0;
+        size_t want = MIN(length - skip, count - processedData);
+        char* buf = (skip == 0 && want == length) ? (char*)getIovCursorAligned(cursor, length, blockSize) : NULL;
+        if (buf == NULL)
+        {
+            if (bounce == NULL && posix_memalign((void**)&bounce, blockSize, chunkBytes) != 0)
+            {
+                fprintf(stderr, "Error: Failed to allocate bypass buffer\n");
+                bounce = NULL;
+                break;
+            }
+            buf = bounce;
+        }
+
+        unsigned long epoch = sampleDeviceWriteEpoch(set, pos, length);
+        ssize_t readNumb = transferBypass(hashTableFdNode, 0, buf, length, pos);
+        if (readNumb < 0)
+        {
+            break;
+        }
+        memset(buf + readNumb, 0, length - (size_t)readNumb);
+        overlayResidentBlocks(set, buf, pos, length);
+        if (sampleDeviceWriteEpoch(set, pos, length) != epoch)
+        {
+            continue;
+        }
+
+        if (buf == bounce)
+        {
+            copyToIovCursor(cursor, bounce + skip, want);
+        }
+        else
+        {
+            advanceIovCursor(cursor, want);
+        }
+        processedData += want;
+        pos += (off_t)length;
+    }
+
+    free(bounce);
+    return (processedData > 0 || count == 0) ? (ssize_t)processedData : -1;
+}
+
+// 调用者持有 fdTableLock 读锁。首尾不完整的块仍写入缓存，以免覆盖同一块上其他写入的数据；
+// 中间的完整块直接写入设备，写入前后各同步一次驻留块：之前同步保证之后回写的是新数据，
+// 之后同步覆盖写入期间从设备读入的旧数据
+static ssize_t writeBypassRange(HashTableFdNode* hashTableFdNode, IovCursor* cursor, size_t count, off_t offset)
+{
+    CacheSet* set = hashTableFdNode->set;
+    size_t blockSize = set->blockSize;
+    size_t chunkBytes = getBypassChunkBytes(set);
+    off_t end = offset + (off_t)count;
+    off_t pos = offset;
+    char* bounce = NULL;
+
+    off_t headEnd = MIN(ROUND_UP_TO_BLOCK(offset, (off_t)blockSize), end);
+    if (pos < headEnd)
+    {
+        const void* piece = takeIovCursorWrite(cursor, (size_t)(headEnd - pos), blockSize);
+        if (piece == NULL || writeCacheBlock(hashTableFdNode, piece, pos, (size_t)(headEnd - pos)) < 0)
+        {
+            return -1;
+        }
+        pos = headEnd;
+    }
+
+    off_t bodyEnd = MAX(ROUND_DOWN_TO_BLOCK(end, blockSize), pos);
+    while (pos < bodyEnd)
+    {
+        size_t length = MIN(chunkBytes, (size_t)(bodyEnd - pos));
+        char* buf = (char*)getIovCursorAligned(cursor, length, blockSize);
+        if (buf != NULL)
+        {
+            advanceIovCursor(cursor, length);
+        }
+        else
+        {
+            if (bounce == NULL && posix_memalign((void**)&bounce, blockSize, chunkBytes) != 0)
+            {
+                fprintf(stderr, "Error: Failed to allocate bypass buffer\n");
+                bounce = NULL;
+                break;
+            }
+            copyFromIovCursor(cursor, bounce, length);
+            buf = bounce;
+        }
+
+        updateResidentBlocks(set, buf, pos, length, 0);
+        ssize_t writeNumb = transferBypass(hashTableFdNode, 1, buf, length, pos);
+        updateResidentBlocks(set, buf, pos, length, writeNumb != (ssize_t)length);
+        if (writeNumb != (ssize_t)length)
+        {
+            break;
+        }
+        pos += (off_t)length;
+    }
+
+    if (pos == bodyEnd && pos < end)
+    {
+        const void* piece = takeIovCursorWrite(cursor, (size_t)(end - pos), blockSize);
+        if (piece != NULL && writeCacheBlock(hashTableFdNode, piece, pos, (size_t)(end - pos)) == 0)
+        {
+            pos = end;
+        }
+    }
+
+    free(bounce);
+    return (pos > offset || count == 0) ? (ssize_t)(pos - offset) : -1;
+}
+
+// readWithCache 与 readvWithCache 共用：一次遍历整个范围，块与调用者缓冲区之间直接复制。
+// residentOnly 时遇到第一个未驻留的块就停下，不读设备，返回已复制的字节数
+static ssize_t readCacheRange(int fd, const struct iovec* iov, int iovcnt, size_t count, off_t offset, int residentOnly)
+{
+    unsigned long long startNs = getMonotonicNs();
+    HashTableFdNode* hashTableFdNode = acquireFdNode(fd);
+    if (hashTableFdNode == NULL)
+    {
+        fprintf(stderr, "Error: Failed to find FD node in hash table\n");
+        return -1;
+    }
+    if (residentOnly && (hashTableFdNode->cacheType != CACHE_TYPE_HOST ||
+                         (hashTableFdNode->bypass != NULL && shouldBypass(hashTableFdNode->bypass, offset, count))))
+    {
+        releaseFdNode();
+        return 0;
+    }
+    if (!residentOnly)
+    {
+        TRACE_CACHE_ACCESS(fd, CACHE_TRACE_READ, offset, count, startNs);
+    }
+
+    CacheSet* set = hashTableFdNode->set;
+    size_t blockSize = set->blockSize;
+    off_t alignedDownOffset = ROUND_DOWN_TO_BLOCK(offset, blockSize);
+    size_t processedData = 0;
+    int missed = 0;
+    int touchedReadahead = 0;
+    IovCursor cursor;
+
+    initIovCursor(&cursor, iov, iovcnt);
+
+    if (hashTableFdNode->bypass != NULL && shouldBypass(hashTableFdNode->bypass, offset, count))
+    {
+        ssize_t readNumb = readBypassRange(hashTableFdNode, &cursor, count, offset);
+        recordCacheLatency(&(CACHE_SHARD_OF(set, offset)->stats.missLatency), startNs);
+        releaseFdNode();
+        return readNumb;
+    }
    
     for(int i = 0; processedData < count ;i++)
     {
-        size_t steppedAlignedOffset = alignedDownOffset + i * CACHE_SIZE;
-        size_t DataToProcess = ((steppedAlignedOffset + CACHE_SIZE) > (offset + count))? (count - processedData): MIN((steppedAlignedOffset + CACHE_SIZE - offset), CACHE_SIZE);
+        off_t steppedAlignedOffset = alignedDownOffset + (off_t)i * blockSize;
+        size_t offsetInCache = (offset > steppedAlignedOffset) ? (size_t)(offset - steppedAlignedOffset) : 0;
+        size_t DataToProcess = MIN(blockSize - offsetInCache, count - processedData);
+        void* buf = getIovCursorSpan(&cursor, DataToProcess, blockSize);
+        if (buf == NULL)
+        {
+            break;
+        }
+
+        // 命中只置访问位的策略在分片读锁下完成普通命中，其余情况再取写锁
+        if (set->sharedHits)
+        {
+            CacheShard* shard = lockCacheShardShared(set, steppedAlignedOffset);
+            cache* cache = findCache(set, steppedAlignedOffset);
+            if (cache != NULL && !(cache->flags & (CACHE_FLAG_READAHEAD | CACHE_FLAG_FRESH)))
+            {
+                readWithHostCache(set, cache, buf, offsetInCache, DataToProcess);
+                ATOMIC_ADD(&(shard->stats.hits), 1);
+                unlockCacheShard(shard);
+                finishIovCursorRead(&cursor, buf, DataToProcess);
+                processedData = processedData + DataToProcess;
+                continue;
+            }
+            unlockCacheShard(shard);
+        }
     
-        cache* cache = findCache(hashTableFdNode->root, steppedAlignedOffset);
-        size_t offsetInCache = (offset > steppedAlignedOffset) ? (offset - steppedAlignedOffset) : 0;
+        CacheShard* shard = lockCacheShard(set, steppedAlignedOffset);
+        cache* cache = findCache(set, steppedAlignedOffset);
 
         if(hashTableFdNode->cacheType == CACHE_TYPE_HOST)
         {
-            if(cache != NULL)
+            // 刚读入还没被读过的块（本请求或异步请求读入的）算作未命中
+            int blockMissed = (cache == NULL || (cache->flags & CACHE_FLAG_FRESH));
+            if (cache == NULL && residentOnly)
+            {
+                unlockCacheShard(shard);
+                break;
+            }
+            if(cache == NULL)
+            {
+                unlockCacheShard(shard);
+
+                // 把请求剩余部分中所有未命中的块作为一批读入
+                off_t blocksLeft = (ROUND_UP_TO_BLOCK(offset + (off_t)count, blockSize) - steppedAlignedOffset) / (off_t)blockSize;
+                blocksLeft = MIN(blocksLeft, (off_t)INT_MAX);
+                if (readMissingBlocks(fd, steppedAlignedOffset, (int)blocksLeft, CACHE_FLAG_FRESH, NULL) < 0)
+                {
+                    recordCacheLatency(&(CACHE_SHARD_OF(set, offset)->stats.missLatency), startNs);
+                    releaseFdNode();
+                    free(cursor.bounce);
+                    return (processedData > 0) ? (ssize_t)processedData : -1;
+                }
+
+                shard = lockCacheShard(set, steppedAlignedOffset);
+                cache = findCache(set, steppedAlignedOffset);
+                if (cache == NULL)
+                {
+                    // 刚读入的块已被其他线程淘汰，直接从源读取这一段
+                    unlockCacheShard(shard);
+                    ssize_t readNumb = pread(fd, buf, DataToProcess, steppedAlignedOffset + (off_t)offsetInCache);
+                    CACHE_STAT_ADD(set, steppedAlignedOffset, misses, 1);
+                    missed = 1;
+                    if (readNumb < 0)
+                    {
+                        recordCacheLatency(&(CACHE_SHARD_OF(set, offset)->stats.missLatency), startNs);
+                        releaseFdNode();
+                        free(cursor.bounce);
+                        return (processedData > 0) ? (ssize_t)processedData : -1;
+                    }
+                    CACHE_STAT_ADD(set, steppedAlignedOffset, deviceReadBytes, (unsigned long long)readNumb);
+                    memset(buf + readNumb, 0, DataToProcess - (size_t)readNumb);
+                    finishIovCursorRead(&cursor, buf, DataToProcess);
+                    processedData = processedData + DataToProcess;
+                    continue;
+                }
+            }
+
+            // 刚读入或预读进来的块第一次被读到不算命中，否则扫描会把它们当成热点
+            int firstTouch = (cache->flags & (CACHE_FLAG_READAHEAD | CACHE_FLAG_FRESH)) != 0;
+            if ((cache->flags & CACHE_FLAG_READAHEAD) && hashTableFdNode->ra != NULL)
+            {
+                noteReadaheadUsed(hashTableFdNode->ra);
+                touchedReadahead = 1;
+            }
+            if (blockMissed)
+            {
+                ATOMIC_ADD(&(shard->stats.misses), 1);
+                missed = 1;
+            }
+            else
+            {
+                ATOMIC_ADD(&(shard->stats.hits), 1);
+                if (cache->flags & CACHE_FLAG_READAHEAD)
+                {
+                    ATOMIC_ADD(&(shard->stats.readaheadHits), 1);
+                }
+            }
+            cache->flags &= ~(CACHE_FLAG_READAHEAD | CACHE_FLAG_FRESH);
+
+            if (firstTouch)
             {
-                readWithHostCache(hashTableFdNode->Hash, cache, buf + processedData, offsetInCache, DataToProcess);
+                memcpy(buf, (char*)cache->data + offsetInCache, DataToProcess);
             }
             else
             {
-                void* bufOut = (void*)malloc(CACHE_SIZE);
-                readWithoutHostCache(fd, bufOut, steppedAlignedOffset);
-                memcpy(buf + processedData, bufOut + offsetInCache, DataToProcess);
-                free(bufOut);
+                readWithHostCache(set, cache, buf, offsetInCache, DataToProcess);
             }
+            unlockCacheShard(shard);
         }
         
         else
         {
+            // 设备模式的块数据在内存层，命中与主机缓存相同；刚装入的块不算命中
             if(cache != NULL)
             {
-                readDevWithCache(fd, hashTableFdNode->Hash, cache, buf + processedData, offsetInCache, DataToProcess);
+                readWithHostCache(set, cache, buf, offsetInCache, DataToProcess);
+                ATOMIC_ADD(&(shard->stats.hits), 1);
             }
             else
             {
-                void* bufOut = (void*)malloc(CACHE_SIZE);
-                readWithoutDevCache(fd, bufOut, steppedAlignedOffset);
-                memcpy(buf + processedData, bufOut + offsetInCache, DataToProcess);
-                free(bufOut);
+                unlockCacheShard(shard);
+                missed = 1;
+                cache = loadDevBlock(fd, steppedAlignedOffset, 1, &shard);
+                if (cache == NULL)
+                {
+                    recordCacheLatency(&(CACHE_SHARD_OF(set, offset)->stats.missLatency), startNs);
+                    releaseFdNode();
+                    free(cursor.bounce);
+                    return (processedData > 0) ? (ssize_t)processedData : -1;
+                }
+                memcpy(buf, (char*)cache->data + offsetInCache, DataToProcess);
+                ATOMIC_ADD(&(shard->stats.misses), 1);
             }
+            unlockCacheShard(shard);
         }
+        finishIovCursorRead(&cursor, buf, DataToProcess);
         processedData = processedData + DataToProcess;
 
     }
+
+    // 只读了驻留部分时，剩余部分由调用者另行读取，流检测与延迟统计留给那一次
+    if (residentOnly && processedData < count)
+    {
+        if (processedData > 0)
+        {
+            TRACE_CACHE_ACCESS(fd, CACHE_TRACE_READ, offset, processedData, startNs);
+        }
+        releaseFdNode();
+        free(cursor.bounce);
+        return processedData;
+    }
+    if (residentOnly)
+    {
+        TRACE_CACHE_ACCESS(fd, CACHE_TRACE_READ, offset, count, startNs);
+    }
+
+    // 全部命中普通块的读不会推进任何预读，跳过流检测，不去碰共享的 ra->lock；
+    // 顺序读者读到预读块时仍会走到这里，窗口照常向前滚动
+    if (hashTableFdNode->ra != NULL && (missed || touchedReadahead))
+    {
+        off_t prefetchOffset = 0;
+        size_t prefetchBytes = readaheadOnRead(hashTableFdNode->ra, offset, count, &prefetchOffset);
+        if (prefetchBytes > 0)
+        {
+            prefetchHostCacheAsync(fd, prefetchOffset, prefetchBytes);
+        }
+    }
+    CacheShard* requestShard = CACHE_SHARD_OF(set, offset);
+    recordCacheLatency(missed ? &(requestShard->stats.missLatency) : &(requestShard->stats.hitLatency), startNs);
+    releaseFdNode();
+    free(cursor.bounce);
     return processedData;
 
 }
 
-ssize_t writeWithCache(int fd, const void *buf, size_t count, off_t offset)
+ssize_t readWithCache(int fd, void *buf, size_t count, off_t offset)
 {
-    HashTableFdNode* hashTableFdNode = findFdNode(fd);
+    struct iovec iov = { buf, count };
+    return readCacheRange(fd, &iov, 1, count, offset, 0);
+}
+
+ssize_t readResidentWithCache(int fd, void* buf, size_t count, off_t offset)
+{
+    struct iovec iov = { buf, count };
+    return readCacheRange(fd, &iov, 1, count, offset, 1);
+}
+
+ssize_t readvWithCache(int fd, const struct iovec* iov, int iovcnt, off_t offset)
+{
+    ssize_t count = getIovTotalLength(iov, iovcnt);
+    if (count < 0)
+    {
+        return -1;
+    }
+    return readCacheRange(fd, iov, iovcnt, (size_t)count, offset, 0);
+}
+
+static ssize_t writeCacheRange(int fd, const struct iovec* iov, int iovcnt, size_t count, off_t offset)
+{
+    unsigned long long startNs = getMonotonicNs();
+    throttleDirtyWriters();
+
+    HashTableFdNode* hashTableFdNode = acquireFdNode(fd);
+    if (hashTableFdNode == NULL)
+    {
+        fprintf(stderr, "Error: Failed to find FD node in hash table\n");
+        return -1;
+    }
+    TRACE_CACHE_ACCESS(fd, CACHE_TRACE_WRITE, offset, count, startNs);
 
-    off_t alignedDownOffset = ROUND_DOWN_TO_4096(offset);
+    CacheSet* set = hashTableFdNode->set;
+    size_t blockSize = set->blockSize;
+    off_t alignedDownOffset = ROUND_DOWN_TO_BLOCK(offset, blockSize);
     size_t processedData = 0;
+    IovCursor cursor;
+
+    initIovCursor(&cursor, iov, iovcnt);
+
+    if (hashTableFdNode->bypass != NULL && shouldBypass(hashTableFdNode->bypass, offset, count))
+    {
+        ssize_t written = writeBypassRange(hashTableFdNode, &cursor, count, offset);
+        if (written > 0 && hashTableFdNode->ra != NULL)
+        {
+            noteOriginExtended(hashTableFdNode->ra, offset + written);
+        }
+        recordCacheLatency(&(CACHE_SHARD_OF(set, offset)->stats.writeLatency), startNs);
+        releaseFdNode();
+        free(cursor.bounce);
+        kickCacheFlusher();
+        return written;
+    }
     
     for(int i = 0; processedData < count ;i++)
     {
 
-        size_t steppedAlignedOffset = alignedDownOffset + i * CACHE_SIZE;
-        size_t DataToProcess = ((steppedAlignedOffset + CACHE_SIZE) > (offset + count))? (count - processedData): MIN((steppedAlignedOffset + CACHE_SIZE - offset), CACHE_SIZE);
-        size_t offsetInCache = (offset > steppedAlignedOffset) ? (offset - steppedAlignedOffset) : 0;
-        size_t offsetOutCache = (offset >= steppedAlignedOffset) ? offset : steppedAlignedOffset;
+        off_t steppedAlignedOffset = alignedDownOffset + (off_t)i * blockSize;
+        size_t offsetInCache = (offset > steppedAlignedOffset) ? (size_t)(offset - steppedAlignedOffset) : 0;
+        size_t DataToProcess = MIN(blockSize - offsetInCache, count - processedData);
+        off_t offsetOutCache = (offset >= steppedAlignedOffset) ? offset : steppedAlignedOffset;
+        const void* buf = takeIovCursorWrite(&cursor, DataToProcess, blockSize);
+        if (buf == NULL)
+        {
+            break;
+        }
         
-        cache* cache = findCache(hashTableFdNode->root, steppedAlignedOffset);
+        if (writeCacheBlock(hashTableFdNode, buf, offsetOutCache, DataToProcess) < 0)
+        {
+            break;
+        }
+        processedData = processedData + DataToProcess;
 
-        if(hashTableFdNode->cacheType == CACHE_TYPE_HOST)
+    }
+
+    // 只有真正写入的部分才算扩展了源文件
+    if (processedData > 0 && hashTableFdNode->ra != NULL)
+    {
+        noteOriginExtended(hashTableFdNode->ra, offset + (off_t)processedData);
+    }
+    recordCacheLatency(&(CACHE_SHARD_OF(set, offset)->stats.writeLatency), startNs);
+    releaseFdNode();
+    free(cursor.bounce);
+    kickCacheFlusher();
+    return (processedData > 0 || count == 0) ? (ssize_t)processedData : -1;
+
+}
+
+ssize_t writeWithCache(int fd, const void *buf, size_t count, off_t offset)
+{
+    struct iovec iov = { (void*)buf, count };
+    return writeCacheRange(fd, &iov, 1, count, offset);
+}
+
+ssize_t writevWithCache(int fd, const struct iovec* iov, int iovcnt, off_t offset)
+{
+    ssize_t count = getIovTotalLength(iov, iovcnt);
+    if (count < 0)
+    {
+        return -1;
+    }
+    return writeCacheRange(fd, iov, iovcnt, (size_t)count, offset);
+}
+
+int getBlockRef(int fd, off_t offset, BlockRef* ref)
+{
+    HashTableFdNode* hashTableFdNode = acquireFdNode(fd);
+    if (hashTableFdNode == NULL)
+    {
+        fprintf(stderr, "Error: Failed to find FD node in hash table\n");
+        return -1;
+    }
+    if (hashTableFdNode->cacheType != CACHE_TYPE_HOST)
+    {
+        fprintf(stderr, "Error: Block references require a host cache\n");
+        releaseFdNode();
+        return -1;
+    }
+
+    CacheSet* set = hashTableFdNode->set;
+    off_t alignedOffset = ROUND_DOWN_TO_BLOCK(offset, set->blockSize);
+    TRACE_CACHE_ACCESS(fd, CACHE_TRACE_READ, alignedOffset, set->blockSize, getMonotonicNs());
+
+    // 读入的块在装入时就加上引用，不会在重新加锁前被淘汰；
+    // 只有读盘期间该块被写入设备、读到的数据作废时才需要再读
+    cache* pinned = NULL;
+    int missed = 0;
+    while (1)
+    {
+        CacheShard* shard = lockCacheShard(set, alignedOffset);
+        cache* cache = (pinned != NULL) ? pinned : findCache(set, alignedOffset);
+        if (cache != NULL)
         {
-            if(cache != NULL)
+            if ((cache->flags & CACHE_FLAG_READAHEAD) && hashTableFdNode->ra != NULL)
             {
-                writeHostWithCache(hashTableFdNode->Hash, cache, buf + processedData, offsetInCache, DataToProcess);
+                noteReadaheadUsed(hashTableFdNode->ra);
             }
-            else
+            if (!(cache->flags & (CACHE_FLAG_READAHEAD | CACHE_FLAG_FRESH)))
             {
-                writeHostWithoutCache(fd, buf + processedData, offsetOutCache, DataToProcess);
+                replacementHit(&(shard->policy), cache);
             }
-        }
-        else
-        {
-            if(cache != NULL)
+            if (missed || (cache->flags & CACHE_FLAG_FRESH))
             {
-                writeDevWithCache(fd, hashTableFdNode->Hash, cache, buf + processedData, offsetInCache, DataToProcess);
+                ATOMIC_ADD(&(shard->stats.misses), 1);
             }
             else
             {
-                writeDevWithoutCache(fd, buf + processedData, offsetOutCache, DataToProcess);
+                ATOMIC_ADD(&(shard->stats.hits), 1);
+                if (cache->flags & CACHE_FLAG_READAHEAD)
+                {
+                    ATOMIC_ADD(&(shard->stats.readaheadHits), 1);
+                }
+            }
+            cache->flags &= ~(CACHE_FLAG_READAHEAD | CACHE_FLAG_FRESH);
+            if (pinned == NULL)
+            {
+                ATOMIC_ADD(&(cache->pins), 1);
             }
+            unlockCacheShard(shard);
+
+            ref->data = cache->data;
+            ref->length = set->blockSize;
+            ref->offset = alignedOffset;
+            ref->entry = cache;
+            releaseFdNode();
+            return 0;
         }
-        processedData = processedData + DataToProcess;
+        unlockCacheShard(shard);
+
+        MissBatch* batch = NULL;
+        int covered = 0;
+        int missing = prepareMissBatch(fd, alignedOffset, 1, CACHE_FLAG_FRESH, &covered, &batch);
+        if (missing < 0)
+        {
+            break;
+        }
+        missed = 1;
+        if (missing > 0)
+        {
+            batch->pinOut = &pinned;
+            submitIoBatch(batch->requests, batch->requestCount);
+            if (completeMissBatch(batch) < 0)
+            {
+                break;
+            }
+        }
+    }
 
+    fprintf(stderr, "Error: Failed to reference block at offset %ld\n", (long)alignedOffset);
+    releaseFdNode();
+    return -1;
+}
+
+// 只减引用计数，不需要任何锁：被引用的块不会被淘汰，计数归零后才可能被回收。
+// release 保证借用期间对 data 的读取不会被排到回收之后
+void putBlockRef(BlockRef* ref)
+{
+    if (ref == NULL || ref->entry == NULL)
+    {
+        return;
     }
-    return processedData;
 
+    __atomic_sub_fetch(&(ref->entry->pins), 1, __ATOMIC_RELEASE);
+    ref->entry = NULL;
+    ref->data = NULL;
+}
+
+int openWithCache(const char *pathname, int flags, mode_t mode ,int cacheType, const CacheOptions* options)
+{
+    lockFdTable();
+    int fd = openWithCacheLocked(pathname, flags, mode, cacheType, options);
+    unlockFdTable();
+    return fd;
+}
+
+// 停止该 fd 的后台预热；预热线程读入时要取 fdTableLock 读锁，必须在关闭取写锁之前停止
+static void stopCacheWarmup(int fd)
+{
+    HashTableFdNode* hashTableFdNode = acquireFdNode(fd);
+    if (hashTableFdNode == NULL)
+    {
+        return;
+    }
+
+    pthread_mutex_lock(&warmupLock);
+    HotSetWarmup* warmup = hashTableFdNode->warmup;
+    hashTableFdNode->warmup = NULL;
+    pthread_mutex_unlock(&warmupLock);
+    releaseFdNode();
+
+    stopHotSetWarmup(warmup);
+}
+
+int closeWithCache(int fd)
+{
+    // 等待该 fd 上未完成的异步请求与预热线程，它们持有节点指针
+    stopCacheWarmup(fd);
+    waitCacheAsyncIdle(fd);
+    lockFdTable();
+    int result = closeWithCacheLocked(fd);
+    unlockFdTable();
+    return result;
+}
+
+void setCacheMemoryLimit(size_t bytes)
+{
+    lockFdTableShared();
+    ATOMIC_STORE(&(cacheBudget.limitBytes), bytes);
+
+    if (table != NULL)
+    {
+        trimCacheToBudget(-1, 0);
+    }
+    unlockFdTableShared();
+}
+
+size_t getCacheMemoryLimit(void)
+{
+    return ATOMIC_LOAD(&(cacheBudget.limitBytes));
+}
+
+int setCacheCapacity(int fd, size_t bytes)
+{
+    HashTableFdNode* hashTableFdNode = acquireFdNode(fd);
+    if (hashTableFdNode == NULL)
+    {
+        fprintf(stderr, "Error: Failed to find FD node in hash table\n");
+        return -1;
+    }
+
+    ATOMIC_STORE(&(hashTableFdNode->set->capacityBytes), bytes);
+    trimCacheToBudget(fd, 0);
+    releaseFdNode();
+    return 0;
+}
+
+int getCacheStats(int fd, CacheStats* stats)
+{
+    HashTableFdNode* hashTableFdNode = acquireFdNode(fd);
+    if (hashTableFdNode == NULL)
+    {
+        fprintf(stderr, "Error: Failed to find FD node in hash table\n");
+        return -1;
+    }
+
+    memset(stats, 0, sizeof(*stats));
+    collectCacheSetStats(hashTableFdNode->set, hashTableFdNode->tier, stats);
+    releaseFdNode();
+    return 0;
+}
+
+// 已关闭 fd 的累计值加上所有打开的 fd；驻留与脏字节只统计当前打开的 fd
+void getGlobalCacheStats(CacheStats* stats)
+{
+    memset(stats, 0, sizeof(*stats));
+
+    lockFdTableShared();
+    getRetiredCacheStats(stats);
+    for (int i = 0; table != NULL && i < table->size; i++)
+    {
+        for (HashTableFdNode* node = table->buckets[i]; node != NULL; node = node->next)
+        {
+            collectCacheSetStats(node->set, node->tier, stats);
+        }
+    }
+    unlockFdTableShared();
 }
 
+// 只支持主机缓存；path 为 NULL 时使用打开时配置的 hotSetPath
+static const char* getHotSetPath(HashTableFdNode* hashTableFdNode, const char* path)
+{
+    if (hashTableFdNode->cacheType != CACHE_TYPE_HOST)
+    {
+        fprintf(stderr, "Error: Hot set only supports host caches\n");
+        return NULL;
+    }
+    if (path == NULL && hashTableFdNode->hotSetPath == NULL)
+    {
+        fprintf(stderr, "Error: No hot set file configured for fd %d\n", hashTableFdNode->fd);
+    }
+    return (path != NULL) ? path : hashTableFdNode->hotSetPath;
+}
 
+int saveCacheHotSet(int fd, const char* path)
+{
+    HashTableFdNode* hashTableFdNode = acquireFdNode(fd);
+    if (hashTableFdNode == NULL)
+    {
+        fprintf(stderr, "Error: Failed to find FD node in hash table\n");
+        return -1;
+    }
+
+    path = getHotSetPath(hashTableFdNode, path);
+    int ret = (path != NULL) ? saveHotSet(hashTableFdNode->set, path) : -1;
+    releaseFdNode();
+    return ret;
+}
+
+int warmCacheFromHotSet(int fd, const char* path, size_t bytesPerSecond)
+{
+    HashTableFdNode* hashTableFdNode = acquireFdNode(fd);
+    if (hashTableFdNode == NULL)
+    {
+        fprintf(stderr, "Error: Failed to find FD node in hash table\n");
+        return -1;
+    }
+
+    path = getHotSetPath(hashTableFdNode, path);
+    if (path == NULL)
+    {
+        releaseFdNode();
+        return -1;
+    }
+
+    pthread_mutex_lock(&warmupLock);
+    if (isHotSetWarmupRunning(hashTableFdNode->warmup))
+    {
+        pthread_mutex_unlock(&warmupLock);
+        releaseFdNode();
+        fprintf(stderr, "Error: Hot set warmup is already running on fd %d\n", fd);
+        return -1;
+    }
+    // 上一次预热的线程都已退出，可以在锁外回收
+    HotSetWarmup* finished = hashTableFdNode->warmup;
+    hashTableFdNode->warmup = startHotSetWarmup(fd, path, hashTableFdNode->set->blockSize, bytesPerSecond);
+    int ret = (hashTableFdNode->warmup != NULL) ? 0 : -1;
+    pthread_mutex_unlock(&warmupLock);
+    releaseFdNode();
+
+    stopHotSetWarmup(finished);
+    return ret;
+}
@@ -5,14 +5,86 @@
 #include <stdlib.h>
 #include <unistd.h>
 #include <sys/types.h>
+#include <sys/uio.h>
+
+#include "cacheStats.h"
+#include "replacementPolicy.h"
 
 #define MIN(a, b) ((a) < (b) ? (a) : (b))
 #define MAX(a, b) ((a) > (b) ? (a) : (b))
 
+#define CACHE_MIN_BLOCK_SIZE 4096UL
+#define CACHE_MAX_BLOCK_SIZE (1UL << 20)
+#define CACHE_DEFAULT_BLOCK_SIZE CACHE_MIN_BLOCK_SIZE
+#define CACHE_READAHEAD_DISABLED ((size_t)-1)
+#define IS_POWER_OF_TWO(x) ((x) != 0 && ((x) & ((x) - 1)) == 0)
+
+// 只覆盖块的一部分的写未命中：读入整块后合并进缓存，或直接写到设备而不进缓存
+#define CACHE_WRITE_ALLOCATE 0
+#define CACHE_WRITE_NO_ALLOCATE 1
+
+// 主机缓存的写策略：写回只写缓存，由回写落盘；直写同时写缓存与设备；绕写只写设备，驻留的块同步更新
+#define CACHE_WRITE_BACK 0
+#define CACHE_WRITE_THROUGH 1
+#define CACHE_WRITE_AROUND 2
+
+// openWithCache 的可选参数，传 NULL 或置 0 的字段使用默认值
+typedef struct CacheOptions
+{
+    size_t blockSize;   // 缓存块大小，2 的幂，4 KiB ~ 1 MiB；0 表示按设备块大小自动选择
+    size_t capacityBytes;   // 该 fd 的缓存容量上限（字节），0 表示只受全局预算限制
+    size_t readaheadBytes;  // 顺序预读窗口上限，0 使用默认值，CACHE_READAHEAD_DISABLED 关闭预读
+    size_t maxIOBytes;      // 合并读与写回的单次 I/O 上限，0 使用 CACHE_MAX_IO_BYTES
+    unsigned int shardCount;    // 块索引与替换链表的分片数，2 的幂，0 使用 CACHE_DEFAULT_SHARD_COUNT
+    int policy;     // 替换策略 CACHE_POLICY_*，默认 CACHE_POLICY_LRU
+    size_t bypassBytes;         // 单次请求达到该字节数时绕过缓存直接读写设备，0 表示关闭
+    size_t bypassStreamBytes;   // 顺序流累计超过该字节数后绕过缓存，0 表示关闭
+    int writeMissPolicy;        // 部分块写未命中的处理，默认 CACHE_WRITE_ALLOCATE；整块写总是直接装入缓存
+    int writePolicy;            // CACHE_WRITE_BACK（默认）、CACHE_WRITE_THROUGH 或 CACHE_WRITE_AROUND
+    size_t deviceTierBytes;     // 设备模式下 NVMe 缓存分区层的容量，0 表示不启用，内存层淘汰的块直接写回
+    int deviceTierPolicy;       // NVMe 层的替换策略 CACHE_POLICY_*，默认 CACHE_POLICY_LRU
+    off_t deviceTierMetaOffset; // NVMe 层元数据区在缓存分区上的偏移（块对齐），0 表示不持久化；该偏移及之后的块不进入 NVMe 层
+    const char* hotSetPath;     // 主机缓存关闭时把热块列表保存到该文件，NULL 表示不保存
+    int hotSetWarmup;           // 打开时按 hotSetPath 中的列表在后台预取
+    size_t hotSetWarmupRate;    // 预取限速（字节/秒），0 使用 HOT_SET_DEFAULT_RATE
+} CacheOptions;
+
+// getBlockRef 借出的缓存块，持有期间该块不会被淘汰；data 只读，长度为一个缓存块
+typedef struct BlockRef
+{
+    const void* data;
+    size_t length;
+    off_t offset;       // 块的起始偏移
+    struct cache* entry;
+} BlockRef;
 
-int openWithCache(const char *pathname, int flags, mode_t mode, int cacheType);
+
+int openWithCache(const char *pathname, int flags, mode_t mode, int cacheType, const CacheOptions* options);
 int closeWithCache(int fd);
 ssize_t readWithCache(int fd, void *buf, size_t count, off_t offset);
 ssize_t writeWithCache(int fd, const void *buf, size_t count, off_t offset);
+// 一次遍历整个范围，在缓存块与各 iovec 之间分散/收集
+ssize_t readvWithCache(int fd, const struct iovec* iov, int iovcnt, off_t offset);
+ssize_t writevWithCache(int fd, const struct iovec* iov, int iovcnt, off_t offset);
+// 只复制从 offset 起连续驻留的部分，遇到未驻留的块即返回，不读设备；只支持主机缓存，其余情况返回 0
+ssize_t readResidentWithCache(int fd, void* buf, size_t count, off_t offset);
+
+// 借出 offset 所在的缓存块（未命中时先读入），免去复制到用户缓冲区；只支持主机缓存。
+// 持有期间同一块上的写入会直接反映在 data 中；关闭 fd 前必须用 putBlockRef 归还
+int getBlockRef(int fd, off_t offset, BlockRef* ref);
+void putBlockRef(BlockRef* ref);
+
+// 把 fd 当前驻留的块按热度保存到 path，path 为 NULL 时使用打开时的 hotSetPath；只支持主机缓存
+int saveCacheHotSet(int fd, const char* path);
+// 在后台按 path 中的热块列表合并、限速地预取，缓存满时停止；bytesPerSecond 为 0 使用默认限速
+int warmCacheFromHotSet(int fd, const char* path, size_t bytesPerSecond);
+
+void setCacheMemoryLimit(size_t bytes);
+size_t getCacheMemoryLimit(void);
+int setCacheCapacity(int fd, size_t bytes);
+
+// 读取单个 fd 或整个进程的统计快照，计数不取分片锁汇总，各项之间不保证严格一致
+int getCacheStats(int fd, CacheStats* stats);
+void getGlobalCacheStats(CacheStats* stats);
 
 #endif
\ No newline at end of file
@@ -0,0 +1,128 @@
+#include <string.h>
+#include <time.h>
+
+#include "cacheStats.h"
+#include "cacheStruct.h"
+#include "deviceTier.h"
+
+// 已关闭 fd 的累计计数，只在 fdTableLock 写锁下修改
+static CacheStats retiredStats;
+
+unsigned long long getMonotonicNs(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (unsigned long long)ts.tv_sec * 1000000000ULL + (unsigned long long)ts.tv_nsec;
+}
+
+void recordCacheLatency(CacheLatencyHistogram* histogram, unsigned long long startNs)
+{
+    unsigned long long now = getMonotonicNs();
+    unsigned long long ns = (now > startNs) ? now - startNs : 0;
+    int bucket = (ns != 0) ? 63 - __builtin_clzll(ns) : 0;
+
+    if (bucket >= CACHE_LATENCY_BUCKETS)
+    {
+        bucket = CACHE_LATENCY_BUCKETS - 1;
+    }
+    ATOMIC_ADD(&(histogram->buckets[bucket]), 1);
+    ATOMIC_ADD(&(histogram->totalNs), ns);
+}
+
+unsigned long long getCacheLatencyPercentile(const CacheLatencyHistogram* histogram, double fraction)
+{
+    unsigned long long total = 0;
+    for (int i = 0; i < CACHE_LATENCY_BUCKETS; i++)
+    {
+        total += histogram->buckets[i];
+    }
+    if (total == 0)
+    {
+        return 0;
+    }
+
+    unsigned long long target = (unsigned long long)(fraction * (double)total);
+    unsigned long long seen = 0;
+    for (int i = 0; i < CACHE_LATENCY_BUCKETS; i++)
+    {
+        seen += histogram->buckets[i];
+        if (seen > target || seen == total)
+        {
+            return 2ULL << i;
+        }
+    }
+    return 2ULL << (CACHE_LATENCY_BUCKETS - 1);
+}
+
+// 记录时只更新桶与总耗时，count 在汇总时由各桶求和
+static void addLatencyHistogram(CacheLatencyHistogram* total, const CacheLatencyHistogram* histogram)
+{
+    total->totalNs += ATOMIC_LOAD(&(histogram->totalNs));
+    for (int i = 0; i < CACHE_LATENCY_BUCKETS; i++)
+    {
+        unsigned long long n = ATOMIC_LOAD(&(histogram->buckets[i]));
+        total->buckets[i] += n;
+        total->count += n;
+    }
+}
+
+// stats 可以是仍在更新的分片计数，逐项原子读取
+void addCacheStats(CacheStats* total, const CacheStats* stats)
+{
+    total->hits += ATOMIC_LOAD(&(stats->hits));
+    total->misses += ATOMIC_LOAD(&(stats->misses));
+    total->readaheadHits += ATOMIC_LOAD(&(stats->readaheadHits));
+    total->cleanEvictions += ATOMIC_LOAD(&(stats->cleanEvictions));
+    total->dirtyEvictions += ATOMIC_LOAD(&(stats->dirtyEvictions));
+    total->deviceReadBytes += ATOMIC_LOAD(&(stats->deviceReadBytes));
+    total->deviceWriteBytes += ATOMIC_LOAD(&(stats->deviceWriteBytes));
+    total->writeBackBatches += ATOMIC_LOAD(&(stats->writeBackBatches));
+    total->writeBackBlocks += ATOMIC_LOAD(&(stats->writeBackBlocks));
+    total->bypassBytes += ATOMIC_LOAD(&(stats->bypassBytes));
+    total->residentBytes += ATOMIC_LOAD(&(stats->residentBytes));
+    total->dirtyBytes += ATOMIC_LOAD(&(stats->dirtyBytes));
+    total->tierResidentBytes += ATOMIC_LOAD(&(stats->tierResidentBytes));
+    total->tierDirtyBytes += ATOMIC_LOAD(&(stats->tierDirtyBytes));
+    addLatencyHistogram(&(total->hitLatency), &(stats->hitLatency));
+    addLatencyHistogram(&(total->missLatency), &(stats->missLatency));
+    addLatencyHistogram(&(total->writeLatency), &(stats->writeLatency));
+}
+
+void collectCacheSetStats(CacheSet* set, DeviceTier* tier, CacheStats* stats)
+{
+    if (set != NULL)
+    {
+        for (unsigned int n = 0; n < set->shardCount; n++)
+        {
+            addCacheStats(stats, &(set->shards[n].stats));
+        }
+        stats->residentBytes += ATOMIC_LOAD(&(set->residentBytes));
+        stats->dirtyBytes += ATOMIC_LOAD(&(set->dirtyBytes));
+    }
+
+    // NVMe 层的计数在层锁下修改，这里读到的是近似值
+    if (tier != NULL)
+    {
+        stats->tierResidentBytes += ATOMIC_LOAD(&(tier->residentBytes));
+        stats->tierDirtyBytes += ATOMIC_LOAD(&(tier->dirtyBytes));
+        stats->deviceWriteBytes += ATOMIC_LOAD(&(tier->writeBackBytes));
+    }
+}
+
+void retireCacheSetStats(CacheSet* set, DeviceTier* tier)
+{
+    CacheStats stats;
+
+    memset(&stats, 0, sizeof(stats));
+    collectCacheSetStats(set, tier, &stats);
+    stats.residentBytes = 0;
+    stats.dirtyBytes = 0;
+    stats.tierResidentBytes = 0;
+    stats.tierDirtyBytes = 0;
+    addCacheStats(&retiredStats, &stats);
+}
+
+void getRetiredCacheStats(CacheStats* stats)
+{
+    addCacheStats(stats, &retiredStats);
+}
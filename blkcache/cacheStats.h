@@ -0,0 +1,56 @@
+#ifndef CACHE_STATS_H
+#define CACHE_STATS_H
+
+#include <stddef.h>
+
+struct CacheSet;
+struct DeviceTier;
+
+// 第 i 个桶统计耗时在 [2^i, 2^(i+1)) 纳秒内的请求，最后一个桶包含更慢的请求
+#define CACHE_LATENCY_BUCKETS 32
+
+typedef struct CacheLatencyHistogram
+{
+    unsigned long long count;       // 只在汇总结果中有效
+    unsigned long long totalNs;
+    unsigned long long buckets[CACHE_LATENCY_BUCKETS];
+} CacheLatencyHistogram;
+
+// 缓存统计。计数按分片各自累加（只用原子加，不取额外的锁），读取时再汇总；
+// 块数均以缓存块计，设备读写字节只计后端设备（主机模式为源文件）上的 I/O
+typedef struct CacheStats
+{
+    unsigned long long hits;            // 读命中的块，含 readaheadHits
+    unsigned long long misses;          // 需要从设备读入的块
+    unsigned long long readaheadHits;   // 由预读装入、第一次被读到的块
+    unsigned long long cleanEvictions;
+    unsigned long long dirtyEvictions;  // 淘汰时为脏块（写回设备或降级到 NVMe 层）
+    unsigned long long deviceReadBytes;
+    unsigned long long deviceWriteBytes;
+    unsigned long long writeBackBatches;    // 回写与关闭时的成批写回次数
+    unsigned long long writeBackBlocks;     // 成批写回的块数
+    unsigned long long bypassBytes;     // 绕过缓存直接读写的字节数
+    size_t residentBytes;   // 以下四项为读取时的瞬时值，分片中的副本不使用
+    size_t dirtyBytes;
+    size_t tierResidentBytes;
+    size_t tierDirtyBytes;
+    CacheLatencyHistogram hitLatency;   // 所有块都命中的读请求
+    CacheLatencyHistogram missLatency;  // 有块未命中或被绕过的读请求
+    CacheLatencyHistogram writeLatency; // 写请求，含脏数据过多时的等待
+} CacheStats;
+
+
+unsigned long long getMonotonicNs(void);
+void recordCacheLatency(CacheLatencyHistogram* histogram, unsigned long long startNs);
+// 直方图中累计比例达到 fraction（0 ~ 1）的桶的上界（纳秒），没有样本时返回 0
+unsigned long long getCacheLatencyPercentile(const CacheLatencyHistogram* histogram, double fraction);
+
+void addCacheStats(CacheStats* total, const CacheStats* stats);
+// 把集合各分片与 NVMe 层的计数累加到 stats，不取分片锁
+void collectCacheSetStats(struct CacheSet* set, struct DeviceTier* tier, CacheStats* stats);
+// 关闭 fd 前把它的计数并入已关闭 fd 的累计值，调用者持有 fdTableLock 写锁
+void retireCacheSetStats(struct CacheSet* set, struct DeviceTier* tier);
+// 调用者至少持有 fdTableLock 读锁
+void getRetiredCacheStats(CacheStats* stats);
+
+#endif
@@ -2,159 +2,295 @@
 #include <string.h>
 #include <stdlib.h>
 #include <stdio.h>
+#include <time.h>
 
 #include "cacheStruct.h"
 
-void cleanUpAVLTreeData(AVLTreeNode** root) 
+CacheBudget cacheBudget = { CACHE_DEFAULT_MEMORY_LIMIT, 0, 0 };
+
+unsigned long long getMonotonicMs(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (unsigned long long)ts.tv_sec * 1000ULL + (unsigned long long)ts.tv_nsec / 1000000ULL;
+}
+
+static void destroyCacheShards(CacheShard* shards, unsigned int count)
 {
-    if (root == NULL || *root == NULL) 
+    for (unsigned int i = 0; i < count; i++)
     {
-        return;
+        destroyBlockIndex(shards[i].index);
+        destroyReplacementState(&(shards[i].policy));
+        pthread_rwlock_destroy(&(shards[i].lock));
     }
+    free(shards);
+}
 
-    cleanUpAVLTreeData(&((*root)->left));
-
-    cleanUpAVLTreeData(&((*root)->right));
+CacheSet* createCacheSet(BlockPool* pool, size_t blockSize, size_t capacityBytes, size_t maxIOBytes,
+                         unsigned int shardCount, int policy)
+{
+    if (shardCount == 0)
+    {
+        shardCount = CACHE_DEFAULT_SHARD_COUNT;
+    }
+    if ((shardCount & (shardCount - 1)) != 0 || shardCount > CACHE_MAX_SHARD_COUNT)
+    {
+        fprintf(stderr, "Error: Invalid cache shard count %u\n", shardCount);
+        return NULL;
+    }
 
-    if ((*root) != NULL && (*root)->data != NULL) 
+    CacheSet* set = (CacheSet*)malloc(sizeof(CacheSet));
+    if (set == NULL)
     {
-        cache* cacheData = (cache*)(*root)->data;
+        perror("Failed to allocate cache set");
+        return NULL;
+    }
 
-        if (cacheData != NULL && cacheData->data != NULL) 
+    set->shards = (CacheShard*)calloc(shardCount, sizeof(CacheShard));
+    if (set->shards == NULL)
+    {
+        perror("Failed to allocate cache shards");
+        free(set);
+        return NULL;
+    }
+    for (unsigned int i = 0; i < shardCount; i++)
+    {
+        set->shards[i].index = createBlockIndex(0);
+        if (set->shards[i].index == NULL || initReplacementState(&(set->shards[i].policy), policy) < 0)
         {
-            free(cacheData->data);
-            cacheData->data = NULL;
+            destroyBlockIndex(set->shards[i].index);
+            destroyCacheShards(set->shards, i);
+            free(set);
+            return NULL;
         }
+        pthread_rwlock_init(&(set->shards[i].lock), NULL);
+        set->shards[i].tailAtime = CACHE_NO_VICTIM;
     }
+    set->shardCount = shardCount;
+    set->sharedHits = set->shards[0].policy.ops->sharedHit;
+
+    set->blockSize = blockSize;
+    set->blockShift = 0;
+    while (((size_t)1 << set->blockShift) < blockSize)
+    {
+        set->blockShift++;
+    }
+    set->pool = pool;
+    set->residentBytes = 0;
+    set->capacityBytes = capacityBytes;
+    set->maxIOBytes = (maxIOBytes > blockSize) ? maxIOBytes : blockSize;
+    set->writeMissPolicy = 0;
+    set->writePolicy = 0;
+    set->dirtyBytes = 0;
+    set->dirtySince = 0;
+    return set;
 }
 
-void cleanUpCache(AVLTreeNode* root, LRUHash* hostHash, LRUHash* devHash) 
+// 调用者需保证没有其他线程在使用该集合
+void cleanUpCache(CacheSet* set) 
 {
-    
-    if (hostHash != NULL) 
+    if (set == NULL)
     {
-        freeHash(hostHash);
-        hostHash = NULL;
+        return;
     }
 
-    if (devHash != NULL) 
+    for (unsigned int i = 0; i < set->shardCount; i++)
     {
-        freeHash(devHash);
-        devHash = NULL;
+        ReplacementState* policy = &(set->shards[i].policy);
+        cache* entry;
+        while ((entry = replacementNext(policy, NULL)) != NULL) 
+        {
+            if (ATOMIC_LOAD(&(entry->pins)) != 0)
+            {
+                fprintf(stderr, "Warning: Block at offset %ld is still referenced on close\n", (long)entry->offset);
+            }
+            replacementRemove(policy, entry);
+            freeBlock(set->pool, entry);
+        }
     }
+    ATOMIC_SUB(&(cacheBudget.residentBytes), set->residentBytes);
+    ATOMIC_SUB(&(cacheBudget.dirtyBytes), set->dirtyBytes);
+
+    destroyCacheShards(set->shards, set->shardCount);
+    free(set);
+}
+
+CacheShard* lockCacheShard(CacheSet* set, off_t offset)
+{
+    CacheShard* shard = CACHE_SHARD_OF(set, offset);
+    pthread_rwlock_wrlock(&(shard->lock));
+    return shard;
+}
+
+CacheShard* lockCacheShardShared(CacheSet* set, off_t offset)
+{
+    CacheShard* shard = CACHE_SHARD_OF(set, offset);
+    pthread_rwlock_rdlock(&(shard->lock));
+    return shard;
+}
 
-    if(root != NULL)
+// 解锁前刷新 tailAtime。读锁下的命中也可能改变队尾块的 atime，因此读写锁都刷新；值不变时不写
+void unlockCacheShard(CacheShard* shard)
+{
+    cache* tail = replacementNext(&(shard->policy), NULL);
+    unsigned long atime = (tail != NULL) ? ATOMIC_LOAD(&(tail->atime)) : CACHE_NO_VICTIM;
+    if (ATOMIC_LOAD(&(shard->tailAtime)) != atime)
     {
-        cleanUpAVLTreeData(&root); 
-        cleanUpAVLTree(&root); 
+        ATOMIC_STORE(&(shard->tailAtime), atime);
     }
+    pthread_rwlock_unlock(&(shard->lock));
+}
 
+bool isCacheResident(CacheSet* set, off_t offset)
+{
+    CacheShard* shard = lockCacheShardShared(set, offset);
+    bool resident = lookupBlockIndex(shard->index, BLOCK_KEY(set, offset)) != NULL;
+    unlockCacheShard(shard);
+    return resident;
 }
 
 
-void createCache(AVLTreeNode** root, LRUHash* Hash, off_t offset, void* data)
+cache* allocCache(CacheSet* set, off_t offset)
 {
-    cache* newCache = (cache*)malloc(sizeof(cache));
+    cache* newCache = allocBlock(set->pool);
     if (newCache == NULL) 
     {
-        perror("Failed to allocate memory for cache");
-        return; 
+        fprintf(stderr, "Error: Failed to allocate cache block\n");
+        return NULL; 
     }
 
     newCache->offset = offset;
-    newCache->data = (void*)malloc(CACHE_SIZE);
-    if (newCache->data == NULL) 
-    {
-        perror("Failed to allocate memory for cache data");
-        free(newCache); 
-        return; 
-    }
+    return newCache;
+}
 
-    memcpy(newCache->data, data, CACHE_SIZE);
-    newCache->dirty = 0; 
+// 将 allocCache 得到的缓存项加入索引与替换策略，失败时归还该块
+int insertCache(CacheSet* set, cache* cache)
+{
+    CacheShard* shard = CACHE_SHARD_OF(set, cache->offset);
 
-    long key = (long)(offset / CACHE_SIZE);
-    createAndAddLRUNode(key, Hash);
-    createAndInsertNode(root, key, (void*)newCache);
+    if (insertBlockIndex(shard->index, BLOCK_KEY(set, cache->offset), cache) < 0)
+    {
+        freeBlock(set->pool, cache);
+        return -1;
+    }
+    replacementInsert(&(shard->policy), cache, BLOCK_KEY(set, cache->offset));
+    ATOMIC_ADD(&(set->residentBytes), set->blockSize);
+    ATOMIC_ADD(&(cacheBudget.residentBytes), set->blockSize);
+    return 0;
 }
 
-
-cache* findCache(AVLTreeNode* root, off_t offset) 
+cache* createCache(CacheSet* set, off_t offset, const void* data)
 {
-    AVLTreeNode* node = searchNodeByKey(root, (long)(offset / CACHE_SIZE));
-    if (node == NULL) 
+    cache* newCache = allocCache(set, offset);
+    if (newCache == NULL) 
     {
-        fprintf(stderr, "Node not found for offset %ld\n", (long)(offset / CACHE_SIZE));
-        return NULL;
+        return NULL; 
     }
-    if (node->data == NULL) 
+
+    memcpy(newCache->data, data, set->blockSize);
+
+    if (insertCache(set, newCache) < 0)
     {
-        fprintf(stderr, "No data found in node for offset %ld\n", (long)(offset / CACHE_SIZE));
         return NULL;
     }
-    return (cache*)node->data;
+    return newCache;
 }
 
-void deleteTailCache(AVLTreeNode** root, LRUHash* Hash)
+
+cache* findCache(CacheSet* set, off_t offset) 
 {
-    long key = deleteLRUTail(Hash);
-    cache* cache = findCache(*root, (off_t)(key*CACHE_SIZE));
-    if (cache != NULL)
-    {
-        if(cache->data != NULL)
-        {
-            free(cache->data);
-            cache->data = NULL;
-        }
-        free(cache);
-        cache = NULL;
-    }
-    
-    deleteAndFreeNode(root, key);
+    return lookupBlockIndex(CACHE_SHARD_OF(set, offset)->index, BLOCK_KEY(set, offset));
 }
 
+void deleteCache(CacheSet* set, cache* cache)
+{
+    CacheShard* shard = CACHE_SHARD_OF(set, cache->offset);
+
+    clearCacheDirty(set, cache);
+    replacementRemove(&(shard->policy), cache);
+    removeBlockIndex(shard->index, BLOCK_KEY(set, cache->offset));
+    freeBlock(set->pool, cache);
+    ATOMIC_SUB(&(set->residentBytes), set->blockSize);
+    ATOMIC_SUB(&(cacheBudget.residentBytes), set->blockSize);
+}
 
-void printAVLTreeTraversalResults(AVLTreeNode* root, LRUHash* Hash) 
+// 与 deleteCache 相同，但通知替换策略这是一次淘汰，以便记入淘汰历史
+void evictCache(CacheSet* set, cache* cache)
 {
-    printf("AVL 树的中序遍历结果：\n");
-    inorderTraversal(root);
-    printf("\n");
+    CacheShard* shard = CACHE_SHARD_OF(set, cache->offset);
+    long key = BLOCK_KEY(set, cache->offset);
+
+    clearCacheDirty(set, cache);
+    replacementEvict(&(shard->policy), cache, key);
+    removeBlockIndex(shard->index, key);
+    freeBlock(set->pool, cache);
+    ATOMIC_SUB(&(set->residentBytes), set->blockSize);
+    ATOMIC_SUB(&(cacheBudget.residentBytes), set->blockSize);
+}
 
-    printf("AVL 树的先序遍历结果：\n");
-    preorderTraversal(root);
-    printf("\n");
+void deleteTailCache(CacheSet* set, CacheShard* shard)
+{
+    cache* victim = replacementVictim(&(shard->policy));
+    if (victim == NULL)
+    {
+        fprintf(stderr, "Error: No evictable cache entry\n");
+        return;
+    }
 
-    printLRUList(Hash);
+    evictCache(set, victim);
 }
 
+void markCacheDirty(CacheSet* set, cache* cache)
+{
+    if (IS_CACHE_DIRTY(cache))
+    {
+        return;
+    }
 
-/*
-int main() {
-    // 初始化缓存
-    initializeCache();
-    
-   
-    createCache(4096 * 0, "Data at offset");
-    printAVLTreeTraversalResults();
+    SET_CACHE_DIRTY(cache);
+    if (ATOMIC_ADD(&(set->dirtyBytes), set->blockSize) == set->blockSize)
+    {
+        ATOMIC_STORE(&(set->dirtySince), getMonotonicMs());
+    }
+    ATOMIC_ADD(&(cacheBudget.dirtyBytes), set->blockSize);
+}
 
-    createCache(4096 * 1, "Data at offset");
-    printAVLTreeTraversalResults();
+void clearCacheDirty(CacheSet* set, cache* cache)
+{
+    if (!IS_CACHE_DIRTY(cache))
+    {
+        return;
+    }
 
-    deleteTailCache();
-    printAVLTreeTraversalResults();
-    
-    createCache(4096 * 0, "Data at offset");
-    printAVLTreeTraversalResults();
+    CLEAR_CACHE_DIRTY(cache);
+    ATOMIC_SUB(&(set->dirtyBytes), set->blockSize);
+    ATOMIC_SUB(&(cacheBudget.dirtyBytes), set->blockSize);
+}
 
 
+void printCacheIndex(CacheSet* set) 
+{
+    for (unsigned int n = 0; n < set->shardCount; n++)
+    {
+        BlockIndex* index = set->shards[n].index;
 
-    // 清理缓存
-    printf("\n\n清理缓存：\n");
-    cleanUpCache();
-    printf("缓存已清理\n");
+        printf("分片 %u 块索引：块大小 %zu，容量 %zu，已用 %zu\n", n, set->blockSize, index->capacity, index->size);
+        for (size_t i = 0; i < index->capacity; i++)
+        {
+            if (index->slots[i].key != BLOCK_INDEX_EMPTY_KEY)
+            {
+                printf("slot %zu: key %ld, offset %ld, dirty %d\n",
+                       i,
+                       index->slots[i].key,
+                       (long)index->slots[i].entry->offset,
+                       IS_CACHE_DIRTY(index->slots[i].entry));
+            }
+        }
 
-    return 0;
+        printf("替换策略 %s\n", set->shards[n].policy.ops->name);
+        for (int i = 0; i < POLICY_MAX_LISTS; i++)
+        {
+            printLRUList(&(set->shards[n].policy.lists[i]));
+        }
+    }
 }
-
-
-*/
\ No newline at end of file
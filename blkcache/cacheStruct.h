@@ -2,25 +2,120 @@
 #define CACHE_STRUCT_H
 
 #include <stdbool.h>
+#include <pthread.h>
+#include <sys/types.h>
 
-#include "AVLTree.h"
-#include "lru.h"
+#include "blockIndex.h"
+#include "blockPool.h"
+#include "cacheStats.h"
+#include "replacementPolicy.h"
 
 
+#define CACHE_FLAG_DIRTY 0x1
+#define CACHE_FLAG_READAHEAD 0x2
+#define CACHE_FLAG_WRITEBACK 0x4
+#define CACHE_FLAG_FRESH 0x8        // 未命中时读入、还没被读过
+
+#define CACHE_DEFAULT_SHARD_COUNT 32
+#define CACHE_MAX_SHARD_COUNT 256
+#define CACHE_VICTIM_SAMPLE 8       // 选淘汰分片时每个集合最多比较的非空分片数
+#define CACHE_NO_VICTIM (~0UL)      // 分片为空时的 tailAtime
+
+#define ATOMIC_LOAD(p) __atomic_load_n((p), __ATOMIC_RELAXED)
+#define ATOMIC_STORE(p, v) __atomic_store_n((p), (v), __ATOMIC_RELAXED)
+#define ATOMIC_ADD(p, v) __atomic_add_fetch((p), (v), __ATOMIC_RELAXED)
+#define ATOMIC_SUB(p, v) __atomic_sub_fetch((p), (v), __ATOMIC_RELAXED)
+
+#define IS_CACHE_DIRTY(c) (((c)->flags & CACHE_FLAG_DIRTY) != 0)
+#define SET_CACHE_DIRTY(c) ((c)->flags |= CACHE_FLAG_DIRTY)
+#define CLEAR_CACHE_DIRTY(c) ((c)->flags &= ~CACHE_FLAG_DIRTY)
+
+// 正在后台写回或被调用者引用的块不能淘汰。pins 以 acquire 读取，与 putBlockRef 的 release 配对，
+// 借用者对块数据的最后一次访问先于之后的回收与复用
+#define IS_CACHE_BUSY(c) (((c)->flags & CACHE_FLAG_WRITEBACK) || __atomic_load_n(&((c)->pins), __ATOMIC_ACQUIRE) != 0)
+
 typedef struct cache
 {
     off_t offset;
     void* data;
-    bool dirty;
+    unsigned int flags;
+    unsigned int pins;          // getBlockRef 借出的引用数，非 0 时不淘汰
+    unsigned char policyList;   // 所在的替换策略链表
+    unsigned char freq;         // 替换策略使用的访问计数
+    unsigned short bufferSlot;  // 数据所在内存段在 I/O 引擎中的登记号
+    unsigned long atime;
+    struct cache* lruPre;
+    struct cache* lruNext;
 }cache;
 
-#define CACHE_SIZE 512
+// 按块号分片的索引与替换状态，每个分片一把读写锁：
+// 替换策略的命中操作只改缓存项内的原子字段时，读命中只需持读锁。统计计数也按分片存放，各线程不争用同一份计数
+typedef struct CacheShard
+{
+    pthread_rwlock_t lock;
+    BlockIndex* index;
+    ReplacementState policy;
+    unsigned long tailAtime;    // 下一个待淘汰块的访问时间，解锁前更新，选淘汰分片时不加锁读取
+    unsigned long writeEpoch;   // 分片内的块每次写入设备后加一，读盘期间变化过的未命中块不装入缓存
+    CacheStats stats;
+} CacheShard;
+
+// 单个 fd 的缓存集合：块大小、块池与各分片；字节计数用原子操作维护
+typedef struct CacheSet
+{
+    size_t blockSize;
+    unsigned int blockShift;
+    BlockPool* pool;
+    unsigned int shardCount;
+    CacheShard* shards;
+    int sharedHits;     // 替换策略允许在分片读锁下处理命中
+    size_t residentBytes;
+    size_t capacityBytes;   // 单个 fd 的容量上限，0 表示只受全局预算限制
+    size_t maxIOBytes;      // 合并读/写回时单次 I/O 的最大字节数
+    int writeMissPolicy;    // CACHE_WRITE_ALLOCATE 或 CACHE_WRITE_NO_ALLOCATE
+    int writePolicy;        // CACHE_WRITE_BACK、CACHE_WRITE_THROUGH 或 CACHE_WRITE_AROUND
+    size_t dirtyBytes;
+    unsigned long long dirtySince;  // 最早一批未回写脏数据产生的时间（毫秒）
+    unsigned int victimCursor;      // 轮流从不同分片开始抽样
+} CacheSet;
+
+// 进程内所有 fd 共享的内存预算
+typedef struct CacheBudget
+{
+    size_t limitBytes;
+    size_t residentBytes;
+    size_t dirtyBytes;
+} CacheBudget;
+
+#define CACHE_DEFAULT_MEMORY_LIMIT (64UL << 20)
+
+extern CacheBudget cacheBudget;
+
+#define BLOCK_KEY(set, offset) ((long)((offset) >> (set)->blockShift))
+#define CACHE_SHARD_OF(set, offset) (&(set)->shards[BLOCK_KEY(set, offset) & ((set)->shardCount - 1)])
+// 计入 offset 所在分片的统计，不需要持有分片锁
+#define CACHE_STAT_ADD(set, offset, field, v) ATOMIC_ADD(&(CACHE_SHARD_OF(set, offset)->stats.field), (v))
+
+CacheSet* createCacheSet(BlockPool* pool, size_t blockSize, size_t capacityBytes, size_t maxIOBytes,
+                         unsigned int shardCount, int policy);
+CacheShard* lockCacheShard(CacheSet* set, off_t offset);
+CacheShard* lockCacheShardShared(CacheSet* set, off_t offset);
+void unlockCacheShard(CacheShard* shard);
+bool isCacheResident(CacheSet* set, off_t offset);
 
-void createCache(AVLTreeNode **root, LRUHash *Hash, off_t offset, void *data);
-cache* findCache(AVLTreeNode *root, off_t offset);
-void deleteTailCache(AVLTreeNode **root, LRUHash *Hash);
-void cleanUpCache(AVLTreeNode *root, LRUHash *host_hash, LRUHash *devHash);
+// 以下函数的调用者需持有 offset 所在分片的锁（findCache 持读锁即可，其余需写锁）
+cache* allocCache(CacheSet* set, off_t offset);
+int insertCache(CacheSet* set, cache* cache);
+cache* createCache(CacheSet* set, off_t offset, const void* data);
+cache* findCache(CacheSet* set, off_t offset);
+void deleteCache(CacheSet* set, cache* cache);
+void evictCache(CacheSet* set, cache* cache);
+void deleteTailCache(CacheSet* set, CacheShard* shard);
+void cleanUpCache(CacheSet* set);
+void markCacheDirty(CacheSet* set, cache* cache);
+void clearCacheDirty(CacheSet* set, cache* cache);
+unsigned long long getMonotonicMs(void);
 
-void printAVLTreeTraversalResults(AVLTreeNode *root, LRUHash *Hash);
+void printCacheIndex(CacheSet* set);
 
 #endif 
\ No newline at end of file
@@ -0,0 +1,254 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <sched.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/stat.h>
+
+#include "cacheTrace.h"
+#include "cacheStruct.h"
+#include "hashTable.h"
+
+// 每个线程一块记录缓冲，记录时不取任何锁；缓冲满时由所属线程以 O_APPEND 直接写入文件。
+// busy 只由所属线程修改：停止记录时先清 cacheTraceActive，再等各缓冲的 busy 归零，之后才能读写缓冲与关闭文件
+typedef struct TraceBuffer
+{
+    struct TraceBuffer* next;
+    struct TraceBuffer* prev;
+    int busy;
+    unsigned int count;
+    CacheTraceRecord records[CACHE_TRACE_BUFFER_RECORDS];
+} TraceBuffer;
+
+int cacheTraceActive = 0;
+
+// 保护缓冲链表与 traceFd 的开关
+static pthread_mutex_t traceLock = PTHREAD_MUTEX_INITIALIZER;
+static TraceBuffer* traceBuffers = NULL;
+static int traceFd = -1;
+static unsigned long long traceStartNs = 0;
+static unsigned long long droppedRecords = 0;
+static pthread_key_t traceKey;
+static pthread_once_t traceKeyOnce = PTHREAD_ONCE_INIT;
+static __thread TraceBuffer* localTraceBuffer = NULL;
+
+static void writeTraceRecords(TraceBuffer* buffer)
+{
+    const char* data = (const char*)buffer->records;
+    size_t length = (size_t)buffer->count * sizeof(CacheTraceRecord);
+    size_t done = 0;
+
+    while (done < length)
+    {
+        ssize_t n = write(traceFd, data + done, length - done);
+        if (n < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        if (n <= 0)
+        {
+            ATOMIC_ADD(&droppedRecords, (unsigned long long)((length - done) / sizeof(CacheTraceRecord)));
+            break;
+        }
+        done += (size_t)n;
+    }
+    buffer->count = 0;
+}
+
+static void unlinkTraceBuffer(TraceBuffer* buffer)
+{
+    if (buffer->prev != NULL)
+    {
+        buffer->prev->next = buffer->next;
+    }
+    else
+    {
+        traceBuffers = buffer->next;
+    }
+    if (buffer->next != NULL)
+    {
+        buffer->next->prev = buffer->prev;
+    }
+}
+
+// 线程退出时写出剩余记录并释放缓冲
+static void destroyTraceBuffer(void* arg)
+{
+    TraceBuffer* buffer = (TraceBuffer*)arg;
+
+    pthread_mutex_lock(&traceLock);
+    if (buffer->count > 0 && traceFd >= 0)
+    {
+        writeTraceRecords(buffer);
+    }
+    unlinkTraceBuffer(buffer);
+    pthread_mutex_unlock(&traceLock);
+    free(buffer);
+}
+
+static void createTraceKey(void)
+{
+    pthread_key_create(&traceKey, destroyTraceBuffer);
+}
+
+static TraceBuffer* createTraceBuffer(void)
+{
+    TraceBuffer* buffer = (TraceBuffer*)calloc(1, sizeof(TraceBuffer));
+    if (buffer == NULL)
+    {
+        perror("Failed to allocate trace buffer");
+        return NULL;
+    }
+
+    pthread_once(&traceKeyOnce, createTraceKey);
+    pthread_mutex_lock(&traceLock);
+    buffer->next = traceBuffers;
+    if (traceBuffers != NULL)
+    {
+        traceBuffers->prev = buffer;
+    }
+    traceBuffers = buffer;
+    pthread_mutex_unlock(&traceLock);
+
+    pthread_setspecific(traceKey, buffer);
+    localTraceBuffer = buffer;
+    return buffer;
+}
+
+void recordCacheTrace(int fd, int op, off_t offset, size_t length, unsigned long long timeNs)
+{
+    TraceBuffer* buffer = localTraceBuffer;
+    if (buffer == NULL && (buffer = createTraceBuffer()) == NULL)
+    {
+        return;
+    }
+
+    __atomic_store_n(&(buffer->busy), 1, __ATOMIC_SEQ_CST);
+    if (__atomic_load_n(&cacheTraceActive, __ATOMIC_SEQ_CST))
+    {
+        CacheTraceRecord* record = &(buffer->records[buffer->count++]);
+        record->timeNs = (timeNs > traceStartNs) ? timeNs - traceStartNs : 0;
+        record->offset = (uint64_t)offset;
+        record->length = (length > UINT32_MAX) ? UINT32_MAX : (uint32_t)length;
+        record->fd = (uint16_t)fd;
+        record->op = (uint8_t)op;
+        record->reserved = 0;
+
+        if (buffer->count == CACHE_TRACE_BUFFER_RECORDS)
+        {
+            writeTraceRecords(buffer);
+        }
+    }
+    __atomic_store_n(&(buffer->busy), 0, __ATOMIC_RELEASE);
+}
+
+// 普通文件记下大小，其余情况记 0，由回放工具按访问到的最大偏移估计
+static off_t getTraceOriginSize(int fd)
+{
+    struct stat st;
+    if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode))
+    {
+        return st.st_size;
+    }
+    return 0;
+}
+
+int startCacheTrace(const char* path)
+{
+    pthread_mutex_lock(&traceLock);
+    if (traceFd >= 0)
+    {
+        pthread_mutex_unlock(&traceLock);
+        fprintf(stderr, "Error: Cache trace is already running\n");
+        return -1;
+    }
+
+    int fd = open(path, O_WRONLY | O_CREAT | O_TRUNC | O_APPEND, 0644);
+    if (fd < 0)
+    {
+        pthread_mutex_unlock(&traceLock);
+        fprintf(stderr, "Error: Failed to create trace file %s: %s\n", path, strerror(errno));
+        return -1;
+    }
+
+    struct timespec now;
+    clock_gettime(CLOCK_REALTIME, &now);
+
+    CacheTraceHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, CACHE_TRACE_MAGIC, sizeof(header.magic));
+    header.version = CACHE_TRACE_VERSION;
+    header.recordSize = sizeof(CacheTraceRecord);
+    header.startTime = (uint64_t)now.tv_sec * 1000000000ULL + (uint64_t)now.tv_nsec;
+    if (write(fd, &header, sizeof(header)) != (ssize_t)sizeof(header))
+    {
+        pthread_mutex_unlock(&traceLock);
+        fprintf(stderr, "Error: Failed to write trace file %s\n", path);
+        close(fd);
+        return -1;
+    }
+
+    traceFd = fd;
+    traceStartNs = getMonotonicNs();
+    droppedRecords = 0;
+    __atomic_store_n(&cacheTraceActive, 1, __ATOMIC_SEQ_CST);
+    pthread_mutex_unlock(&traceLock);
+
+    // 已打开的 fd 的 OPEN 记录时间取 0，回放时排在最前
+    lockFdTableShared();
+    for (int i = 0; table != NULL && i < table->size; i++)
+    {
+        for (HashTableFdNode* node = table->buckets[i]; node != NULL; node = node->next)
+        {
+            if (node->set != NULL)
+            {
+                recordCacheTrace(node->fd, CACHE_TRACE_OPEN, getTraceOriginSize(node->fd), node->set->blockSize, 0);
+            }
+        }
+    }
+    unlockFdTableShared();
+    return 0;
+}
+
+int stopCacheTrace(void)
+{
+    pthread_mutex_lock(&traceLock);
+    if (traceFd < 0)
+    {
+        pthread_mutex_unlock(&traceLock);
+        return -1;
+    }
+
+    __atomic_store_n(&cacheTraceActive, 0, __ATOMIC_SEQ_CST);
+    for (TraceBuffer* buffer = traceBuffers; buffer != NULL; buffer = buffer->next)
+    {
+        // 所属线程可能正在写入最后一条记录或写出满的缓冲
+        while (__atomic_load_n(&(buffer->busy), __ATOMIC_SEQ_CST))
+        {
+            sched_yield();
+        }
+        if (buffer->count > 0)
+        {
+            writeTraceRecords(buffer);
+        }
+    }
+
+    int ret = 0;
+    if (close(traceFd) < 0)
+    {
+        perror("Failed to close trace file");
+        ret = -1;
+    }
+    traceFd = -1;
+    if (droppedRecords > 0)
+    {
+        fprintf(stderr, "Warning: %llu trace records could not be written\n", droppedRecords);
+        ret = -1;
+    }
+    pthread_mutex_unlock(&traceLock);
+    return ret;
+}
@@ -0,0 +1,54 @@
+#ifndef CACHE_TRACE_H
+#define CACHE_TRACE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/types.h>
+
+#define CACHE_TRACE_MAGIC "BLKTRC01"
+#define CACHE_TRACE_VERSION 1
+#define CACHE_TRACE_BUFFER_RECORDS 4096     // 每个线程攒够这么多条记录才写一次文件
+
+#define CACHE_TRACE_READ 0
+#define CACHE_TRACE_WRITE 1
+#define CACHE_TRACE_OPEN 2      // offset 为源文件大小（未知时为 0），length 为缓存块大小
+#define CACHE_TRACE_CLOSE 3
+
+// 记录文件：文件头之后是定长记录。各线程的记录按块追加，块之间不按时间排序，回放前需按 timeNs 排序
+typedef struct CacheTraceHeader
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t recordSize;
+    uint64_t startTime;     // 开始记录时的墙钟时间（纳秒），timeNs 相对于开始记录的时刻
+} CacheTraceHeader;
+
+typedef struct CacheTraceRecord
+{
+    uint64_t timeNs;
+    uint64_t offset;
+    uint32_t length;
+    uint16_t fd;
+    uint8_t op;
+    uint8_t reserved;
+} CacheTraceRecord;
+
+extern int cacheTraceActive;
+
+// 未开启记录时只有一次读取与判断
+#define TRACE_CACHE_ACCESS(fd, op, offset, length, timeNs) \
+    do \
+    { \
+        if (__atomic_load_n(&cacheTraceActive, __ATOMIC_RELAXED)) \
+        { \
+            recordCacheTrace((fd), (op), (offset), (length), (timeNs)); \
+        } \
+    } while (0)
+
+// 开始把所有 fd 的读写记录到 path（覆盖已有文件），已打开的 fd 先各记一条 OPEN
+int startCacheTrace(const char* path);
+// 停止记录并把各线程缓冲中的记录写入文件；进程退出前必须调用，否则缓冲中的记录会丢失
+int stopCacheTrace(void);
+void recordCacheTrace(int fd, int op, off_t offset, size_t length, unsigned long long timeNs);
+
+#endif
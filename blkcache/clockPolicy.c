@@ -0,0 +1,68 @@
+#include "cacheStruct.h"
+#include "replacementPolicy.h"
+
+// CLOCK（二次机会）：块按插入顺序排成一圈，命中只置访问位，不移动节点；
+// 淘汰时指针从最旧的块开始扫，访问位为 1 的清零后放到队头再给一次机会
+#define CLOCK_RING 0
+
+
+static void clockInsert(ReplacementState* rs, cache* entry, long key)
+{
+    (void)key;
+    policyListPush(rs, CLOCK_RING, entry);
+}
+
+// 可能在分片读锁下被多个线程同时调用
+static void clockHit(ReplacementState* rs, cache* entry)
+{
+    (void)rs;
+    if (__atomic_load_n(&(entry->freq), __ATOMIC_RELAXED) == 0)
+    {
+        __atomic_store_n(&(entry->freq), 1, __ATOMIC_RELAXED);
+    }
+}
+
+static cache* clockVictim(ReplacementState* rs)
+{
+    // 最多绕两圈：第一圈清掉所有访问位，第二圈仍找不到说明所有块都在写回或被引用
+    for (size_t budget = 2 * (size_t)rs->lists[CLOCK_RING].size + 1; budget > 0; budget--)
+    {
+        cache* hand = GET_LRU_TAIL(&(rs->lists[CLOCK_RING]));
+        if (hand == NULL)
+        {
+            return NULL;
+        }
+
+        if (hand->freq != 0 || IS_CACHE_BUSY(hand))
+        {
+            hand->freq = 0;
+            policyListRequeue(rs, CLOCK_RING, hand);
+            continue;
+        }
+        return hand;
+    }
+    return NULL;
+}
+
+static void clockEvict(ReplacementState* rs, cache* entry, long key)
+{
+    (void)key;
+    policyListRemove(rs, entry);
+}
+
+static cache* clockNext(ReplacementState* rs, cache* entry)
+{
+    return policyListsNext(rs, entry, 1);
+}
+
+const ReplacementPolicyOps clockPolicyOps =
+{
+    "clock",
+    1,
+    clockInsert,
+    clockHit,
+    clockVictim,
+    clockEvict,
+    policyListRemove,
+    clockNext,
+};
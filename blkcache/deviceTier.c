@@ -0,0 +1,655 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+
+#include "deviceTier.h"
+#include "cacheStruct.h"
+#include "singleCacheHandler.h"
+
+#define TIER_KEY(tier, offset) ((long)((offset) >> (tier)->blockShift))
+#define TIER_PAGES(slots) (((slots) + TIER_SLOTS_PER_PAGE - 1) / TIER_SLOTS_PER_PAGE)
+
+// 本层的块记录，槽号指明它在元数据槽表中的位置
+typedef struct TierRecord
+{
+    cache entry;
+    unsigned int slot;
+} TierRecord;
+
+static cache staleMarker;
+
+// 每次 ioctl 只传输 DEVICE_SECTOR_SIZE 字节，一个缓存块逐扇区定位后传输
+int readBackingBlock(int fd, pthread_mutex_t* ioLock, off_t offset, void* buf, size_t length)
+{
+    pthread_mutex_lock(ioLock);
+    for (size_t done = 0; done < length; done += DEVICE_SECTOR_SIZE)
+    {
+        if (lseek(fd, offset + (off_t)done, SEEK_SET) < 0)
+        {
+            pthread_mutex_unlock(ioLock);
+            perror("lseek");
+            return -1;
+        }
+        if (ioctl(fd, IOCTL_READ_BLOCK, (char*)buf + done) < 0)
+        {
+            pthread_mutex_unlock(ioLock);
+            perror("ioctl read second device");
+            return -1;
+        }
+    }
+    pthread_mutex_unlock(ioLock);
+    return 0;
+}
+
+int writeBackingBlock(int fd, pthread_mutex_t* ioLock, off_t offset, const void* buf, size_t length)
+{
+    pthread_mutex_lock(ioLock);
+    for (size_t done = 0; done < length; done += DEVICE_SECTOR_SIZE)
+    {
+        if (lseek(fd, offset + (off_t)done, SEEK_SET) < 0)
+        {
+            pthread_mutex_unlock(ioLock);
+            perror("lseek");
+            return -1;
+        }
+        if (ioctl(fd, IOCTL_WRITE_BLOCK, (const char*)buf + done) < 0)
+        {
+            pthread_mutex_unlock(ioLock);
+            perror("ioctl write second device");
+            return -1;
+        }
+    }
+    pthread_mutex_unlock(ioLock);
+    return 0;
+}
+
+
+static uint64_t mixTierHash(uint64_t h)
+{
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ULL;
+    h ^= h >> 33;
+    return h;
+}
+
+static uint32_t tierSlotCheck(uint64_t seed, uint64_t block, uint32_t flags)
+{
+    return (uint32_t)mixTierHash(seed ^ mixTierHash(block) ^ ((uint64_t)flags << 40));
+}
+
+static uint64_t tierSuperblockCheck(const TierSuperblock* sb)
+{
+    return mixTierHash(sb->seed ^ mixTierHash(sb->slotCount ^ ((uint64_t)sb->blockSize << 32) ^ sb->version) ^
+                       mixTierHash(sb->dataLimit));
+}
+
+// 字符设备不支持 fdatasync 时视为写入已经有序
+static int syncTierPartition(DeviceTier* tier)
+{
+    if (fdatasync(tier->fd) < 0 && errno != EINVAL && errno != EROFS)
+    {
+        perror("fdatasync cache partition");
+        return -1;
+    }
+    return 0;
+}
+
+// 以下静态函数的调用者持有 tier->lock（创建与销毁时除外）
+static void setTierSlot(DeviceTier* tier, unsigned int slot, uint64_t block, uint32_t flags)
+{
+    if (tier->slots == NULL)
+    {
+        return;
+    }
+
+    TierMetaSlot* s = &(tier->slots[slot]);
+    s->block = (flags != 0) ? block : 0;
+    s->flags = flags;
+    s->check = (flags != 0) ? tierSlotCheck(tier->seed, block, flags) : 0;
+
+    size_t page = slot / TIER_SLOTS_PER_PAGE;
+    if (!tier->dirtyPages[page])
+    {
+        tier->dirtyPages[page] = 1;
+        tier->dirtyPageCount++;
+    }
+}
+
+// 先让已写入缓存分区的数据落盘，再写变更过的槽表页
+static int commitTierMeta(DeviceTier* tier)
+{
+    if (tier->slots == NULL || tier->dirtyPageCount == 0)
+    {
+        return 0;
+    }
+    if (syncTierPartition(tier) < 0)
+    {
+        return -1;
+    }
+
+    for (size_t page = 0; page < TIER_PAGES(tier->slotCount); page++)
+    {
+        if (!tier->dirtyPages[page])
+        {
+            continue;
+        }
+
+        off_t pos = tier->metaOffset + (off_t)((page + 1) * TIER_META_PAGE);
+        if (pwrite(tier->fd, (char*)tier->slots + page * TIER_META_PAGE, TIER_META_PAGE, pos) != (ssize_t)TIER_META_PAGE)
+        {
+            fprintf(stderr, "Error writing device tier metadata of fd %d at offset %lld\n", tier->fd, (long long)pos);
+            return -1;
+        }
+        tier->dirtyPages[page] = 0;
+    }
+    if (syncTierPartition(tier) < 0)
+    {
+        return -1;
+    }
+
+    tier->dirtyPageCount = 0;
+    destroyBlockIndex(tier->stale);
+    tier->stale = createBlockIndex(0);
+    return 0;
+}
+
+// 记不下的块无法单独判断，stale 置空后任何待提交的变更都要先提交
+static void markTierStale(DeviceTier* tier, long key)
+{
+    if (tier->slots == NULL || tier->stale == NULL || lookupBlockIndex(tier->stale, key) != NULL)
+    {
+        return;
+    }
+    if (insertBlockIndex(tier->stale, key, &staleMarker) < 0)
+    {
+        destroyBlockIndex(tier->stale);
+        tier->stale = NULL;
+    }
+}
+
+static int isTierStale(DeviceTier* tier, long key)
+{
+    if (tier->slots == NULL || tier->dirtyPageCount == 0)
+    {
+        return 0;
+    }
+    return tier->stale == NULL || lookupBlockIndex(tier->stale, key) != NULL;
+}
+
+static cache* insertTierRecord(DeviceTier* tier, off_t offset, unsigned int slot)
+{
+    long key = TIER_KEY(tier, offset);
+    TierRecord* record = &(tier->records[slot]);
+
+    memset(record, 0, sizeof(*record));
+    if (insertBlockIndex(tier->index, key, &(record->entry)) < 0)
+    {
+        fprintf(stderr, "Error: Failed to record device tier block at offset %lld\n", (long long)offset);
+        return NULL;
+    }
+    record->entry.offset = offset;
+    record->slot = slot;
+    replacementInsert(&(tier->policy), &(record->entry), key);
+    tier->residentBytes += tier->blockSize;
+    return &(record->entry);
+}
+
+static void removeTierRecord(DeviceTier* tier, cache* entry, int evicted)
+{
+    TierRecord* record = (TierRecord*)entry;
+    long key = TIER_KEY(tier, entry->offset);
+
+    if (evicted)
+    {
+        replacementEvict(&(tier->policy), entry, key);
+    }
+    else
+    {
+        replacementRemove(&(tier->policy), entry);
+    }
+    removeBlockIndex(tier->index, key);
+    if (IS_CACHE_DIRTY(entry))
+    {
+        tier->dirtyBytes -= tier->blockSize;
+    }
+    tier->residentBytes -= tier->blockSize;
+
+    tier->freeSlots[tier->freeCount++] = record->slot;
+    if (tier->slots != NULL)
+    {
+        setTierSlot(tier, record->slot, 0, 0);
+        markTierStale(tier, key);
+    }
+}
+
+static void setTierRecordDirty(DeviceTier* tier, cache* entry, int dirty)
+{
+    if (dirty == IS_CACHE_DIRTY(entry))
+    {
+        return;
+    }
+
+    if (dirty)
+    {
+        SET_CACHE_DIRTY(entry);
+        tier->dirtyBytes += tier->blockSize;
+    }
+    else
+    {
+        CLEAR_CACHE_DIRTY(entry);
+        tier->dirtyBytes -= tier->blockSize;
+    }
+    setTierSlot(tier, ((TierRecord*)entry)->slot, (uint64_t)TIER_KEY(tier, entry->offset),
+                TIER_SLOT_VALID | (dirty ? TIER_SLOT_DIRTY : 0));
+}
+
+static int writeBackTierBlock(DeviceTier* tier, cache* entry)
+{
+    if (pread(tier->fd, tier->buffer, tier->blockSize, entry->offset) != (ssize_t)tier->blockSize)
+    {
+        fprintf(stderr, "Error reading cache partition of fd %d at offset %lld\n", tier->fd, (long long)entry->offset);
+        return -1;
+    }
+    if (writeBackingBlock(tier->fd, tier->ioLock, entry->offset, tier->buffer, tier->blockSize) < 0)
+    {
+        return -1;
+    }
+
+    ATOMIC_ADD(&(tier->writeBackBytes), tier->blockSize);
+    setTierRecordDirty(tier, entry, 0);
+    return 0;
+}
+
+// 淘汰本层的一个块，脏块先写回后端设备；写回失败时保留该块
+static int evictDeviceTierTail(DeviceTier* tier)
+{
+    cache* victim = replacementVictim(&(tier->policy));
+    if (victim == NULL)
+    {
+        return -1;
+    }
+
+    if (IS_CACHE_DIRTY(victim) && writeBackTierBlock(tier, victim) < 0)
+    {
+        fprintf(stderr, "Write back failed for device tier block at offset %ld, keep it cached\n", (long)victim->offset);
+        replacementHit(&(tier->policy), victim);
+        return -1;
+    }
+
+    removeTierRecord(tier, victim, 1);
+    return 0;
+}
+
+// 清空槽表并写入新的超级块；槽表先落盘，新超级块不会指向旧槽
+static int formatTierMeta(DeviceTier* tier)
+{
+    tier->seed = mixTierHash(((uint64_t)getMonotonicMs() << 20) ^ (uint64_t)getpid() ^ (uint64_t)(uintptr_t)tier);
+    memset(tier->slots, 0, TIER_PAGES(tier->slotCount) * TIER_META_PAGE);
+    memset(tier->dirtyPages, 0, TIER_PAGES(tier->slotCount));
+    tier->dirtyPageCount = 0;
+
+    size_t tableBytes = TIER_PAGES(tier->slotCount) * TIER_META_PAGE;
+    if (pwrite(tier->fd, tier->slots, tableBytes, tier->metaOffset + (off_t)TIER_META_PAGE) != (ssize_t)tableBytes ||
+        syncTierPartition(tier) < 0)
+    {
+        fprintf(stderr, "Error formatting device tier metadata of fd %d\n", tier->fd);
+        return -1;
+    }
+
+    TierSuperblock* sb = (TierSuperblock*)tier->buffer;
+    memset(tier->buffer, 0, TIER_META_PAGE);
+    memcpy(sb->magic, TIER_META_MAGIC, sizeof(sb->magic));
+    sb->version = TIER_META_VERSION;
+    sb->blockSize = (uint32_t)tier->blockSize;
+    sb->slotCount = tier->slotCount;
+    sb->dataLimit = (uint64_t)tier->metaOffset;
+    sb->seed = tier->seed;
+    sb->check = tierSuperblockCheck(sb);
+    if (pwrite(tier->fd, tier->buffer, TIER_META_PAGE, tier->metaOffset) != (ssize_t)TIER_META_PAGE ||
+        syncTierPartition(tier) < 0)
+    {
+        fprintf(stderr, "Error writing device tier superblock of fd %d\n", tier->fd);
+        return -1;
+    }
+    return 0;
+}
+
+// 槽数变化时不沿用旧槽表：把其中的脏块写回后端设备后重新格式化
+static int retireTierMeta(DeviceTier* tier, uint64_t seed, size_t oldCount)
+{
+    size_t tableBytes = TIER_PAGES(oldCount) * TIER_META_PAGE;
+    TierMetaSlot* old = NULL;
+    if (posix_memalign((void**)&old, TIER_META_PAGE, tableBytes) != 0)
+    {
+        perror("Failed to allocate device tier metadata");
+        return -1;
+    }
+    if (pread(tier->fd, old, tableBytes, tier->metaOffset + (off_t)TIER_META_PAGE) != (ssize_t)tableBytes)
+    {
+        fprintf(stderr, "Error reading device tier metadata of fd %d\n", tier->fd);
+        free(old);
+        return -1;
+    }
+
+    int ret = 0;
+    for (size_t i = 0; i < oldCount && ret == 0; i++)
+    {
+        TierMetaSlot* s = &(old[i]);
+        if ((s->flags & TIER_SLOT_DIRTY) && (s->flags & TIER_SLOT_VALID) && s->check == tierSlotCheck(seed, s->block, s->flags))
+        {
+            off_t offset = (off_t)(s->block << tier->blockShift);
+            if (pread(tier->fd, tier->buffer, tier->blockSize, offset) != (ssize_t)tier->blockSize ||
+                writeBackingBlock(tier->fd, tier->ioLock, offset, tier->buffer, tier->blockSize) < 0)
+            {
+                fprintf(stderr, "Error writing back device tier block at offset %lld\n", (long long)offset);
+                ret = -1;
+            }
+            else
+            {
+                ATOMIC_ADD(&(tier->writeBackBytes), tier->blockSize);
+            }
+        }
+    }
+    free(old);
+    return (ret == 0) ? formatTierMeta(tier) : -1;
+}
+
+// 按槽表重建本层，耗时只与槽表大小有关；分区上没有有效的元数据时格式化
+static int recoverTierMeta(DeviceTier* tier)
+{
+    TierSuperblock sb;
+    if (pread(tier->fd, tier->buffer, TIER_META_PAGE, tier->metaOffset) != (ssize_t)TIER_META_PAGE)
+    {
+        fprintf(stderr, "Error reading device tier superblock of fd %d\n", tier->fd);
+        return -1;
+    }
+    memcpy(&sb, tier->buffer, sizeof(sb));
+
+    if (memcmp(sb.magic, TIER_META_MAGIC, sizeof(sb.magic)) != 0 || sb.version != TIER_META_VERSION ||
+        sb.check != tierSuperblockCheck(&sb))
+    {
+        return formatTierMeta(tier);
+    }
+    if (sb.blockSize != tier->blockSize || sb.dataLimit != (uint64_t)tier->metaOffset)
+    {
+        fprintf(stderr, "Error: Device tier metadata of fd %d was written with block size %u and data limit %llu\n",
+                tier->fd, sb.blockSize, (unsigned long long)sb.dataLimit);
+        return -1;
+    }
+    if (sb.slotCount != tier->slotCount)
+    {
+        return retireTierMeta(tier, sb.seed, (size_t)sb.slotCount);
+    }
+
+    size_t tableBytes = TIER_PAGES(tier->slotCount) * TIER_META_PAGE;
+    if (pread(tier->fd, tier->slots, tableBytes, tier->metaOffset + (off_t)TIER_META_PAGE) != (ssize_t)tableBytes)
+    {
+        fprintf(stderr, "Error reading device tier metadata of fd %d\n", tier->fd);
+        return -1;
+    }
+
+    tier->seed = sb.seed;
+    for (size_t i = 0; i < tier->slotCount; i++)
+    {
+        TierMetaSlot* s = &(tier->slots[i]);
+        off_t offset = (off_t)(s->block << tier->blockShift);
+        if (!(s->flags & TIER_SLOT_VALID) || s->check != tierSlotCheck(tier->seed, s->block, s->flags) ||
+            offset + (off_t)tier->blockSize > tier->metaOffset || lookupBlockIndex(tier->index, (long)s->block) != NULL)
+        {
+            memset(s, 0, sizeof(*s));
+            continue;
+        }
+
+        cache* entry = insertTierRecord(tier, offset, (unsigned int)i);
+        if (entry == NULL)
+        {
+            return -1;
+        }
+        if (s->flags & TIER_SLOT_DIRTY)
+        {
+            SET_CACHE_DIRTY(entry);
+            tier->dirtyBytes += tier->blockSize;
+        }
+    }
+    return 0;
+}
+
+static int initTierMeta(DeviceTier* tier, off_t metaOffset)
+{
+    tier->metaOffset = metaOffset;
+    size_t pages = TIER_PAGES(tier->slotCount);
+
+    if (posix_memalign((void**)&(tier->slots), TIER_META_PAGE, pages * TIER_META_PAGE) != 0)
+    {
+        tier->slots = NULL;
+        perror("Failed to allocate device tier metadata");
+        return -1;
+    }
+    memset(tier->slots, 0, pages * TIER_META_PAGE);
+    tier->dirtyPages = (unsigned char*)calloc(pages, 1);
+    tier->stale = createBlockIndex(0);
+    if (tier->dirtyPages == NULL || tier->stale == NULL || recoverTierMeta(tier) < 0)
+    {
+        return -1;
+    }
+    return 0;
+}
+
+DeviceTier* createDeviceTier(int fd, pthread_mutex_t* ioLock, size_t blockSize, size_t capacityBytes, int policy,
+                             off_t metaOffset)
+{
+    DeviceTier* tier = (DeviceTier*)calloc(1, sizeof(DeviceTier));
+    if (tier == NULL)
+    {
+        perror("Failed to allocate device tier");
+        return NULL;
+    }
+
+    // 中转缓冲区也用来读写元数据页，至少一页并按页对齐
+    if (posix_memalign(&(tier->buffer), TIER_META_PAGE, (blockSize > TIER_META_PAGE) ? blockSize : TIER_META_PAGE) != 0)
+    {
+        tier->buffer = NULL;
+    }
+    // 块记录按槽号预分配，不持久化时槽号只用来定位记录
+    tier->slotCount = capacityBytes / blockSize;
+    tier->records = (TierRecord*)calloc(tier->slotCount + 1, sizeof(TierRecord));
+    tier->freeSlots = (unsigned int*)malloc((tier->slotCount + 1) * sizeof(unsigned int));
+    tier->index = createBlockIndex(0);
+    if (tier->buffer == NULL || tier->records == NULL || tier->freeSlots == NULL || tier->index == NULL ||
+        initReplacementState(&(tier->policy), policy) < 0)
+    {
+        fprintf(stderr, "Error: Failed to initialize device tier\n");
+        destroyBlockIndex(tier->index);
+        free(tier->freeSlots);
+        free(tier->records);
+        free(tier->buffer);
+        free(tier);
+        return NULL;
+    }
+
+    tier->fd = fd;
+    tier->ioLock = ioLock;
+    tier->blockSize = blockSize;
+    while (((size_t)1 << tier->blockShift) < blockSize)
+    {
+        tier->blockShift++;
+    }
+    tier->capacityBytes = capacityBytes;
+    pthread_mutex_init(&(tier->lock), NULL);
+
+    if (metaOffset != 0 && initTierMeta(tier, metaOffset) < 0)
+    {
+        fprintf(stderr, "Error: Failed to load device tier metadata of fd %d\n", fd);
+        destroyDeviceTier(tier);
+        return NULL;
+    }
+
+    // 空闲槽按槽号从小到大分配
+    for (size_t i = tier->slotCount; i > 0; i--)
+    {
+        if (tier->slots == NULL || !(tier->slots[i - 1].flags & TIER_SLOT_VALID))
+        {
+            tier->freeSlots[tier->freeCount++] = (unsigned int)(i - 1);
+        }
+    }
+    return tier;
+}
+
+// 把内存层淘汰的块写入缓存分区，脏块在本层保持为脏并立即提交元数据；
+// 元数据区及之后的块不进入本层。本层放不下或写入失败时返回 -1
+int demoteDeviceTierBlock(DeviceTier* tier, off_t offset, const void* data, int dirty)
+{
+    long key = TIER_KEY(tier, offset);
+
+    if (tier->metaOffset != 0 && offset + (off_t)tier->blockSize > tier->metaOffset)
+    {
+        return -1;
+    }
+
+    pthread_mutex_lock(&(tier->lock));
+    cache* entry = lookupBlockIndex(tier->index, key);
+    while (entry == NULL && tier->residentBytes + tier->blockSize > tier->capacityBytes)
+    {
+        if (evictDeviceTierTail(tier) < 0)
+        {
+            pthread_mutex_unlock(&(tier->lock));
+            return -1;
+        }
+    }
+
+    // 盘上还有该块旧槽时先让它失效，否则异常退出后旧槽会指向新写入的数据
+    if ((isTierStale(tier, key) && commitTierMeta(tier) < 0) ||
+        pwrite(tier->fd, data, tier->blockSize, offset) != (ssize_t)tier->blockSize)
+    {
+        fprintf(stderr, "Error writing cache partition of fd %d at offset %lld\n", tier->fd, (long long)offset);
+        pthread_mutex_unlock(&(tier->lock));
+        return -1;
+    }
+
+    if (entry == NULL)
+    {
+        entry = insertTierRecord(tier, offset, tier->freeSlots[--tier->freeCount]);
+        if (entry == NULL)
+        {
+            tier->freeCount++;
+            pthread_mutex_unlock(&(tier->lock));
+            return -1;
+        }
+        setTierSlot(tier, ((TierRecord*)entry)->slot, (uint64_t)key, TIER_SLOT_VALID);
+    }
+    if (dirty)
+    {
+        setTierRecordDirty(tier, entry, 1);
+    }
+
+    // 脏块此时只在缓存分区上，提交失败时退回由调用者写回
+    int ret = 0;
+    if (dirty || tier->dirtyPageCount >= TIER_META_BATCH_PAGES)
+    {
+        ret = commitTierMeta(tier);
+        if (ret < 0 && dirty)
+        {
+            removeTierRecord(tier, entry, 0);
+        }
+    }
+    pthread_mutex_unlock(&(tier->lock));
+    return (ret < 0 && dirty) ? -1 : 0;
+}
+
+// 命中时把块从缓存分区读入 data 并移出本层，dirty 返回它是否比后端设备新；
+// data 为 NULL 表示调用者将整块覆盖，只移出不读。命中返回 1，未命中返回 0
+int promoteDeviceTierBlock(DeviceTier* tier, off_t offset, void* data, int* dirty)
+{
+    *dirty = 0;
+
+    pthread_mutex_lock(&(tier->lock));
+    cache* entry = lookupBlockIndex(tier->index, TIER_KEY(tier, offset));
+    if (entry == NULL)
+    {
+        pthread_mutex_unlock(&(tier->lock));
+        return 0;
+    }
+
+    if (data != NULL && pread(tier->fd, data, tier->blockSize, offset) != (ssize_t)tier->blockSize)
+    {
+        fprintf(stderr, "Error reading cache partition of fd %d at offset %lld\n", tier->fd, (long long)offset);
+        pthread_mutex_unlock(&(tier->lock));
+        return -1;
+    }
+
+    // 盘上的槽暂不失效：异常退出后恢复的是提升前的内容，仍比后端设备新
+    *dirty = IS_CACHE_DIRTY(entry);
+    removeTierRecord(tier, entry, 0);
+    pthread_mutex_unlock(&(tier->lock));
+    return 1;
+}
+
+// 把本层所有脏块写回后端设备并提交元数据，返回写回的块数
+size_t flushDeviceTier(DeviceTier* tier)
+{
+    size_t written = 0;
+
+    pthread_mutex_lock(&(tier->lock));
+    for (cache* entry = replacementNext(&(tier->policy), NULL); entry != NULL && tier->dirtyBytes > 0;
+         entry = replacementNext(&(tier->policy), entry))
+    {
+        if (!IS_CACHE_DIRTY(entry))
+        {
+            continue;
+        }
+        if (writeBackTierBlock(tier, entry) < 0)
+        {
+            fprintf(stderr, "Write back failed for device tier block at offset %ld\n", (long)entry->offset);
+            continue;
+        }
+        written++;
+    }
+    commitTierMeta(tier);
+    pthread_mutex_unlock(&(tier->lock));
+    return written;
+}
+
+// 内存层的块写回后端设备前调用：盘上还有该块的旧槽时先提交，避免恢复出比后端设备旧的内容
+int commitDeviceTierBlock(DeviceTier* tier, off_t offset)
+{
+    int ret = 0;
+
+    pthread_mutex_lock(&(tier->lock));
+    if (isTierStale(tier, TIER_KEY(tier, offset)))
+    {
+        ret = commitTierMeta(tier);
+    }
+    pthread_mutex_unlock(&(tier->lock));
+    return ret;
+}
+
+void destroyDeviceTier(DeviceTier* tier)
+{
+    if (tier == NULL)
+    {
+        return;
+    }
+
+    commitTierMeta(tier);
+
+    // 只释放内存中的记录，盘上的槽表保持不变，下次打开时恢复
+    cache* entry;
+    while ((entry = replacementNext(&(tier->policy), NULL)) != NULL)
+    {
+        replacementRemove(&(tier->policy), entry);
+    }
+    destroyReplacementState(&(tier->policy));
+    destroyBlockIndex(tier->index);
+    destroyBlockIndex(tier->stale);
+    pthread_mutex_destroy(&(tier->lock));
+    free(tier->slots);
+    free(tier->dirtyPages);
+    free(tier->freeSlots);
+    free(tier->records);
+    free(tier->buffer);
+    free(tier);
+}
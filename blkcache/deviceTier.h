@@ -0,0 +1,84 @@
+#ifndef DEVICE_TIER_H
+#define DEVICE_TIER_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <pthread.h>
+#include <sys/types.h>
+
+#include "blockIndex.h"
+#include "replacementPolicy.h"
+
+#define TIER_META_MAGIC "BLKTIER1"
+#define TIER_META_VERSION 1
+#define TIER_META_PAGE 4096UL
+#define TIER_META_BATCH_PAGES 16    // 干净块的元数据变更攒够这么多页才提交
+
+#define TIER_SLOT_VALID 0x1
+#define TIER_SLOT_DIRTY 0x2
+
+// 元数据区第一页为超级块，之后是槽表：NVMe 层每个容量块一个槽，记录该槽存放的块号与是否为脏
+typedef struct TierSuperblock
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t blockSize;
+    uint64_t slotCount;
+    uint64_t dataLimit;     // 元数据区的起始偏移，数据块都在它之前
+    uint64_t seed;          // 格式化时生成，参与每个槽的校验，旧格式残留的槽不会被误认
+    uint64_t check;
+} TierSuperblock;
+
+typedef struct TierMetaSlot
+{
+    uint64_t block;
+    uint32_t flags;
+    uint32_t check;
+} TierMetaSlot;
+
+#define TIER_SLOTS_PER_PAGE (TIER_META_PAGE / sizeof(TierMetaSlot))
+
+// 设备模式的 NVMe 层：内存层淘汰的块降级写入缓存分区（与后端设备同偏移），再次访问时提升回内存层。
+// 两层互斥，块只在其中一层；本层只保存元数据，脏块被本层淘汰时才写回后端设备。
+// 配置了元数据区时，槽表的变更先刷数据再批量提交：脏块降级立即提交，块移出本层后在它被改写前提交，
+// 打开时按槽表重建索引，未写回的脏块在异常退出后仍然保留
+typedef struct DeviceTier
+{
+    int fd;
+    pthread_mutex_t* ioLock;    // 所属 fd 的 lseek 与 ioctl 锁
+    size_t blockSize;
+    unsigned int blockShift;
+    size_t capacityBytes;
+    size_t residentBytes;
+    size_t dirtyBytes;
+    size_t writeBackBytes;      // 本层脏块写回后端设备的字节数
+    BlockIndex* index;
+    ReplacementState policy;
+    void* buffer;               // 从缓存分区写回后端设备时的中转缓冲区
+    off_t metaOffset;           // 元数据区在缓存分区上的偏移，0 表示不持久化
+    uint64_t seed;
+    size_t slotCount;
+    TierMetaSlot* slots;        // 槽表在内存中的副本，按页提交
+    struct TierRecord* records; // 按槽号预分配的块记录，降级与淘汰时复用
+    unsigned int* freeSlots;
+    size_t freeCount;
+    unsigned char* dirtyPages;  // 尚未提交的槽表页
+    size_t dirtyPageCount;
+    BlockIndex* stale;          // 已移出本层、但盘上的槽还没失效的块
+    pthread_mutex_t lock;       // 取锁顺序：分片锁在前，本锁在后
+} DeviceTier;
+
+
+DeviceTier* createDeviceTier(int fd, pthread_mutex_t* ioLock, size_t blockSize, size_t capacityBytes, int policy,
+                             off_t metaOffset);
+int demoteDeviceTierBlock(DeviceTier* tier, off_t offset, const void* data, int dirty);
+int promoteDeviceTierBlock(DeviceTier* tier, off_t offset, void* data, int* dirty);
+size_t flushDeviceTier(DeviceTier* tier);
+int commitDeviceTierBlock(DeviceTier* tier, off_t offset);
+void destroyDeviceTier(DeviceTier* tier);
+
+// 通过 ioctl 读写后端设备的一个块，length 为扇区的整数倍；整个块的 lseek 与 ioctl 都在 ioLock 下执行
+int readBackingBlock(int fd, pthread_mutex_t* ioLock, off_t offset, void* buf, size_t length);
+int writeBackingBlock(int fd, pthread_mutex_t* ioLock, off_t offset, const void* buf, size_t length);
+
+#endif
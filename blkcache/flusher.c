@@ -0,0 +1,264 @@
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+
+#include "flusher.h"
+#include "cacheStruct.h"
+#include "hashTable.h"
+#include "singleCacheHandler.h"
+
+// flusherLock 保护线程状态与两个条件变量；缓存数据本身由 fdTableLock 与分片锁保护
+static pthread_mutex_t flusherLock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t flusherWakeCond;
+static pthread_cond_t flushDoneCond = PTHREAD_COND_INITIALIZER;
+static pthread_t flusherThread;
+static CacheFlusherOptions flusherOptions;
+static int flusherRunning = 0;
+static unsigned long flushPassCount = 0;   // 只由回写线程读写
+
+
+// 未配置的阈值按当前全局预算的百分比计算，预算调整后随之变化
+static size_t resolveThreshold(size_t configured, size_t percent)
+{
+    return (configured != 0) ? configured : ATOMIC_LOAD(&(cacheBudget.limitBytes)) / 100 * percent;
+}
+
+static void deadlineAfterMs(clockid_t clock, unsigned long ms, struct timespec* ts)
+{
+    clock_gettime(clock, ts);
+    ts->tv_sec += (time_t)(ms / 1000);
+    ts->tv_nsec += (long)(ms % 1000) * 1000000L;
+    if (ts->tv_nsec >= 1000000000L)
+    {
+        ts->tv_sec++;
+        ts->tv_nsec -= 1000000000L;
+    }
+}
+
+// 脏数据最多的 fd，水位回写时优先处理
+static HashTableFdNode* selectDirtiestFdNode(void)
+{
+    HashTableFdNode* victim = NULL;
+
+    for (int i = 0; table != NULL && i < table->size; i++)
+    {
+        for (HashTableFdNode* node = table->buckets[i]; node != NULL; node = node->next)
+        {
+            if (node->set != NULL && node->flushStalledPass != flushPassCount &&
+                ATOMIC_LOAD(&(node->set->dirtyBytes)) > 0 &&
+                (victim == NULL || ATOMIC_LOAD(&(node->set->dirtyBytes)) > ATOMIC_LOAD(&(victim->set->dirtyBytes))))
+            {
+                victim = node;
+            }
+        }
+    }
+    return victim;
+}
+
+static HashTableFdNode* selectAgedFdNode(unsigned long long now)
+{
+    for (int i = 0; table != NULL && i < table->size; i++)
+    {
+        for (HashTableFdNode* node = table->buckets[i]; node != NULL; node = node->next)
+        {
+            if (node->set != NULL && node->flushStalledPass != flushPassCount &&
+                ATOMIC_LOAD(&(node->set->dirtyBytes)) > 0 &&
+                now - ATOMIC_LOAD(&(node->set->dirtySince)) >= flusherOptions.maxDirtyAgeMs)
+            {
+                return node;
+            }
+        }
+    }
+    return NULL;
+}
+
+static int isFlusherRunning(void)
+{
+    return __atomic_load_n(&flusherRunning, __ATOMIC_ACQUIRE);
+}
+
+static void notifyFlushDone(void)
+{
+    pthread_mutex_lock(&flusherLock);
+    pthread_cond_broadcast(&flushDoneCond);
+    pthread_mutex_unlock(&flusherLock);
+}
+
+// 执行一轮回写。每回写一批就释放一次 fdTableLock 读锁，打开/关闭 fd 的线程不必等整轮结束，
+// 排在它们后面的读写也不会被一起挡住。写不出数据的 fd（如持续写错误）本轮跳过，不影响其余 fd
+static void flushPass(void)
+{
+    flushPassCount++;
+
+    // 超过高水位后持续回写到低水位以下
+    if (ATOMIC_LOAD(&(cacheBudget.dirtyBytes)) > resolveThreshold(flusherOptions.dirtyHighBytes, 20))
+    {
+        while (isFlusherRunning() &&
+               ATOMIC_LOAD(&(cacheBudget.dirtyBytes)) > resolveThreshold(flusherOptions.dirtyLowBytes, 10))
+        {
+            lockFdTableShared();
+            HashTableFdNode* node = selectDirtiestFdNode();
+            size_t written = (node != NULL) ? flushCacheSet(node, FLUSHER_BATCH_BYTES) : 0;
+            if (node != NULL && written == 0)
+            {
+                node->flushStalledPass = flushPassCount;
+            }
+            unlockFdTableShared();
+            notifyFlushDone();
+            if (node == NULL)
+            {
+                break;
+            }
+        }
+    }
+
+    // 停留过久的脏数据整 fd 回写
+    while (isFlusherRunning())
+    {
+        lockFdTableShared();
+        HashTableFdNode* node = selectAgedFdNode(getMonotonicMs());
+        size_t written = (node != NULL) ? flushCacheSet(node, 0) : 0;
+        if (node != NULL && written == 0)
+        {
+            node->flushStalledPass = flushPassCount;
+        }
+        unlockFdTableShared();
+        if (node == NULL)
+        {
+            break;
+        }
+        if (written > 0)
+        {
+            notifyFlushDone();
+        }
+    }
+}
+
+static void* flusherMain(void* unused)
+{
+    (void)unused;
+
+    while (isFlusherRunning())
+    {
+        flushPass();
+
+        pthread_mutex_lock(&flusherLock);
+        if (flusherRunning)
+        {
+            struct timespec deadline;
+            deadlineAfterMs(CLOCK_MONOTONIC, flusherOptions.intervalMs, &deadline);
+            pthread_cond_timedwait(&flusherWakeCond, &flusherLock, &deadline);
+        }
+        pthread_mutex_unlock(&flusherLock);
+    }
+
+    return NULL;
+}
+
+
+int startCacheFlusher(const CacheFlusherOptions* options)
+{
+    pthread_mutex_lock(&flusherLock);
+    if (flusherRunning)
+    {
+        pthread_mutex_unlock(&flusherLock);
+        fprintf(stderr, "Error: Cache flusher is already running\n");
+        return -1;
+    }
+
+    memset(&flusherOptions, 0, sizeof(flusherOptions));
+    if (options != NULL)
+    {
+        flusherOptions = *options;
+    }
+    if (flusherOptions.intervalMs == 0)
+    {
+        flusherOptions.intervalMs = FLUSHER_DEFAULT_INTERVAL_MS;
+    }
+    if (flusherOptions.maxDirtyAgeMs == 0)
+    {
+        flusherOptions.maxDirtyAgeMs = FLUSHER_DEFAULT_MAX_DIRTY_AGE_MS;
+    }
+
+    pthread_condattr_t attr;
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_cond_init(&flusherWakeCond, &attr);
+    pthread_condattr_destroy(&attr);
+
+    __atomic_store_n(&flusherRunning, 1, __ATOMIC_RELEASE);
+    int ret = pthread_create(&flusherThread, NULL, flusherMain, NULL);
+    if (ret != 0)
+    {
+        flusherRunning = 0;
+        pthread_cond_destroy(&flusherWakeCond);
+        pthread_mutex_unlock(&flusherLock);
+        fprintf(stderr, "Error: Failed to create cache flusher thread: %s\n", strerror(ret));
+        return -1;
+    }
+    pthread_mutex_unlock(&flusherLock);
+
+    return 0;
+}
+
+void stopCacheFlusher(void)
+{
+    pthread_mutex_lock(&flusherLock);
+    if (!flusherRunning)
+    {
+        pthread_mutex_unlock(&flusherLock);
+        return;
+    }
+    __atomic_store_n(&flusherRunning, 0, __ATOMIC_RELEASE);
+    pthread_cond_signal(&flusherWakeCond);
+    pthread_cond_broadcast(&flushDoneCond);
+    pthread_mutex_unlock(&flusherLock);
+
+    pthread_join(flusherThread, NULL);
+    pthread_cond_destroy(&flusherWakeCond);
+}
+
+void kickCacheFlusher(void)
+{
+    if (isFlusherRunning() &&
+        ATOMIC_LOAD(&(cacheBudget.dirtyBytes)) > resolveThreshold(flusherOptions.dirtyHighBytes, 20))
+    {
+        pthread_mutex_lock(&flusherLock);
+        pthread_cond_signal(&flusherWakeCond);
+        pthread_mutex_unlock(&flusherLock);
+    }
+}
+
+// 写者此时调用 throttleDirtyWriters 是否会等待
+int isDirtyThrottled(void)
+{
+    return isFlusherRunning() &&
+           ATOMIC_LOAD(&(cacheBudget.dirtyBytes)) >= resolveThreshold(flusherOptions.dirtyThrottleBytes, 40);
+}
+
+// 脏数据超过节流阈值时让写者等待后台回写；回写没有进展（如设备出错）时不再阻塞
+void throttleDirtyWriters(void)
+{
+    if (!isFlusherRunning())
+    {
+        return;
+    }
+
+    pthread_mutex_lock(&flusherLock);
+    while (flusherRunning &&
+           ATOMIC_LOAD(&(cacheBudget.dirtyBytes)) >= resolveThreshold(flusherOptions.dirtyThrottleBytes, 40))
+    {
+        size_t before = ATOMIC_LOAD(&(cacheBudget.dirtyBytes));
+        struct timespec deadline;
+
+        pthread_cond_signal(&flusherWakeCond);
+        deadlineAfterMs(CLOCK_REALTIME, flusherOptions.intervalMs, &deadline);
+        if (pthread_cond_timedwait(&flushDoneCond, &flusherLock, &deadline) == ETIMEDOUT &&
+            ATOMIC_LOAD(&(cacheBudget.dirtyBytes)) >= before)
+        {
+            break;
+        }
+    }
+    pthread_mutex_unlock(&flusherLock);
+}
@@ -0,0 +1,30 @@
+#ifndef FLUSHER_H
+#define FLUSHER_H
+
+#include <stddef.h>
+#include <pthread.h>
+
+#define FLUSHER_DEFAULT_INTERVAL_MS 500
+#define FLUSHER_DEFAULT_MAX_DIRTY_AGE_MS 5000
+#define FLUSHER_BATCH_BYTES (16UL << 20)
+
+// startCacheFlusher 的参数，传 NULL 或置 0 的字段使用默认值
+typedef struct CacheFlusherOptions
+{
+    size_t dirtyHighBytes;      // 脏数据超过此值时开始回写，默认全局预算的 20%
+    size_t dirtyLowBytes;       // 回写到低于此值为止，默认全局预算的 10%
+    size_t dirtyThrottleBytes;  // 超过此值时写者等待回写，默认全局预算的 40%
+    unsigned long maxDirtyAgeMs;    // 脏数据最长停留时间
+    unsigned long intervalMs;       // 周期检查间隔
+} CacheFlusherOptions;
+
+
+int startCacheFlusher(const CacheFlusherOptions* options);
+void stopCacheFlusher(void);
+
+// 以下函数供读写路径调用，调用时不应持有 fdTableLock 以外的锁
+void kickCacheFlusher(void);
+void throttleDirtyWriters(void);
+int isDirtyThrottled(void);
+
+#endif
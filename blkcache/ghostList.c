@@ -0,0 +1,139 @@
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "ghostList.h"
+
+// 块索引的值域是缓存项指针，这里借用它存放从 1 开始的序号
+#define SEQ_TO_ENTRY(seq) ((struct cache*)(uintptr_t)(seq))
+#define ENTRY_TO_SEQ(entry) ((unsigned long)(uintptr_t)(entry))
+
+
+void initGhostList(GhostList* ghost)
+{
+    ghost->index = NULL;
+    ghost->keys = NULL;
+    ghost->seqs = NULL;
+    ghost->head = 0;
+    ghost->count = 0;
+    ghost->capacity = 0;
+    ghost->nextSeq = 1;
+}
+
+size_t ghostSize(const GhostList* ghost)
+{
+    return (ghost->index != NULL) ? ghost->index->size : 0;
+}
+
+// 弹出最旧的一条记录，已被 takeGhost 取走的记录只出环不动索引
+static void popOldestGhost(GhostList* ghost)
+{
+    long key = ghost->keys[ghost->head];
+    unsigned long seq = ghost->seqs[ghost->head];
+
+    ghost->head = (ghost->head + 1) % ghost->capacity;
+    ghost->count--;
+
+    if (ENTRY_TO_SEQ(lookupBlockIndex(ghost->index, key)) == seq)
+    {
+        removeBlockIndex(ghost->index, key);
+    }
+}
+
+// 环满时：失效记录过半就原地压缩，否则扩容
+static int growGhostRing(GhostList* ghost)
+{
+    size_t live = ghostSize(ghost);
+    size_t newCapacity = (ghost->capacity == 0) ? GHOST_LIST_MIN_RING :
+                         (live * 2 < ghost->capacity) ? ghost->capacity : ghost->capacity * 2;
+
+    long* keys = (long*)malloc(newCapacity * sizeof(long));
+    unsigned long* seqs = (unsigned long*)malloc(newCapacity * sizeof(unsigned long));
+    if (keys == NULL || seqs == NULL)
+    {
+        perror("Failed to grow ghost list");
+        free(keys);
+        free(seqs);
+        return -1;
+    }
+
+    size_t n = 0;
+    for (size_t i = 0; i < ghost->count; i++)
+    {
+        size_t pos = (ghost->head + i) % ghost->capacity;
+        if (ENTRY_TO_SEQ(lookupBlockIndex(ghost->index, ghost->keys[pos])) == ghost->seqs[pos])
+        {
+            keys[n] = ghost->keys[pos];
+            seqs[n] = ghost->seqs[pos];
+            n++;
+        }
+    }
+
+    free(ghost->keys);
+    free(ghost->seqs);
+    ghost->keys = keys;
+    ghost->seqs = seqs;
+    ghost->head = 0;
+    ghost->count = n;
+    ghost->capacity = newCapacity;
+    return 0;
+}
+
+void addGhost(GhostList* ghost, long key, size_t limit)
+{
+    if (limit == 0)
+    {
+        return;
+    }
+
+    if (ghost->index == NULL)
+    {
+        ghost->index = createBlockIndex(0);
+        if (ghost->index == NULL)
+        {
+            return;
+        }
+    }
+
+    if (ghost->count == ghost->capacity && growGhostRing(ghost) < 0)
+    {
+        return;
+    }
+
+    unsigned long seq = ghost->nextSeq++;
+    size_t tail = (ghost->head + ghost->count) % ghost->capacity;
+    ghost->keys[tail] = key;
+    ghost->seqs[tail] = seq;
+    ghost->count++;
+    insertBlockIndex(ghost->index, key, SEQ_TO_ENTRY(seq));
+
+    trimGhostList(ghost, limit);
+}
+
+// 块号在淘汰历史中时将其移除并返回 true
+bool takeGhost(GhostList* ghost, long key)
+{
+    if (ghost->index == NULL || lookupBlockIndex(ghost->index, key) == NULL)
+    {
+        return false;
+    }
+
+    removeBlockIndex(ghost->index, key);
+    return true;
+}
+
+void trimGhostList(GhostList* ghost, size_t limit)
+{
+    while (ghostSize(ghost) > limit && ghost->count > 0)
+    {
+        popOldestGhost(ghost);
+    }
+}
+
+void destroyGhostList(GhostList* ghost)
+{
+    destroyBlockIndex(ghost->index);
+    free(ghost->keys);
+    free(ghost->seqs);
+    initGhostList(ghost);
+}
@@ -0,0 +1,32 @@
+#ifndef GHOST_LIST_H
+#define GHOST_LIST_H
+
+#include <stddef.h>
+#include <stdbool.h>
+
+#include "blockIndex.h"
+
+#define GHOST_LIST_MIN_RING 64
+
+// 只记录块号的淘汰历史（FIFO），供 ARC/2Q/S3-FIFO 判断块是否“刚被淘汰过”；
+// 环中被提前删除的记录靠序号识别，出队时跳过
+typedef struct GhostList
+{
+    BlockIndex* index;      // 块号 -> 入队序号
+    long* keys;
+    unsigned long* seqs;
+    size_t head;
+    size_t count;
+    size_t capacity;
+    unsigned long nextSeq;
+} GhostList;
+
+
+void initGhostList(GhostList* ghost);
+void addGhost(GhostList* ghost, long key, size_t limit);
+bool takeGhost(GhostList* ghost, long key);
+size_t ghostSize(const GhostList* ghost);
+void trimGhostList(GhostList* ghost, size_t limit);
+void destroyGhostList(GhostList* ghost);
+
+#endif
@@ -1,10 +1,68 @@
+#define _GNU_SOURCE
 #include <stdlib.h>
 #include <stdio.h>
 
 #include "cacheStruct.h"
 #include "hashTable.h"
 
+// 每个槽独占一个缓存行，不同线程的读锁不争用同一行
+typedef struct FdTableLockSlot
+{
+    pthread_rwlock_t lock;
+} __attribute__((aligned(64))) FdTableLockSlot;
+
 HashTableFd* table = NULL;
+static FdTableLockSlot fdTableLock[FD_TABLE_LOCK_SLOTS];
+static pthread_once_t fdTableLockOnce = PTHREAD_ONCE_INIT;
+static unsigned int nextFdTableSlot = 0;
+static __thread int fdTableSlot = -1;
+
+// 默认的读写锁偏向读者，读写不断时打开/关闭 fd 会一直拿不到写锁
+static void initFdTableLock(void)
+{
+    pthread_rwlockattr_t attr;
+    pthread_rwlockattr_init(&attr);
+    pthread_rwlockattr_setkind_np(&attr, PTHREAD_RWLOCK_PREFER_WRITER_NONRECURSIVE_NP);
+    for (int i = 0; i < FD_TABLE_LOCK_SLOTS; i++)
+    {
+        pthread_rwlock_init(&(fdTableLock[i].lock), &attr);
+    }
+    pthread_rwlockattr_destroy(&attr);
+}
+
+// 线程第一次取读锁时轮流分配槽，之后固定使用该槽
+void lockFdTableShared(void)
+{
+    if (fdTableSlot < 0)
+    {
+        pthread_once(&fdTableLockOnce, initFdTableLock);
+        fdTableSlot = (int)(ATOMIC_ADD(&nextFdTableSlot, 1) % FD_TABLE_LOCK_SLOTS);
+    }
+    pthread_rwlock_rdlock(&(fdTableLock[fdTableSlot].lock));
+}
+
+void unlockFdTableShared(void)
+{
+    pthread_rwlock_unlock(&(fdTableLock[fdTableSlot].lock));
+}
+
+// 按槽号顺序加锁，多个写者之间不会死锁
+void lockFdTable(void)
+{
+    pthread_once(&fdTableLockOnce, initFdTableLock);
+    for (int i = 0; i < FD_TABLE_LOCK_SLOTS; i++)
+    {
+        pthread_rwlock_wrlock(&(fdTableLock[i].lock));
+    }
+}
+
+void unlockFdTable(void)
+{
+    for (int i = FD_TABLE_LOCK_SLOTS - 1; i >= 0; i--)
+    {
+        pthread_rwlock_unlock(&(fdTableLock[i].lock));
+    }
+}
 
 HashTableFd* createHashTableFd(void) 
 {
@@ -12,37 +70,78 @@ HashTableFd* createHashTableFd(void)
     table->size = HASH_FD_SIZE;
     table->buckets = (HashTableFdNode**)calloc(HASH_FD_SIZE, sizeof(HashTableFdNode*));
     pthread_mutex_init(&(table->lock), NULL);
+    for (int i = 0; i < BLOCK_POOL_MAX; i++)
+    {
+        table->pools[i] = NULL;
+    }
 
     return table;
 }
 
+BlockPool* getBlockPoolForSize(size_t blockSize)
+{
+    BlockPool* pool = NULL;
+
+    pthread_mutex_lock(&(table->lock));
+    for (int i = 0; i < BLOCK_POOL_MAX; i++)
+    {
+        if (table->pools[i] == NULL)
+        {
+            pool = createBlockPool(blockSize, 0);
+            table->pools[i] = pool;
+            break;
+        }
+        if (table->pools[i]->blockSize == blockSize)
+        {
+            pool = table->pools[i];
+            break;
+        }
+    }
+    pthread_mutex_unlock(&(table->lock));
+
+    return pool;
+}
+
 
-HashTableFdNode* createHashTableFdNode(int fd, LRUHash* Hash, AVLTreeNode* root, int cacheType) 
+HashTableFdNode* createHashTableFdNode(int fd, CacheSet* set, int cacheType) 
 {
     HashTableFdNode* node = (HashTableFdNode*)malloc(sizeof(HashTableFdNode));
     node->fd = fd;
-    node->Hash = Hash;
+    node->set = set;
+    node->ra = NULL;
+    node->bypass = NULL;
+    node->tier = NULL;
+    node->hotSetPath = NULL;
+    node->warmup = NULL;
     node->cacheType = cacheType;
+    node->asyncPending = 0;
+    node->flushStalledPass = 0;
+    pthread_mutex_init(&(node->ioLock), NULL);
     node->next = NULL;
     return node;
 }
 
-void createAndInsertFdNode(int fd, LRUHash* hash, AVLTreeNode* root, int cacheType) 
+// 调用者需持有 fdTableLock 写锁
+HashTableFdNode* createAndInsertFdNode(int fd, CacheSet* set, int cacheType) 
 {
     int index = HASH_FD(fd, table->size);
-    HashTableFdNode* newNode = createHashTableFdNode(fd, hash, root, cacheType);
-
-    pthread_mutex_lock(&(table->lock)); 
+    HashTableFdNode* newNode = createHashTableFdNode(fd, set, cacheType);
 
     newNode->next = table->buckets[index];
     table->buckets[index] = newNode;
 
-    pthread_mutex_unlock(&(table->lock)); 
+    return newNode;
 }
 
 
+// 调用者需持有 fdTableLock（读锁或写锁）
 HashTableFdNode* findFdNode(int fd) 
 {
+    if (table == NULL || fd < 0)
+    {
+        return NULL;
+    }
+
     int index = HASH_FD(fd, table->size);
     HashTableFdNode* currentNode = table->buckets[index];
 
@@ -56,6 +155,23 @@ HashTableFdNode* findFdNode(int fd)
     return NULL;
 }
 
+// 持读锁查找 fd 节点；找到时保持读锁直到 releaseFdNode，找不到时已释放
+HashTableFdNode* acquireFdNode(int fd)
+{
+    lockFdTableShared();
+    HashTableFdNode* node = findFdNode(fd);
+    if (node == NULL)
+    {
+        unlockFdTableShared();
+    }
+    return node;
+}
+
+void releaseFdNode(void)
+{
+    unlockFdTableShared();
+}
+
 int getFdFromHashTable(void) 
 {
     for (int i = 0; i < table->size; i++) 
@@ -70,12 +186,11 @@ int getFdFromHashTable(void)
     return -1;
 }
 
+// 调用者需持有 fdTableLock 写锁
 int deleteFdNode(int fd) 
 {
     int index = HASH_FD(fd, table->size);
 
-    pthread_mutex_lock(&(table->lock));
-
     HashTableFdNode* currentNode = table->buckets[index];
     HashTableFdNode* previousNode = NULL;
 
@@ -90,18 +205,15 @@ int deleteFdNode(int fd)
             {
                 previousNode->next = currentNode->next;
             }
+            pthread_mutex_destroy(&(currentNode->ioLock));
             free(currentNode);
 
-            pthread_mutex_unlock(&(table->lock));
-
             return 1;
         }
         previousNode = currentNode;
         currentNode = currentNode->next;
     }
 
-    pthread_mutex_unlock(&(table->lock));
-
     return 0;
 }
 
@@ -121,6 +233,10 @@ void destroyHashTableFd(void)
     clearHashTable();
 
     free(table->buckets);
+    for (int i = 0; i < BLOCK_POOL_MAX; i++)
+    {
+        destroyBlockPool(table->pools[i]);
+    }
     pthread_mutex_destroy(&(table->lock));
     free(table);
 }
@@ -3,8 +3,11 @@
 
 #include <pthread.h>
 
-#include "AVLTree.h"
-#include "lru.h"
+#include "cacheStruct.h"
+#include "readahead.h"
+#include "bypass.h"
+#include "deviceTier.h"
+#include "hotSet.h"
 
 #define HASH_FD(fd, size) ((fd) % (size))
 #define HASH_FD_SIZE 5
@@ -16,8 +19,15 @@ typedef struct HashTableFdNode
 {
     int fd;
     int cacheType;
-    LRUHash* Hash;
-    AVLTreeNode* root;
+    CacheSet* set;
+    ReadaheadState* ra;
+    BypassState* bypass;        // 未配置旁路时为 NULL
+    DeviceTier* tier;           // 设备模式的 NVMe 层，未配置时为 NULL
+    char* hotSetPath;           // 关闭时保存热块列表的文件，未配置时为 NULL
+    HotSetWarmup* warmup;       // 后台预热，由 warmupLock 保护
+    pthread_mutex_t ioLock;     // 设备模式下 lseek 与 ioctl 必须成对执行
+    unsigned int asyncPending;  // 未完成的异步请求数，关闭前要等它归零
+    unsigned long flushStalledPass; // 回写线程本轮在该 fd 上没有进展时记下轮次，本轮不再选它
     struct HashTableFdNode* next;
 } HashTableFdNode;
 
@@ -25,13 +35,28 @@ typedef struct HashTableFd
 {
     int size;
     HashTableFdNode** buckets;
+    BlockPool* pools[BLOCK_POOL_MAX];
     pthread_mutex_t lock;
 } HashTableFd;
 
 
+#define FD_TABLE_LOCK_SLOTS 16
+
+// fd 表锁 fdTableLock：读写缓存时持读锁，打开/关闭 fd 时持写锁，
+// 因此持有读锁期间取得的节点及其缓存集合不会被释放。
+// 锁按线程分槽，读者只取本线程所在槽的读锁，写者依次取全部槽的写锁；
+// 各槽优先写者，持读锁时不能再取读锁，也不能等待需要取读锁的其他线程
+void lockFdTableShared(void);
+void unlockFdTableShared(void);
+void lockFdTable(void);
+void unlockFdTable(void);
+
 HashTableFd* createHashTableFd(void);
-void createAndInsertFdNode(int fd, LRUHash* Hash, AVLTreeNode* root, int cacheType);
+HashTableFdNode* createAndInsertFdNode(int fd, CacheSet* set, int cacheType);
+BlockPool* getBlockPoolForSize(size_t blockSize);
 HashTableFdNode* findFdNode(int fd);
+HashTableFdNode* acquireFdNode(int fd);
+void releaseFdNode(void);
 int deleteFdNode(int fd);
 int getFdFromHashTable(void);
 void destroyHashTableFd(void);
@@ -0,0 +1,321 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+
+#include "hotSet.h"
+#include "hashTable.h"
+#include "cacheIOHandler.h"
+#include "singleCacheHandler.h"
+
+static int compareOffset(const void* a, const void* b)
+{
+    off_t left = *(const off_t*)a;
+    off_t right = *(const off_t*)b;
+    return (left > right) - (left < right);
+}
+
+// 保存集合中驻留的块，热的在前：各分片按替换策略的淘汰顺序倒序（兼顾各策略的最近与频率信息），
+// 再按名次在分片间交错合并；预读进来还没被用到的块不算热块。先写临时文件再改名，中途失败不会留下半个文件
+int saveHotSet(CacheSet* set, const char* path)
+{
+    size_t capacity = ATOMIC_LOAD(&(set->residentBytes)) / set->blockSize + 64;
+    size_t count = 0;
+    uint64_t* collected = (uint64_t*)malloc(capacity * sizeof(uint64_t));
+    size_t* shardEnd = (size_t*)malloc(set->shardCount * sizeof(size_t));
+    if (collected == NULL || shardEnd == NULL)
+    {
+        perror("Failed to allocate hot set");
+        free(collected);
+        free(shardEnd);
+        return -1;
+    }
+
+    for (unsigned int n = 0; n < set->shardCount; n++)
+    {
+        CacheShard* shard = &(set->shards[n]);
+
+        pthread_rwlock_rdlock(&(shard->lock));
+        for (cache* node = replacementNext(&(shard->policy), NULL); node != NULL; node = replacementNext(&(shard->policy), node))
+        {
+            if (node->flags & CACHE_FLAG_READAHEAD)
+            {
+                continue;
+            }
+            if (count == capacity)
+            {
+                uint64_t* grown = (uint64_t*)realloc(collected, capacity * 2 * sizeof(uint64_t));
+                if (grown == NULL)
+                {
+                    break;
+                }
+                collected = grown;
+                capacity *= 2;
+            }
+            collected[count++] = (uint64_t)BLOCK_KEY(set, node->offset);
+        }
+        pthread_rwlock_unlock(&(shard->lock));
+        shardEnd[n] = count;
+    }
+
+    size_t pathLength = strlen(path);
+    char* tempPath = (char*)malloc(pathLength + 5);
+    uint64_t* blocks = (uint64_t*)malloc(MAX(count, (size_t)1) * sizeof(uint64_t));
+    if (tempPath == NULL || blocks == NULL)
+    {
+        perror("Failed to allocate hot set");
+        free(tempPath);
+        free(blocks);
+        free(collected);
+        free(shardEnd);
+        return -1;
+    }
+    memcpy(tempPath, path, pathLength);
+    memcpy(tempPath + pathLength, ".tmp", 5);
+
+    size_t out = 0;
+    for (size_t rank = 0; out < count; rank++)
+    {
+        size_t start = 0;
+        for (unsigned int n = 0; n < set->shardCount; n++)
+        {
+            if (shardEnd[n] - start > rank)
+            {
+                blocks[out++] = collected[shardEnd[n] - 1 - rank];
+            }
+            start = shardEnd[n];
+        }
+    }
+    free(collected);
+    free(shardEnd);
+
+    HotSetHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, HOT_SET_MAGIC, sizeof(header.magic));
+    header.version = HOT_SET_VERSION;
+    header.blockSize = (uint32_t)set->blockSize;
+    header.count = count;
+
+    int ret = -1;
+    FILE* file = fopen(tempPath, "wb");
+    if (file == NULL)
+    {
+        fprintf(stderr, "Error: Failed to create hot set file %s: %s\n", tempPath, strerror(errno));
+    }
+    else
+    {
+        int written = fwrite(&header, sizeof(header), 1, file) == 1 && fwrite(blocks, sizeof(uint64_t), count, file) == count;
+        if (fclose(file) == 0 && written && rename(tempPath, path) == 0)
+        {
+            ret = 0;
+        }
+        else
+        {
+            fprintf(stderr, "Error: Failed to write hot set file %s\n", path);
+            remove(tempPath);
+        }
+    }
+
+    free(tempPath);
+    free(blocks);
+    return ret;
+}
+
+// 读出热块列表并换算成当前块大小下的块偏移；文件不存在时静默返回 NULL
+static off_t* loadHotSet(const char* path, size_t blockSize, size_t* count)
+{
+    FILE* file = fopen(path, "rb");
+    if (file == NULL)
+    {
+        if (errno != ENOENT)
+        {
+            fprintf(stderr, "Error: Failed to open hot set file %s: %s\n", path, strerror(errno));
+        }
+        return NULL;
+    }
+
+    HotSetHeader header;
+    if (fread(&header, sizeof(header), 1, file) != 1 || memcmp(header.magic, HOT_SET_MAGIC, sizeof(header.magic)) != 0 ||
+        header.version != HOT_SET_VERSION || !IS_POWER_OF_TWO(header.blockSize) ||
+        header.count > SIZE_MAX / sizeof(uint64_t))
+    {
+        fprintf(stderr, "Warning: Ignoring invalid hot set file %s\n", path);
+        fclose(file);
+        return NULL;
+    }
+
+    // 空列表也是有效的：上次关闭时没有热块
+    uint64_t* blocks = (uint64_t*)malloc(MAX((size_t)header.count, (size_t)1) * sizeof(uint64_t));
+    if (blocks == NULL)
+    {
+        perror("Failed to allocate hot set");
+        fclose(file);
+        return NULL;
+    }
+    size_t loaded = fread(blocks, sizeof(uint64_t), (size_t)header.count, file);
+    fclose(file);
+
+    // 块大小变了也能用：按字节偏移换算，重复的块在预取时自然跳过
+    off_t* offsets = (off_t*)blocks;
+    for (size_t i = 0; i < loaded; i++)
+    {
+        offsets[i] = ROUND_DOWN_TO_BLOCK((off_t)(blocks[i] * header.blockSize), blockSize);
+    }
+    *count = loaded;
+    return offsets;
+}
+
+// 按实际读入的字节数限速，睡眠时不持有任何锁，并及时响应停止请求
+static void throttleWarmup(HotSetWarmup* warmup, size_t bytes)
+{
+    pthread_mutex_lock(&(warmup->lock));
+    warmup->issuedBytes += bytes;
+    unsigned long long due = warmup->startMs + (unsigned long long)(warmup->issuedBytes / (warmup->bytesPerSecond / 1000 + 1));
+    pthread_mutex_unlock(&(warmup->lock));
+
+    unsigned long long now = getMonotonicMs();
+    while (due > now && !ATOMIC_LOAD(&(warmup->stop)))
+    {
+        unsigned long long waitMs = MIN(due - now, 50ULL);
+        struct timespec ts = { (time_t)(waitMs / 1000), (long)(waitMs % 1000) * 1000000L };
+        nanosleep(&ts, NULL);
+        now = getMonotonicMs();
+    }
+}
+
+// 读入一段连续的块，已驻留的跳过；只用空余预算，不淘汰已有的块。缓存已满或出错时返回 -1
+static int warmupRun(HotSetWarmup* warmup, off_t offset, int blockCount)
+{
+    HashTableFdNode* hashTableFdNode = acquireFdNode(warmup->fd);
+    if (hashTableFdNode == NULL)
+    {
+        return -1;
+    }
+
+    CacheSet* set = hashTableFdNode->set;
+    int filled = 0;
+    int pos = 0;
+    int full = 0;
+    while (pos < blockCount)
+    {
+        int covered = 0;
+        int ret = readMissingBlocks(warmup->fd, offset + (off_t)pos * (off_t)set->blockSize, blockCount - pos,
+                                    CACHE_MISS_NO_EVICT, &covered);
+        if (ret < 0 || covered == 0)
+        {
+            full = (covered == 0);
+            break;
+        }
+        filled += ret;
+        pos += covered;
+    }
+    size_t blockSize = set->blockSize;
+    releaseFdNode();
+
+    ATOMIC_ADD(&(warmup->loadedBlocks), (size_t)filled);
+    throttleWarmup(warmup, (size_t)filled * blockSize);
+    return full ? -1 : 0;
+}
+
+static void* warmupThread(void* arg)
+{
+    HotSetWarmup* warmup = (HotSetWarmup*)arg;
+    off_t chunk[HOT_SET_CHUNK_BLOCKS];
+
+    while (!ATOMIC_LOAD(&(warmup->stop)))
+    {
+        size_t first = __atomic_fetch_add(&(warmup->next), HOT_SET_CHUNK_BLOCKS, __ATOMIC_RELAXED);
+        if (first >= warmup->count)
+        {
+            break;
+        }
+
+        size_t n = MIN((size_t)HOT_SET_CHUNK_BLOCKS, warmup->count - first);
+        memcpy(chunk, warmup->offsets + first, n * sizeof(off_t));
+        qsort(chunk, n, sizeof(off_t), compareOffset);
+
+        // 段内相邻（或重复）的块合并成一次读
+        size_t i = 0;
+        while (i < n && !ATOMIC_LOAD(&(warmup->stop)))
+        {
+            size_t j = i + 1;
+            while (j < n && chunk[j] - chunk[j - 1] <= (off_t)warmup->blockSize)
+            {
+                j++;
+            }
+            int blockCount = (int)((chunk[j - 1] - chunk[i]) / (off_t)warmup->blockSize) + 1;
+            if (warmupRun(warmup, chunk[i], blockCount) < 0)
+            {
+                ATOMIC_STORE(&(warmup->stop), 1);
+            }
+            i = j;
+        }
+    }
+
+    ATOMIC_SUB(&(warmup->running), 1);
+    return NULL;
+}
+
+HotSetWarmup* startHotSetWarmup(int fd, const char* path, size_t blockSize, size_t bytesPerSecond)
+{
+    size_t count = 0;
+    off_t* offsets = loadHotSet(path, blockSize, &count);
+    if (offsets == NULL)
+    {
+        return NULL;
+    }
+
+    HotSetWarmup* warmup = (HotSetWarmup*)calloc(1, sizeof(HotSetWarmup));
+    if (warmup == NULL)
+    {
+        perror("Failed to allocate hot set warmup");
+        free(offsets);
+        return NULL;
+    }
+
+    warmup->fd = fd;
+    warmup->offsets = offsets;
+    warmup->count = count;
+    warmup->blockSize = blockSize;
+    warmup->bytesPerSecond = (bytesPerSecond != 0) ? bytesPerSecond : HOT_SET_DEFAULT_RATE;
+    warmup->startMs = getMonotonicMs();
+    pthread_mutex_init(&(warmup->lock), NULL);
+
+    int threadCount = (int)MIN((size_t)HOT_SET_WARMUP_THREADS, (count + HOT_SET_CHUNK_BLOCKS - 1) / HOT_SET_CHUNK_BLOCKS);
+    warmup->running = (unsigned int)threadCount;
+    for (int i = 0; i < threadCount; i++)
+    {
+        if (pthread_create(&(warmup->threads[i]), NULL, warmupThread, warmup) != 0)
+        {
+            perror("Failed to start hot set warmup thread");
+            ATOMIC_SUB(&(warmup->running), (unsigned int)(threadCount - i));
+            break;
+        }
+        warmup->threadCount++;
+    }
+    return warmup;
+}
+
+int isHotSetWarmupRunning(HotSetWarmup* warmup)
+{
+    return warmup != NULL && ATOMIC_LOAD(&(warmup->running)) != 0;
+}
+
+// 调用者不能持有 fdTableLock：预热线程读入时要取它的读锁
+void stopHotSetWarmup(HotSetWarmup* warmup)
+{
+    if (warmup == NULL)
+    {
+        return;
+    }
+
+    ATOMIC_STORE(&(warmup->stop), 1);
+    for (int i = 0; i < warmup->threadCount; i++)
+    {
+        pthread_join(warmup->threads[i], NULL);
+    }
+    pthread_mutex_destroy(&(warmup->lock));
+    free(warmup->offsets);
+    free(warmup);
+}
@@ -0,0 +1,51 @@
+#ifndef HOT_SET_H
+#define HOT_SET_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <pthread.h>
+
+#include "cacheStruct.h"
+
+#define HOT_SET_MAGIC "BLKHOT01"
+#define HOT_SET_VERSION 1
+#define HOT_SET_WARMUP_THREADS 4
+#define HOT_SET_CHUNK_BLOCKS 256            // 预取线程每次取这么多个块，排序后合并相邻块
+#define HOT_SET_DEFAULT_RATE (64UL << 20)   // 默认预取限速（字节/秒）
+
+// 热块列表文件：文件头之后是 count 个块号，按热度从热到冷排列
+typedef struct HotSetHeader
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t blockSize;
+    uint64_t count;
+} HotSetHeader;
+
+// 打开时的后台预热：几个线程按热度顺序分段取块，段内按偏移合并成连续读，总速率受限；
+// 缓存没有空余时停止，不淘汰已有数据
+typedef struct HotSetWarmup
+{
+    int fd;
+    off_t* offsets;         // 按热度排列的块偏移
+    size_t count;
+    size_t blockSize;
+    size_t next;            // 下一段的起始下标，原子递增
+    size_t bytesPerSecond;
+    size_t issuedBytes;
+    unsigned long long startMs;
+    int stop;
+    unsigned int running;   // 仍在运行的线程数
+    size_t loadedBlocks;    // 实际读入的块数
+    pthread_mutex_t lock;
+    pthread_t threads[HOT_SET_WARMUP_THREADS];
+    int threadCount;
+} HotSetWarmup;
+
+
+int saveHotSet(CacheSet* set, const char* path);
+HotSetWarmup* startHotSetWarmup(int fd, const char* path, size_t blockSize, size_t bytesPerSecond);
+int isHotSetWarmupRunning(HotSetWarmup* warmup);
+void stopHotSetWarmup(HotSetWarmup* warmup);
+
+#endif
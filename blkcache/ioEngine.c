@@ -0,0 +1,800 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <linux/io_uring.h>
+
+#include "ioEngine.h"
+
+// 所有线程共享的一个 io_uring 实例
+typedef struct IoRing
+{
+    int ringFd;
+    unsigned int setupFlags;
+    unsigned int sqEntries;
+    unsigned int cqEntries;
+    unsigned int* sqHead;
+    unsigned int* sqTail;
+    unsigned int* sqMask;
+    unsigned int* sqFlags;
+    unsigned int* sqArray;
+    struct io_uring_sqe* sqes;
+    unsigned int* cqHead;
+    unsigned int* cqTail;
+    unsigned int* cqMask;
+    struct io_uring_cqe* cqes;
+    void* sqRing;
+    size_t sqRingBytes;
+    void* cqRing;
+    size_t cqRingBytes;
+    size_t sqesBytes;
+    unsigned int inFlight;  // 已提交未收割的请求数，不超过 cqEntries 以免完成队列溢出
+    int fixedBuffers;       // 内核是否接受了稀疏的固定缓冲区表
+} IoRing;
+
+// 一次提交的一批请求；done 为 NULL 时是同步批次，由提交者自己等待
+typedef struct IoGroup
+{
+    int pending;
+    IoRequest* requests;
+    int count;
+    IoDoneCallback done;
+    void* arg;
+    struct IoGroup* next;
+} IoGroup;
+
+typedef struct IoBuffer
+{
+    void* base;
+    size_t length;
+    int used;
+    int fixed;  // 已登记为当前 ring 的固定缓冲区
+} IoBuffer;
+
+// engineLock：启停取写锁，批次提交与缓冲区登记取读锁；
+// sqLock 保护提交队列与 ioBuffers，cqLock 保护完成队列，持有它的线程替所有等待者收割
+static pthread_rwlock_t engineLock = PTHREAD_RWLOCK_INITIALIZER;
+static pthread_mutex_t sqLock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_mutex_t cqLock = PTHREAD_MUTEX_INITIALIZER;
+static IoRing ring;
+static IoBuffer ioBuffers[IO_ENGINE_MAX_BUFFERS];
+static int bufferTableFull = 0;     // 槽位耗尽的警告只打印一次
+static int engineRunning = 0;
+
+// 异步批次由完成线程收割并执行 done；有同步等待者持有完成队列时让给它们收割。
+// asyncLock 保护下面的计数与就绪链表，加锁顺序为 cqLock 在前
+static pthread_mutex_t asyncLock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t asyncCond = PTHREAD_COND_INITIALIZER;
+static pthread_t completionThread;
+static int completionRunning = 0;
+static unsigned int asyncGroups = 0;    // 已全部提交、尚未完成的异步批次
+static unsigned int cqWaiters = 0;      // 正在等待完成事件的同步提交者
+static unsigned int asyncActive = 0;    // 已接受、done 尚未返回的异步批次，停止引擎时等它归零
+static int engineStopping = 0;          // 置位后 submitIoAsync 不再接受新批次
+static pthread_cond_t asyncDrainCond = PTHREAD_COND_INITIALIZER;
+static IoGroup* readyHead = NULL;
+static IoGroup* readyTail = NULL;
+
+
+static int ioUringSetup(unsigned int entries, struct io_uring_params* params)
+{
+    return (int)syscall(__NR_io_uring_setup, entries, params);
+}
+
+static int ioUringEnter(int ringFd, unsigned int toSubmit, unsigned int minComplete, unsigned int flags)
+{
+    return (int)syscall(__NR_io_uring_enter, ringFd, toSubmit, minComplete, flags, NULL, 0);
+}
+
+static int ioUringRegister(int ringFd, unsigned int opcode, void* arg, unsigned int nrArgs)
+{
+    return (int)syscall(__NR_io_uring_register, ringFd, opcode, arg, nrArgs);
+}
+
+static void advanceIov(struct iovec** iov, int* iovcnt, size_t bytes)
+{
+    while (*iovcnt > 0 && bytes >= (*iov)->iov_len)
+    {
+        bytes -= (*iov)->iov_len;
+        (*iov)++;
+        (*iovcnt)--;
+    }
+    if (*iovcnt > 0)
+    {
+        (*iov)->iov_base = (char*)(*iov)->iov_base + bytes;
+        (*iov)->iov_len -= bytes;
+    }
+}
+
+// 循环调用 preadv/pwritev 直到传输完全部 iovec，读到文件末尾时提前返回
+static ssize_t transferFull(int fd, struct iovec* iov, int iovcnt, off_t offset, int isWrite)
+{
+    ssize_t total = 0;
+
+    while (iovcnt > 0)
+    {
+        ssize_t transferred = isWrite ? pwritev(fd, iov, iovcnt, offset + total)
+                                      : preadv(fd, iov, iovcnt, offset + total);
+        if (transferred < 0)
+        {
+            return -1;
+        }
+        if (transferred == 0)
+        {
+            break;
+        }
+        total += transferred;
+        advanceIov(&iov, &iovcnt, (size_t)transferred);
+    }
+    return total;
+}
+
+static int mapIoRing(IoRing* r, const struct io_uring_params* params)
+{
+    r->sqRingBytes = params->sq_off.array + params->sq_entries * sizeof(unsigned int);
+    r->cqRingBytes = params->cq_off.cqes + params->cq_entries * sizeof(struct io_uring_cqe);
+    if (params->features & IORING_FEAT_SINGLE_MMAP)
+    {
+        r->sqRingBytes = (r->cqRingBytes > r->sqRingBytes) ? r->cqRingBytes : r->sqRingBytes;
+        r->cqRingBytes = r->sqRingBytes;
+    }
+
+    r->sqRing = mmap(NULL, r->sqRingBytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, r->ringFd, IORING_OFF_SQ_RING);
+    if (r->sqRing == MAP_FAILED)
+    {
+        return -1;
+    }
+
+    r->cqRing = r->sqRing;
+    if (!(params->features & IORING_FEAT_SINGLE_MMAP))
+    {
+        r->cqRing = mmap(NULL, r->cqRingBytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, r->ringFd, IORING_OFF_CQ_RING);
+        if (r->cqRing == MAP_FAILED)
+        {
+            munmap(r->sqRing, r->sqRingBytes);
+            return -1;
+        }
+    }
+
+    r->sqesBytes = params->sq_entries * sizeof(struct io_uring_sqe);
+    r->sqes = (struct io_uring_sqe*)mmap(NULL, r->sqesBytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, r->ringFd, IORING_OFF_SQES);
+    if (r->sqes == MAP_FAILED)
+    {
+        if (r->cqRing != r->sqRing)
+        {
+            munmap(r->cqRing, r->cqRingBytes);
+        }
+        munmap(r->sqRing, r->sqRingBytes);
+        return -1;
+    }
+
+    char* sq = (char*)r->sqRing;
+    char* cq = (char*)r->cqRing;
+    r->sqEntries = params->sq_entries;
+    r->cqEntries = params->cq_entries;
+    r->sqHead = (unsigned int*)(sq + params->sq_off.head);
+    r->sqTail = (unsigned int*)(sq + params->sq_off.tail);
+    r->sqMask = (unsigned int*)(sq + params->sq_off.ring_mask);
+    r->sqFlags = (unsigned int*)(sq + params->sq_off.flags);
+    r->sqArray = (unsigned int*)(sq + params->sq_off.array);
+    r->cqHead = (unsigned int*)(cq + params->cq_off.head);
+    r->cqTail = (unsigned int*)(cq + params->cq_off.tail);
+    r->cqMask = (unsigned int*)(cq + params->cq_off.ring_mask);
+    r->cqes = (struct io_uring_cqe*)(cq + params->cq_off.cqes);
+    return 0;
+}
+
+static void unmapIoRing(IoRing* r)
+{
+    munmap(r->sqes, r->sqesBytes);
+    if (r->cqRing != r->sqRing)
+    {
+        munmap(r->cqRing, r->cqRingBytes);
+    }
+    munmap(r->sqRing, r->sqRingBytes);
+}
+
+// 调用者持有 sqLock；把 slot 的当前内容同步到 ring 的固定缓冲区表，空 iovec 表示注销
+static void updateFixedBuffer(unsigned int slot)
+{
+    IoBuffer* buffer = &ioBuffers[slot];
+    struct iovec iov;
+    struct io_uring_rsrc_update2 update;
+
+    iov.iov_base = buffer->used ? buffer->base : NULL;
+    iov.iov_len = buffer->used ? buffer->length : 0;
+    memset(&update, 0, sizeof(update));
+    update.offset = slot;
+    update.data = (unsigned long long)(uintptr_t)&iov;
+    update.nr = 1;
+
+    int ret = ioUringRegister(ring.ringFd, IORING_REGISTER_BUFFERS_UPDATE, &update, sizeof(update));
+    buffer->fixed = (buffer->used && ret >= 0);
+}
+
+static int isFixedBuffer(const IoRequest* request)
+{
+    if (request->iovcnt != 1 || request->bufferSlot >= IO_ENGINE_MAX_BUFFERS)
+    {
+        return 0;
+    }
+
+    const IoBuffer* buffer = &ioBuffers[request->bufferSlot];
+    char* start = (char*)request->iov[0].iov_base;
+    return buffer->fixed && start >= (char*)buffer->base &&
+           start + request->iov[0].iov_len <= (char*)buffer->base + buffer->length;
+}
+
+// 调用者持有 sqLock
+static void prepareIoSqe(struct io_uring_sqe* sqe, IoRequest* request)
+{
+    memset(sqe, 0, sizeof(*sqe));
+    sqe->fd = request->fd;
+    sqe->off = (unsigned long long)request->offset;
+    sqe->user_data = (unsigned long long)(uintptr_t)request;
+
+    if (isFixedBuffer(request))
+    {
+        sqe->opcode = request->isWrite ? IORING_OP_WRITE_FIXED : IORING_OP_READ_FIXED;
+        sqe->addr = (unsigned long long)(uintptr_t)request->iov[0].iov_base;
+        sqe->len = (unsigned int)request->iov[0].iov_len;
+        sqe->buf_index = (unsigned short)request->bufferSlot;
+    }
+    else
+    {
+        sqe->opcode = request->isWrite ? IORING_OP_WRITEV : IORING_OP_READV;
+        sqe->addr = (unsigned long long)(uintptr_t)request->iov;
+        sqe->len = (unsigned int)request->iovcnt;
+    }
+}
+
+// 把 requests[*next] 起尽量多的请求放进提交队列并通知内核，返回放入的个数
+static int queueIoRequests(IoRequest* requests, int count, int* next, IoGroup* group)
+{
+    pthread_mutex_lock(&sqLock);
+
+    unsigned int head = __atomic_load_n(ring.sqHead, __ATOMIC_ACQUIRE);
+    unsigned int tail = *ring.sqTail;
+    unsigned int mask = *ring.sqMask;
+    int queued = 0;
+
+    while (*next < count && tail - head < ring.sqEntries &&
+           __atomic_load_n(&ring.inFlight, __ATOMIC_RELAXED) + (unsigned int)queued < ring.cqEntries)
+    {
+        IoRequest* request = &requests[*next];
+        request->group = group;
+        prepareIoSqe(&ring.sqes[tail & mask], request);
+        ring.sqArray[tail & mask] = tail & mask;
+        tail++;
+        (*next)++;
+        queued++;
+    }
+
+    if (queued > 0)
+    {
+        // 计数必须在内核可能完成这些请求之前加上
+        __atomic_add_fetch(&(group->pending), queued, __ATOMIC_RELAXED);
+        __atomic_add_fetch(&ring.inFlight, (unsigned int)queued, __ATOMIC_RELAXED);
+        __atomic_store_n(ring.sqTail, tail, __ATOMIC_RELEASE);
+
+        if (ring.setupFlags & IORING_SETUP_SQPOLL)
+        {
+            __atomic_thread_fence(__ATOMIC_SEQ_CST);
+            if (__atomic_load_n(ring.sqFlags, __ATOMIC_RELAXED) & IORING_SQ_NEED_WAKEUP)
+            {
+                ioUringEnter(ring.ringFd, 0, 0, IORING_ENTER_SQ_WAKEUP);
+            }
+        }
+        else
+        {
+            unsigned int toSubmit = (unsigned int)queued;
+            while (toSubmit > 0)
+            {
+                int ret = ioUringEnter(ring.ringFd, toSubmit, 0, 0);
+                if (ret < 0)
+                {
+                    if (errno == EINTR || errno == EAGAIN || errno == EBUSY)
+                    {
+                        continue;
+                    }
+                    perror("io_uring_enter submit");
+                    break;
+                }
+                toSubmit -= (unsigned int)ret;
+            }
+        }
+    }
+
+    pthread_mutex_unlock(&sqLock);
+    return queued;
+}
+
+// 调用者持有 asyncLock
+static void pushReadyGroup(IoGroup* group)
+{
+    group->next = NULL;
+    if (readyTail != NULL)
+    {
+        readyTail->next = group;
+    }
+    else
+    {
+        readyHead = group;
+    }
+    readyTail = group;
+    asyncGroups--;
+    pthread_cond_signal(&asyncCond);
+}
+
+// 调用者持有 cqLock；收割所有已完成的事件，不论属于哪个线程
+static unsigned int reapIoCompletions(void)
+{
+    unsigned int head = *ring.cqHead;
+    unsigned int tail = __atomic_load_n(ring.cqTail, __ATOMIC_ACQUIRE);
+    unsigned int reaped = 0;
+
+    while (head != tail)
+    {
+        struct io_uring_cqe* cqe = &ring.cqes[head & *ring.cqMask];
+        IoRequest* request = (IoRequest*)(uintptr_t)cqe->user_data;
+        IoGroup* group = request->group;
+        int isAsync = (group->done != NULL);
+
+        // 同步批次的计数减到 0 后提交者可能立即返回，之后不能再访问 request 与 group
+        request->result = cqe->res;
+        if (__atomic_sub_fetch(&(group->pending), 1, __ATOMIC_ACQ_REL) == 0 && isAsync)
+        {
+            pthread_mutex_lock(&asyncLock);
+            pushReadyGroup(group);
+            pthread_mutex_unlock(&asyncLock);
+        }
+        head++;
+        reaped++;
+    }
+
+    __atomic_store_n(ring.cqHead, head, __ATOMIC_RELEASE);
+    __atomic_sub_fetch(&ring.inFlight, reaped, __ATOMIC_RELAXED);
+    return reaped;
+}
+
+// 本批还有请求未完成，或提交队列已满需要腾出位置时，在内核中等待至少一个完成事件
+static void waitIoCompletions(IoGroup* group, int queueFull)
+{
+    if (!queueFull && (group == NULL || __atomic_load_n(&(group->pending), __ATOMIC_ACQUIRE) == 0))
+    {
+        return;
+    }
+
+    __atomic_add_fetch(&cqWaiters, 1, __ATOMIC_SEQ_CST);
+    pthread_mutex_lock(&cqLock);
+    unsigned int reaped = reapIoCompletions();
+    while (reaped == 0 && (queueFull || (group != NULL && __atomic_load_n(&(group->pending), __ATOMIC_ACQUIRE) > 0)) &&
+           __atomic_load_n(&ring.inFlight, __ATOMIC_RELAXED) > 0)
+    {
+        if (ioUringEnter(ring.ringFd, 0, 1, IORING_ENTER_GETEVENTS) < 0 && errno != EINTR && errno != EAGAIN)
+        {
+            perror("io_uring_enter wait");
+            break;
+        }
+        reaped = reapIoCompletions();
+    }
+    pthread_mutex_unlock(&cqLock);
+
+    // 最后一个同步等待者离开后，由完成线程接着收割异步批次
+    pthread_mutex_lock(&asyncLock);
+    if (__atomic_sub_fetch(&cqWaiters, 1, __ATOMIC_SEQ_CST) == 0 && asyncGroups > 0)
+    {
+        pthread_cond_signal(&asyncCond);
+    }
+    pthread_mutex_unlock(&asyncLock);
+}
+
+// 调用者持有 engineLock 读锁
+static void runIoBatch(IoRequest* requests, int count)
+{
+    IoGroup group;
+    int next = 0;
+
+    memset(&group, 0, sizeof(group));
+    while (next < count || __atomic_load_n(&(group.pending), __ATOMIC_ACQUIRE) > 0)
+    {
+        int queued = (next < count) ? queueIoRequests(requests, count, &next, &group) : 0;
+        waitIoCompletions(&group, next < count && queued == 0);
+    }
+}
+
+// 异步完成的短读写与出错的请求改用同步路径补齐或重试
+static void finishIoRequest(IoRequest* request)
+{
+    size_t expected = 0;
+    for (int i = 0; i < request->iovcnt; i++)
+    {
+        expected += request->iov[i].iov_len;
+    }
+
+    if (request->result < 0)
+    {
+        request->result = transferFull(request->fd, request->iov, request->iovcnt, request->offset, request->isWrite);
+    }
+    else if (request->result > 0 && (size_t)request->result < expected)
+    {
+        struct iovec* iov = request->iov;
+        int iovcnt = request->iovcnt;
+        advanceIov(&iov, &iovcnt, (size_t)request->result);
+
+        ssize_t rest = transferFull(request->fd, iov, iovcnt, request->offset + request->result, request->isWrite);
+        request->result = (rest < 0) ? -1 : request->result + rest;
+    }
+}
+
+
+static void runReadyGroups(IoGroup* group)
+{
+    while (group != NULL)
+    {
+        IoGroup* next = group->next;
+        for (int i = 0; i < group->count; i++)
+        {
+            finishIoRequest(&(group->requests[i]));
+        }
+        group->done(group->arg);
+        free(group);
+        group = next;
+
+        pthread_mutex_lock(&asyncLock);
+        if (--asyncActive == 0)
+        {
+            pthread_cond_broadcast(&asyncDrainCond);
+        }
+        pthread_mutex_unlock(&asyncLock);
+    }
+}
+
+static int hasReadyGroups(void)
+{
+    pthread_mutex_lock(&asyncLock);
+    int ready = (readyHead != NULL);
+    pthread_mutex_unlock(&asyncLock);
+    return ready;
+}
+
+static void* completionMain(void* unused)
+{
+    (void)unused;
+
+    pthread_mutex_lock(&asyncLock);
+    while (completionRunning || readyHead != NULL)
+    {
+        if (readyHead != NULL)
+        {
+            IoGroup* ready = readyHead;
+            readyHead = readyTail = NULL;
+            pthread_mutex_unlock(&asyncLock);
+            runReadyGroups(ready);
+            pthread_mutex_lock(&asyncLock);
+            continue;
+        }
+        if (asyncGroups == 0 || __atomic_load_n(&cqWaiters, __ATOMIC_SEQ_CST) > 0)
+        {
+            pthread_cond_wait(&asyncCond, &asyncLock);
+            continue;
+        }
+        pthread_mutex_unlock(&asyncLock);
+
+        // 同步等待者此后若在 cqLock 上阻塞，它等的完成事件同样会唤醒这里
+        pthread_mutex_lock(&cqLock);
+        if (reapIoCompletions() == 0 && !hasReadyGroups() &&
+            __atomic_load_n(&cqWaiters, __ATOMIC_SEQ_CST) == 0 && __atomic_load_n(&ring.inFlight, __ATOMIC_RELAXED) > 0)
+        {
+            if (ioUringEnter(ring.ringFd, 0, 1, IORING_ENTER_GETEVENTS) < 0 && errno != EINTR && errno != EAGAIN)
+            {
+                perror("io_uring_enter wait");
+            }
+            reapIoCompletions();
+        }
+        pthread_mutex_unlock(&cqLock);
+        pthread_mutex_lock(&asyncLock);
+    }
+    pthread_mutex_unlock(&asyncLock);
+    return NULL;
+}
+
+int startIoEngine(const IoEngineOptions* options)
+{
+    IoEngineOptions resolved = {0};
+    if (options != NULL)
+    {
+        resolved = *options;
+    }
+    if (resolved.entries == 0)
+    {
+        resolved.entries = IO_ENGINE_DEFAULT_ENTRIES;
+    }
+    if (resolved.entries > IO_ENGINE_MAX_ENTRIES)
+    {
+        resolved.entries = IO_ENGINE_MAX_ENTRIES;
+    }
+    if (resolved.sqpollIdleMs == 0)
+    {
+        resolved.sqpollIdleMs = IO_ENGINE_DEFAULT_SQPOLL_IDLE_MS;
+    }
+
+    pthread_rwlock_wrlock(&engineLock);
+    if (engineRunning)
+    {
+        pthread_rwlock_unlock(&engineLock);
+        return 0;
+    }
+
+    struct io_uring_params params;
+    memset(&params, 0, sizeof(params));
+    if (resolved.sqpoll)
+    {
+        params.flags |= IORING_SETUP_SQPOLL;
+        params.sq_thread_idle = resolved.sqpollIdleMs;
+    }
+
+    memset(&ring, 0, sizeof(ring));
+    ring.ringFd = ioUringSetup(resolved.entries, &params);
+    if (ring.ringFd < 0)
+    {
+        perror("io_uring unavailable, using synchronous I/O");
+        pthread_rwlock_unlock(&engineLock);
+        return -1;
+    }
+    ring.setupFlags = params.flags;
+
+    if (mapIoRing(&ring, &params) < 0)
+    {
+        perror("Failed to map io_uring rings");
+        close(ring.ringFd);
+        pthread_rwlock_unlock(&engineLock);
+        return -1;
+    }
+
+    // 固定缓冲区表按槽位稀疏登记，块池之后新增的内存段再逐个填入
+    struct io_uring_rsrc_register reg;
+    memset(&reg, 0, sizeof(reg));
+    reg.nr = IO_ENGINE_MAX_BUFFERS;
+    reg.flags = IORING_RSRC_REGISTER_SPARSE;
+    ring.fixedBuffers = (ioUringRegister(ring.ringFd, IORING_REGISTER_BUFFERS2, &reg, sizeof(reg)) >= 0);
+
+    pthread_mutex_lock(&sqLock);
+    for (unsigned int slot = 0; ring.fixedBuffers && slot < IO_ENGINE_MAX_BUFFERS; slot++)
+    {
+        if (ioBuffers[slot].used)
+        {
+            updateFixedBuffer(slot);
+        }
+    }
+    pthread_mutex_unlock(&sqLock);
+
+    completionRunning = 1;
+    int ret = pthread_create(&completionThread, NULL, completionMain, NULL);
+    if (ret != 0)
+    {
+        fprintf(stderr, "Error: Failed to create io completion thread: %s\n", strerror(ret));
+        completionRunning = 0;
+        unmapIoRing(&ring);
+        close(ring.ringFd);
+        pthread_rwlock_unlock(&engineLock);
+        return -1;
+    }
+
+    __atomic_store_n(&engineRunning, 1, __ATOMIC_RELEASE);
+    pthread_rwlock_unlock(&engineLock);
+    return 0;
+}
+
+// 先拒绝新的异步批次，等已接受的批次连同 done 都执行完，再停止完成线程；
+// done 中再次提交会失败并改走同步路径，所以等待总能结束
+void stopIoEngine(void)
+{
+    pthread_mutex_lock(&asyncLock);
+    engineStopping = 1;
+    while (asyncActive > 0)
+    {
+        pthread_cond_wait(&asyncDrainCond, &asyncLock);
+    }
+    pthread_mutex_unlock(&asyncLock);
+
+    pthread_rwlock_wrlock(&engineLock);
+    if (!engineRunning)
+    {
+        pthread_rwlock_unlock(&engineLock);
+        pthread_mutex_lock(&asyncLock);
+        engineStopping = 0;
+        pthread_mutex_unlock(&asyncLock);
+        return;
+    }
+
+    __atomic_store_n(&engineRunning, 0, __ATOMIC_RELEASE);
+    pthread_mutex_lock(&asyncLock);
+    completionRunning = 0;
+    pthread_cond_signal(&asyncCond);
+    pthread_mutex_unlock(&asyncLock);
+    pthread_join(completionThread, NULL);
+
+    unmapIoRing(&ring);
+    close(ring.ringFd);
+
+    pthread_mutex_lock(&sqLock);
+    for (unsigned int slot = 0; slot < IO_ENGINE_MAX_BUFFERS; slot++)
+    {
+        ioBuffers[slot].fixed = 0;
+    }
+    pthread_mutex_unlock(&sqLock);
+
+    pthread_mutex_lock(&asyncLock);
+    engineStopping = 0;
+    pthread_mutex_unlock(&asyncLock);
+    pthread_rwlock_unlock(&engineLock);
+}
+
+int isIoEngineRunning(void)
+{
+    return __atomic_load_n(&engineRunning, __ATOMIC_ACQUIRE);
+}
+
+void initIoRequest(IoRequest* request, int fd, int isWrite, struct iovec* iov, int iovcnt, off_t offset)
+{
+    request->fd = fd;
+    request->isWrite = isWrite;
+    request->iov = iov;
+    request->iovcnt = iovcnt;
+    request->offset = offset;
+    request->bufferSlot = IO_ENGINE_NO_BUFFER;
+    request->result = 0;
+    request->group = NULL;
+}
+
+// 单个请求单独走 ring 要多一次等待的系统调用；已有请求在途时可与它们一起提交和收割，
+// SQPOLL 的轮询线程醒着时提交本身也不需要系统调用
+static int preferRingForSingle(void)
+{
+    if (__atomic_load_n(&ring.inFlight, __ATOMIC_RELAXED) > 0)
+    {
+        return 1;
+    }
+    return (ring.setupFlags & IORING_SETUP_SQPOLL) &&
+           !(__atomic_load_n(ring.sqFlags, __ATOMIC_ACQUIRE) & IORING_SQ_NEED_WAKEUP);
+}
+
+void submitIoBatch(IoRequest* requests, int count)
+{
+    if (count > 0 && isIoEngineRunning())
+    {
+        pthread_rwlock_rdlock(&engineLock);
+        if (engineRunning && (count > 1 || preferRingForSingle()))
+        {
+            runIoBatch(requests, count);
+            pthread_rwlock_unlock(&engineLock);
+
+            for (int i = 0; i < count; i++)
+            {
+                finishIoRequest(&requests[i]);
+            }
+            return;
+        }
+        pthread_rwlock_unlock(&engineLock);
+    }
+
+    for (int i = 0; i < count; i++)
+    {
+        requests[i].result = transferFull(requests[i].fd, requests[i].iov, requests[i].iovcnt,
+                                          requests[i].offset, requests[i].isWrite);
+    }
+}
+
+int submitIoAsync(IoRequest* requests, int count, IoDoneCallback done, void* arg)
+{
+    if (count <= 0 || done == NULL || !isIoEngineRunning())
+    {
+        return -1;
+    }
+
+    IoGroup* group = (IoGroup*)calloc(1, sizeof(IoGroup));
+    if (group == NULL)
+    {
+        perror("Failed to allocate io group");
+        return -1;
+    }
+    // 多出的一个计数在全部请求放入队列后才去掉，避免前面的请求先完成时提前执行 done
+    group->pending = 1;
+    group->requests = requests;
+    group->count = count;
+    group->done = done;
+    group->arg = arg;
+
+    pthread_rwlock_rdlock(&engineLock);
+    pthread_mutex_lock(&asyncLock);
+    if (!engineRunning || engineStopping)
+    {
+        pthread_mutex_unlock(&asyncLock);
+        pthread_rwlock_unlock(&engineLock);
+        free(group);
+        return -1;
+    }
+    asyncActive++;
+    pthread_mutex_unlock(&asyncLock);
+
+    int next = 0;
+    while (next < count)
+    {
+        int queued = queueIoRequests(requests, count, &next, group);
+        if (next < count && queued == 0)
+        {
+            waitIoCompletions(NULL, 1);
+        }
+    }
+
+    pthread_mutex_lock(&asyncLock);
+    asyncGroups++;
+    if (__atomic_sub_fetch(&(group->pending), 1, __ATOMIC_ACQ_REL) == 0)
+    {
+        pushReadyGroup(group);
+    }
+    pthread_cond_signal(&asyncCond);
+    pthread_mutex_unlock(&asyncLock);
+    pthread_rwlock_unlock(&engineLock);
+    return 0;
+}
+
+unsigned int registerIoBuffer(void* base, size_t length)
+{
+    unsigned int slot = IO_ENGINE_NO_BUFFER;
+
+    pthread_rwlock_rdlock(&engineLock);
+    pthread_mutex_lock(&sqLock);
+    for (unsigned int i = 0; i < IO_ENGINE_MAX_BUFFERS; i++)
+    {
+        if (!ioBuffers[i].used)
+        {
+            ioBuffers[i].base = base;
+            ioBuffers[i].length = length;
+            ioBuffers[i].used = 1;
+            ioBuffers[i].fixed = 0;
+            slot = i;
+            break;
+        }
+    }
+    if (slot == IO_ENGINE_NO_BUFFER && !bufferTableFull)
+    {
+        bufferTableFull = 1;
+        fprintf(stderr, "Warning: All %d io buffer slots are in use, new memory segments will not use fixed buffers\n",
+                IO_ENGINE_MAX_BUFFERS);
+    }
+    if (slot != IO_ENGINE_NO_BUFFER && engineRunning && ring.fixedBuffers)
+    {
+        updateFixedBuffer(slot);
+    }
+    pthread_mutex_unlock(&sqLock);
+    pthread_rwlock_unlock(&engineLock);
+    return slot;
+}
+
+// 内存段释放前调用
+void unregisterIoBuffer(unsigned int slot)
+{
+    if (slot >= IO_ENGINE_MAX_BUFFERS)
+    {
+        return;
+    }
+
+    pthread_rwlock_rdlock(&engineLock);
+    pthread_mutex_lock(&sqLock);
+    ioBuffers[slot].used = 0;
+    if (ioBuffers[slot].fixed)
+    {
+        updateFixedBuffer(slot);
+    }
+    ioBuffers[slot].base = NULL;
+    ioBuffers[slot].length = 0;
+    pthread_mutex_unlock(&sqLock);
+    pthread_rwlock_unlock(&engineLock);
+}
@@ -0,0 +1,67 @@
+#ifndef IO_ENGINE_H
+#define IO_ENGINE_H
+
+#include <stddef.h>
+#include <sys/types.h>
+#include <sys/uio.h>
+
+#define IO_ENGINE_DEFAULT_ENTRIES 64
+#define IO_ENGINE_MAX_ENTRIES 4096
+#define IO_ENGINE_DEFAULT_SQPOLL_IDLE_MS 1000
+// 固定缓冲区表的槽位数，块池每个内存段占一个；可在编译时用 -DIO_ENGINE_MAX_BUFFERS=N 调整
+#ifndef IO_ENGINE_MAX_BUFFERS
+#define IO_ENGINE_MAX_BUFFERS 1024
+#endif
+#define IO_ENGINE_NO_BUFFER 0xFFFF
+
+#if IO_ENGINE_MAX_BUFFERS >= IO_ENGINE_NO_BUFFER
+#error "IO_ENGINE_MAX_BUFFERS must be below IO_ENGINE_NO_BUFFER"
+#endif
+
+struct IoGroup;
+typedef void (*IoDoneCallback)(void* arg);
+
+// startIoEngine 的参数，传 NULL 或置 0 的字段使用默认值
+typedef struct IoEngineOptions
+{
+    unsigned int entries;       // 提交队列深度
+    int sqpoll;                 // 非 0 时由内核线程轮询提交队列，省去提交时的系统调用
+    unsigned int sqpollIdleMs;  // 轮询线程空闲多久后休眠
+} IoEngineOptions;
+
+// 一次读写请求；result 在完成后为传输的字节数，出错时为 -1 并设置 errno
+typedef struct IoRequest
+{
+    int fd;
+    int isWrite;
+    struct iovec* iov;
+    int iovcnt;
+    off_t offset;
+    unsigned int bufferSlot;    // 单段请求所在的已登记内存段，IO_ENGINE_NO_BUFFER 表示没有
+    ssize_t result;
+    struct IoGroup* group;      // 引擎内部使用
+} IoRequest;
+
+
+// io_uring 不可用时返回 -1，之后的 I/O 继续走同步路径
+int startIoEngine(const IoEngineOptions* options);
+// 等已提交的异步批次连同 done 执行完后停止；调用者不能持有 done 中要取的锁
+void stopIoEngine(void);
+int isIoEngineRunning(void);
+
+void initIoRequest(IoRequest* request, int fd, int isWrite, struct iovec* iov, int iovcnt, off_t offset);
+
+// 提交一批请求并等待全部完成；引擎未启动时逐个同步执行，
+// 只有一个请求时除非已有请求在途或开启了 SQPOLL，也直接同步执行。
+// 短读写会补齐，读到文件末尾时提前结束
+void submitIoBatch(IoRequest* requests, int count);
+
+// 异步提交一批请求，全部完成（含短读写补齐）后在引擎的完成线程中调用 done(arg)；
+// 请求数组在此之前必须保持有效。提交队列满时会等待出现空位，引擎未运行或正在停止时返回 -1
+int submitIoAsync(IoRequest* requests, int count, IoDoneCallback done, void* arg);
+
+// 块池的内存段在创建时登记，引擎运行期间可作为 io_uring 的固定缓冲区使用
+unsigned int registerIoBuffer(void* base, size_t length);
+void unregisterIoBuffer(unsigned int slot);
+
+#endif
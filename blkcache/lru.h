@@ -1,40 +1,26 @@
 #ifndef LRU_H
 #define LRU_H
 
+struct cache;
 
-#define CAPACITY 4  
-#define HASH_FUNCTION(key) ((key) % CAPACITY)
-#define GET_LRU_TAIL_KEY(hash) ((hash)->lruTail ? (hash)->lruTail->key : -1)
+#define GET_LRU_TAIL(list) ((list)->lruTail)
 
+// 全局访问时钟，用于在多个 fd 之间比较冷热
+extern unsigned long lruClock;
 
-typedef struct lruNode
-{
-    long key;
-    struct lruNode* lruPre;
-    struct lruNode* lruNext;
-} lruNode;
-
-typedef struct hashNode
-{
-    lruNode *curNode;
-    struct hashNode *hashNext;  
-} hashNode;
-
-typedef struct 
+// 侵入式 LRU 链表，链表指针直接存放在缓存项中
+typedef struct LRUList
 {
     int size;
-    lruNode *lruHead;
-    lruNode *lruTail;
-    hashNode *hashTable[CAPACITY];
-} LRUHash;
+    struct cache* lruHead;
+    struct cache* lruTail;
+} LRUList;
 
 
-LRUHash *createHash();
-void createAndAddLRUNode(long key, LRUHash *Hash);
-void moveNodeToHeadByKey(LRUHash *Hash, long key);
-void deleteLRUNodeByKey(LRUHash *Hash, long key);
-long deleteLRUTail(LRUHash *Hash);
-void freeHash(LRUHash *Hash);
-void printLRUList(LRUHash *hash);
+void initLRUList(LRUList* list);
+void addToHead(LRUList* list, struct cache* node);
+void moveToHead(LRUList* list, struct cache* node);
+void deleteLRUNode(LRUList* list, struct cache* node);
+void printLRUList(LRUList* list);
 
-#endif
\ No newline at end of file
+#endif
@@ -14,7 +14,7 @@
 int main(void) {
     // 使用 openWithCache 接口打开设备文件
 
-    int fd = openWithCache(DEVICE_FILE, O_RDWR, 0, CACHE_TYPE_DEVICE);
+    int fd = openWithCache(DEVICE_FILE, O_RDWR, 0, CACHE_TYPE_DEVICE, NULL);
     if (fd < 0) {
         perror("openWithCache error");
         return EXIT_FAILURE;
@@ -0,0 +1,129 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "readahead.h"
+#include "cacheIOHandler.h"
+
+
+ReadaheadState* createReadahead(size_t blockSize, size_t maxWindow, off_t originSize)
+{
+    ReadaheadState* ra = (ReadaheadState*)calloc(1, sizeof(ReadaheadState));
+    if (ra == NULL)
+    {
+        perror("Failed to allocate readahead state");
+        return NULL;
+    }
+
+    ra->blockSize = blockSize;
+    ra->limitWindow = MAX(maxWindow, blockSize);
+    ra->maxWindow = ra->limitWindow;
+    ra->originSize = originSize;
+    initStreamTable(&(ra->table), blockSize);
+    pthread_mutex_init(&(ra->lock), NULL);
+    return ra;
+}
+
+// 记录一次读请求，若需要预读则返回预读长度并通过 prefetchOffset 给出起点
+static size_t updateStreams(ReadaheadState* ra, off_t offset, size_t count, off_t* prefetchOffset)
+{
+    off_t end = offset + (off_t)count;
+    int isNew = 0;
+    ReadaheadStream* s = &(ra->streams[trackStream(&(ra->table), offset, count, &isNew)]);
+
+    if (isNew)
+    {
+        s->raEnd = end;
+        s->window = 0;
+        return 0;
+    }
+
+    // 读者距离已预读末尾还有超过半个窗口时不发起新的预读
+    if (s->raEnd > end && (size_t)(s->raEnd - end) > s->window / 2)
+    {
+        return 0;
+    }
+
+    s->window = (s->window == 0) ? READAHEAD_INITIAL_WINDOW : s->window * 2;
+    s->window = MIN(s->window, ra->maxWindow);
+
+    off_t alignedEnd = (end + (off_t)ra->blockSize - 1) & ~((off_t)ra->blockSize - 1);
+    off_t start = MAX(s->raEnd, alignedEnd);
+    if (start >= ra->originSize)
+    {
+        return 0;
+    }
+
+    size_t length = MIN(s->window, (size_t)(ra->originSize - start));
+    s->raEnd = start + (off_t)length;
+    *prefetchOffset = start;
+    return length;
+}
+
+// 多个线程共用一个 fd 时，状态正被其他线程更新就跳过本次检测，不让读路径排队
+size_t readaheadOnRead(ReadaheadState* ra, off_t offset, size_t count, off_t* prefetchOffset)
+{
+    if (pthread_mutex_trylock(&(ra->lock)) != 0)
+    {
+        return 0;
+    }
+
+    size_t length = updateStreams(ra, offset, count, prefetchOffset);
+    pthread_mutex_unlock(&(ra->lock));
+    return length;
+}
+
+void noteReadaheadPrefetched(ReadaheadState* ra, unsigned long blocks)
+{
+    pthread_mutex_lock(&(ra->lock));
+    ra->prefetchedBlocks += blocks;
+    pthread_mutex_unlock(&(ra->lock));
+}
+
+void noteReadaheadUsed(ReadaheadState* ra)
+{
+    pthread_mutex_lock(&(ra->lock));
+    ra->usedBlocks++;
+    ra->usedSinceGrow++;
+
+    // 一整个窗口都被用上后才允许窗口上限翻倍
+    if (ra->maxWindow < ra->limitWindow && ra->usedSinceGrow * ra->blockSize >= ra->maxWindow)
+    {
+        ra->maxWindow = MIN(ra->maxWindow * 2, ra->limitWindow);
+        ra->usedSinceGrow = 0;
+    }
+    pthread_mutex_unlock(&(ra->lock));
+}
+
+void noteReadaheadWasted(ReadaheadState* ra)
+{
+    pthread_mutex_lock(&(ra->lock));
+    ra->wastedBlocks++;
+    ra->usedSinceGrow = 0;
+    ra->maxWindow = MAX(ra->maxWindow / 2, ra->blockSize);
+
+    for (int i = 0; i < STREAM_TABLE_SIZE; i++)
+    {
+        ra->streams[i].window = MIN(ra->streams[i].window, ra->maxWindow);
+    }
+    pthread_mutex_unlock(&(ra->lock));
+}
+
+void noteOriginExtended(ReadaheadState* ra, off_t end)
+{
+    pthread_mutex_lock(&(ra->lock));
+    if (end > ra->originSize)
+    {
+        ra->originSize = end;
+    }
+    pthread_mutex_unlock(&(ra->lock));
+}
+
+void destroyReadahead(ReadaheadState* ra)
+{
+    if (ra == NULL)
+    {
+        return;
+    }
+    pthread_mutex_destroy(&(ra->lock));
+    free(ra);
+}
@@ -0,0 +1,44 @@
+#ifndef READAHEAD_H
+#define READAHEAD_H
+
+#include <stddef.h>
+#include <pthread.h>
+#include <sys/types.h>
+
+#include "streamTable.h"
+
+#define READAHEAD_INITIAL_WINDOW (128UL << 10)
+#define READAHEAD_DEFAULT_MAX_WINDOW (2UL << 20)
+
+// 每条顺序流的预读进度，与 table 中的流按下标对应
+typedef struct ReadaheadStream
+{
+    off_t raEnd;
+    size_t window;
+} ReadaheadStream;
+
+typedef struct ReadaheadState
+{
+    StreamTable table;
+    ReadaheadStream streams[STREAM_TABLE_SIZE];
+    size_t blockSize;
+    size_t limitWindow;     // 配置的窗口上限
+    size_t maxWindow;       // 当前允许的窗口上限，预读块被浪费时收缩
+    size_t usedSinceGrow;
+    off_t originSize;
+    unsigned long prefetchedBlocks;
+    unsigned long usedBlocks;
+    unsigned long wastedBlocks;
+    pthread_mutex_t lock;
+} ReadaheadState;
+
+
+ReadaheadState* createReadahead(size_t blockSize, size_t maxWindow, off_t originSize);
+size_t readaheadOnRead(ReadaheadState* ra, off_t offset, size_t count, off_t* prefetchOffset);
+void noteReadaheadPrefetched(ReadaheadState* ra, unsigned long blocks);
+void noteReadaheadUsed(ReadaheadState* ra);
+void noteReadaheadWasted(ReadaheadState* ra);
+void noteOriginExtended(ReadaheadState* ra, off_t end);
+void destroyReadahead(ReadaheadState* ra);
+
+#endif
@@ -0,0 +1,188 @@
+#include <stdio.h>
+
+#include "cacheStruct.h"
+#include "replacementPolicy.h"
+
+static const ReplacementPolicyOps* const policyTable[CACHE_POLICY_COUNT] =
+{
+    &lruPolicyOps,
+    &arcPolicyOps,
+    &twoQueuePolicyOps,
+    &s3FifoPolicyOps,
+    &clockPolicyOps,
+};
+
+
+int initReplacementState(ReplacementState* rs, int policy)
+{
+    if (policy < 0 || policy >= CACHE_POLICY_COUNT)
+    {
+        fprintf(stderr, "Error: Invalid cache replacement policy %d\n", policy);
+        return -1;
+    }
+
+    rs->ops = policyTable[policy];
+    for (int i = 0; i < POLICY_MAX_LISTS; i++)
+    {
+        initLRUList(&(rs->lists[i]));
+    }
+    for (int i = 0; i < POLICY_MAX_GHOSTS; i++)
+    {
+        initGhostList(&(rs->ghosts[i]));
+    }
+    rs->target = 0;
+    return 0;
+}
+
+void destroyReplacementState(ReplacementState* rs)
+{
+    for (int i = 0; i < POLICY_MAX_GHOSTS; i++)
+    {
+        destroyGhostList(&(rs->ghosts[i]));
+    }
+}
+
+size_t replacementSize(const ReplacementState* rs)
+{
+    size_t size = 0;
+    for (int i = 0; i < POLICY_MAX_LISTS; i++)
+    {
+        size += (size_t)rs->lists[i].size;
+    }
+    return size;
+}
+
+// 访问时间统一在这里打上，供跨 fd、跨分片比较冷热；
+// 时钟只在插入时前进，命中时仅读取当前值，避免所有线程争用同一个计数器
+void replacementInsert(ReplacementState* rs, cache* entry, long key)
+{
+    entry->atime = __atomic_add_fetch(&lruClock, 1, __ATOMIC_RELAXED);
+    entry->freq = 0;
+    rs->ops->insert(rs, entry, key);
+}
+
+// 时钟没前进时不写：读锁下的命中大多落在同一批块上，只读不写才不会让缓存行在读者之间来回失效
+void replacementHit(ReplacementState* rs, cache* entry)
+{
+    unsigned long now = __atomic_load_n(&lruClock, __ATOMIC_RELAXED);
+    if (__atomic_load_n(&(entry->atime), __ATOMIC_RELAXED) != now)
+    {
+        __atomic_store_n(&(entry->atime), now, __ATOMIC_RELAXED);
+    }
+    rs->ops->hit(rs, entry);
+}
+
+cache* replacementVictim(ReplacementState* rs)
+{
+    return rs->ops->victim(rs);
+}
+
+void replacementEvict(ReplacementState* rs, cache* entry, long key)
+{
+    rs->ops->evict(rs, entry, key);
+}
+
+void replacementRemove(ReplacementState* rs, cache* entry)
+{
+    rs->ops->remove(rs, entry);
+}
+
+cache* replacementNext(ReplacementState* rs, cache* entry)
+{
+    return rs->ops->next(rs, entry);
+}
+
+
+void policyListPush(ReplacementState* rs, int list, cache* entry)
+{
+    entry->policyList = (unsigned char)list;
+    addToHead(&(rs->lists[list]), entry);
+}
+
+void policyListRemove(ReplacementState* rs, cache* entry)
+{
+    deleteLRUNode(&(rs->lists[entry->policyList]), entry);
+}
+
+// 把块移到 list 的头部（可以是另一条链表）
+void policyListRequeue(ReplacementState* rs, int list, cache* entry)
+{
+    policyListRemove(rs, entry);
+    policyListPush(rs, list, entry);
+}
+
+// 从链表尾部起第一个不在写回中、也没有被引用的块
+cache* policyListVictim(ReplacementState* rs, int list)
+{
+    for (cache* node = GET_LRU_TAIL(&(rs->lists[list])); node != NULL; node = node->lruPre)
+    {
+        if (!IS_CACHE_BUSY(node))
+        {
+            return node;
+        }
+    }
+    return NULL;
+}
+
+// 依次从 lists[0] 到 lists[listCount-1] 的尾部向头部遍历
+cache* policyListsNext(ReplacementState* rs, cache* entry, int listCount)
+{
+    int list = 0;
+    if (entry != NULL)
+    {
+        if (entry->lruPre != NULL)
+        {
+            return entry->lruPre;
+        }
+        list = entry->policyList + 1;
+    }
+
+    for (; list < listCount; list++)
+    {
+        if (rs->lists[list].lruTail != NULL)
+        {
+            return rs->lists[list].lruTail;
+        }
+    }
+    return NULL;
+}
+
+
+static void lruInsert(ReplacementState* rs, cache* entry, long key)
+{
+    (void)key;
+    policyListPush(rs, 0, entry);
+}
+
+static void lruHit(ReplacementState* rs, cache* entry)
+{
+    moveToHead(&(rs->lists[0]), entry);
+}
+
+static cache* lruVictim(ReplacementState* rs)
+{
+    return policyListVictim(rs, 0);
+}
+
+static void lruEvict(ReplacementState* rs, cache* entry, long key)
+{
+    (void)key;
+    policyListRemove(rs, entry);
+}
+
+static cache* lruNext(ReplacementState* rs, cache* entry)
+{
+    return policyListsNext(rs, entry, 1);
+}
+
+const ReplacementPolicyOps lruPolicyOps =
+{
+    "lru",
+    0,
+    lruInsert,
+    lruHit,
+    lruVictim,
+    lruEvict,
+    policyListRemove,
+    lruNext,
+};
@@ -0,0 +1,72 @@
+#ifndef REPLACEMENT_POLICY_H
+#define REPLACEMENT_POLICY_H
+
+#include <stddef.h>
+
+#include "lru.h"
+#include "ghostList.h"
+
+struct cache;
+
+#define CACHE_POLICY_LRU 0
+#define CACHE_POLICY_ARC 1
+#define CACHE_POLICY_2Q 2
+#define CACHE_POLICY_S3FIFO 3
+#define CACHE_POLICY_CLOCK 4
+#define CACHE_POLICY_COUNT 5
+
+#define POLICY_MAX_LISTS 2
+#define POLICY_MAX_GHOSTS 2
+
+struct ReplacementPolicyOps;
+
+// 每个分片一份替换状态；各策略按需使用其中的链表与淘汰历史，
+// 缓存项的 policyList 字段记录它当前所在的链表
+typedef struct ReplacementState
+{
+    const struct ReplacementPolicyOps* ops;
+    LRUList lists[POLICY_MAX_LISTS];
+    GhostList ghosts[POLICY_MAX_GHOSTS];
+    size_t target;      // ARC 中 T1 的目标长度
+} ReplacementState;
+
+// 缓存核心在插入、命中和淘汰时调用的策略接口，调用者持有分片写锁；
+// sharedHit 为 1 的策略 hit 只用原子操作修改缓存项，调用者持读锁即可
+typedef struct ReplacementPolicyOps
+{
+    const char* name;
+    int sharedHit;
+    void (*insert)(ReplacementState* rs, struct cache* entry, long key);
+    void (*hit)(ReplacementState* rs, struct cache* entry);
+    struct cache* (*victim)(ReplacementState* rs);     // 选出下一个应淘汰的块，不选正在写回的块
+    void (*evict)(ReplacementState* rs, struct cache* entry, long key);    // 因淘汰而移除，可记入淘汰历史
+    void (*remove)(ReplacementState* rs, struct cache* entry);     // 因关闭等原因直接移除
+    struct cache* (*next)(ReplacementState* rs, struct cache* entry);  // 按大致淘汰顺序遍历，entry 为 NULL 时从头开始
+} ReplacementPolicyOps;
+
+extern const ReplacementPolicyOps lruPolicyOps;
+extern const ReplacementPolicyOps arcPolicyOps;
+extern const ReplacementPolicyOps twoQueuePolicyOps;
+extern const ReplacementPolicyOps s3FifoPolicyOps;
+extern const ReplacementPolicyOps clockPolicyOps;
+
+
+int initReplacementState(ReplacementState* rs, int policy);
+void destroyReplacementState(ReplacementState* rs);
+size_t replacementSize(const ReplacementState* rs);
+
+void replacementInsert(ReplacementState* rs, struct cache* entry, long key);
+void replacementHit(ReplacementState* rs, struct cache* entry);
+struct cache* replacementVictim(ReplacementState* rs);
+void replacementEvict(ReplacementState* rs, struct cache* entry, long key);
+void replacementRemove(ReplacementState* rs, struct cache* entry);
+struct cache* replacementNext(ReplacementState* rs, struct cache* entry);
+
+// 策略实现共用的链表辅助函数
+void policyListPush(ReplacementState* rs, int list, struct cache* entry);
+void policyListRemove(ReplacementState* rs, struct cache* entry);
+struct cache* policyListVictim(ReplacementState* rs, int list);
+struct cache* policyListsNext(ReplacementState* rs, struct cache* entry, int listCount);
+void policyListRequeue(ReplacementState* rs, int list, struct cache* entry);
+
+#endif
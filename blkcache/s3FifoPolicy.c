@@ -0,0 +1,107 @@
+#include "cacheStruct.h"
+#include "replacementPolicy.h"
+
+// S3-FIFO：新块进入小队列 S（约占 10%），在 S 中被访问超过一次的块淘汰时转入主队列 M，
+// 其余记入淘汰历史 G；命中只增加访问计数，不移动链表节点
+#define S3FIFO_SMALL 0
+#define S3FIFO_MAIN 1
+#define S3FIFO_GHOST 0
+
+#define S3FIFO_MAX_FREQ 3
+#define S3FIFO_SMALL_PERCENT 10
+
+
+static void s3FifoInsert(ReplacementState* rs, cache* entry, long key)
+{
+    if (takeGhost(&(rs->ghosts[S3FIFO_GHOST]), key))
+    {
+        policyListPush(rs, S3FIFO_MAIN, entry);
+    }
+    else
+    {
+        policyListPush(rs, S3FIFO_SMALL, entry);
+    }
+}
+
+// 可能在分片读锁下被多个线程同时调用，用 CAS 做饱和加一
+static void s3FifoHit(ReplacementState* rs, cache* entry)
+{
+    (void)rs;
+    unsigned char freq = __atomic_load_n(&(entry->freq), __ATOMIC_RELAXED);
+    while (freq < S3FIFO_MAX_FREQ &&
+           !__atomic_compare_exchange_n(&(entry->freq), &freq, freq + 1, 1, __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+    {
+    }
+}
+
+static cache* s3FifoVictim(ReplacementState* rs)
+{
+    size_t total = replacementSize(rs);
+
+    // 每个块最多被转移或降级几次，循环次数有上界
+    for (size_t budget = 4 * total + 1; budget > 0; budget--)
+    {
+        size_t small = (size_t)rs->lists[S3FIFO_SMALL].size;
+        int fromSmall = small > 0 && (small * 100 >= total * S3FIFO_SMALL_PERCENT || rs->lists[S3FIFO_MAIN].size == 0);
+        int list = fromSmall ? S3FIFO_SMALL : S3FIFO_MAIN;
+        cache* tail = GET_LRU_TAIL(&(rs->lists[list]));
+
+        if (tail == NULL)
+        {
+            return NULL;
+        }
+        if (IS_CACHE_BUSY(tail))
+        {
+            policyListRequeue(rs, list, tail);
+            continue;
+        }
+
+        if (fromSmall)
+        {
+            if (tail->freq > 1)
+            {
+                tail->freq = 0;
+                policyListRequeue(rs, S3FIFO_MAIN, tail);
+                continue;
+            }
+            return tail;
+        }
+
+        if (tail->freq > 0)
+        {
+            tail->freq--;
+            policyListRequeue(rs, S3FIFO_MAIN, tail);
+            continue;
+        }
+        return tail;
+    }
+    return NULL;
+}
+
+static void s3FifoEvict(ReplacementState* rs, cache* entry, long key)
+{
+    int list = entry->policyList;
+
+    policyListRemove(rs, entry);
+    if (list == S3FIFO_SMALL)
+    {
+        addGhost(&(rs->ghosts[S3FIFO_GHOST]), key, (size_t)rs->lists[S3FIFO_MAIN].size + 1);
+    }
+}
+
+static cache* s3FifoNext(ReplacementState* rs, cache* entry)
+{
+    return policyListsNext(rs, entry, 2);
+}
+
+const ReplacementPolicyOps s3FifoPolicyOps =
+{
+    "s3fifo",
+    1,
+    s3FifoInsert,
+    s3FifoHit,
+    s3FifoVictim,
+    s3FifoEvict,
+    policyListRemove,
+    s3FifoNext,
+};
@@ -0,0 +1,952 @@
+// blkcache-sim：把 startCacheTrace 记录的访问序列离线回放给缓存的块索引与替换策略代码，
+// 对多种缓存大小与策略分别给出命中率、写回量与设备 I/O 次数，不读写任何数据
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <getopt.h>
+#include <sys/stat.h>
+
+#include "cacheTrace.h"
+#include "cacheStruct.h"
+#include "cacheIOHandler.h"
+#include "singleCacheHandler.h"
+#include "readahead.h"
+
+#define SIM_MAX_FDS 65536
+#define SIM_MAX_SIZES 32
+#define SIM_DEFAULT_BLOCK_SIZE 4096
+
+typedef struct SimConfig
+{
+    size_t sizes[SIM_MAX_SIZES];
+    int sizeCount;
+    int policies[CACHE_POLICY_COUNT];
+    int policyCount;
+    size_t blockSize;       // 0 使用记录中的块大小
+    int writePolicy;
+    int writeMissPolicy;
+    size_t readaheadBytes;  // CACHE_READAHEAD_DISABLED 关闭预读
+    unsigned int shardCount;
+    size_t maxIOBytes;
+} SimConfig;
+
+typedef struct SimShard
+{
+    BlockIndex* index;
+    ReplacementState policy;
+} SimShard;
+
+// 单个 fd 的模拟缓存集合：只有元数据，缓存项的 data 为 NULL
+typedef struct SimFile
+{
+    int fd;
+    int slot;           // 在 SimContext.openFiles 中的位置
+    size_t blockSize;
+    unsigned int blockShift;
+    unsigned int shardCount;
+    unsigned int victimCursor;
+    SimShard* shards;
+    ReadaheadState* ra;
+} SimFile;
+
+typedef struct SimResult
+{
+    unsigned long long hits;
+    unsigned long long misses;
+    unsigned long long readaheadHits;
+    unsigned long long prefetchedBlocks;
+    unsigned long long readOps;
+    unsigned long long readBytes;
+    unsigned long long writeOps;
+    unsigned long long writeBytes;
+    unsigned long long writeBackBytes;  // 脏块写回（淘汰与关闭时），不含直写
+    unsigned long long cleanEvictions;
+    unsigned long long dirtyEvictions;
+} SimResult;
+
+typedef struct SimTrace
+{
+    CacheTraceRecord* records;
+    size_t count;
+    off_t* extent;      // 每个 fd 访问到的最大偏移，OPEN 记录没有源大小时用来代替
+} SimTrace;
+
+typedef struct SimContext
+{
+    const SimConfig* config;
+    const SimTrace* trace;
+    int policy;
+    size_t capacity;
+    size_t residentBytes;
+    SimFile* files[SIM_MAX_FDS];
+    SimFile* openFiles[SIM_MAX_FDS];    // 选择淘汰对象时只遍历打开的 fd
+    int openCount;
+    SimResult result;
+} SimContext;
+
+// 一段连续的设备读：未命中块按请求内的相邻关系合并，与 prepareMissBatch 一致
+typedef struct SimReadRun
+{
+    off_t start;
+    size_t blocks;
+} SimReadRun;
+
+static unsigned int getBlockShift(size_t blockSize)
+{
+    unsigned int shift = 0;
+    while (((size_t)1 << shift) < blockSize)
+    {
+        shift++;
+    }
+    return shift;
+}
+
+static SimShard* getSimShard(SimFile* file, off_t offset)
+{
+    long key = (long)(offset >> file->blockShift);
+    return &(file->shards[key & (file->shardCount - 1)]);
+}
+
+static cache* findSimBlock(SimFile* file, off_t offset)
+{
+    return lookupBlockIndex(getSimShard(file, offset)->index, (long)(offset >> file->blockShift));
+}
+
+static void destroySimFile(SimFile* file)
+{
+    for (unsigned int i = 0; i < file->shardCount; i++)
+    {
+        destroyBlockIndex(file->shards[i].index);
+        destroyReplacementState(&(file->shards[i].policy));
+    }
+    free(file->shards);
+    destroyReadahead(file->ra);
+    free(file);
+}
+
+static SimFile* createSimFile(SimContext* ctx, int fd, size_t blockSize, off_t originSize)
+{
+    const SimConfig* config = ctx->config;
+    SimFile* file = (SimFile*)calloc(1, sizeof(SimFile));
+    if (file == NULL)
+    {
+        perror("Failed to allocate simulated cache set");
+        return NULL;
+    }
+
+    file->blockSize = blockSize;
+    file->blockShift = getBlockShift(blockSize);
+    file->shards = (SimShard*)calloc(config->shardCount, sizeof(SimShard));
+    if (file->shards == NULL)
+    {
+        perror("Failed to allocate simulated cache shards");
+        free(file);
+        return NULL;
+    }
+    for (unsigned int i = 0; i < config->shardCount; i++)
+    {
+        file->shards[i].index = createBlockIndex(0);
+        if (file->shards[i].index == NULL || initReplacementState(&(file->shards[i].policy), ctx->policy) < 0)
+        {
+            destroyBlockIndex(file->shards[i].index);
+            file->shards[i].index = NULL;
+            destroySimFile(file);
+            return NULL;
+        }
+        file->shardCount = i + 1;
+    }
+
+    if (config->readaheadBytes != CACHE_READAHEAD_DISABLED)
+    {
+        file->ra = createReadahead(blockSize, config->readaheadBytes, originSize);
+    }
+
+    file->fd = fd;
+    file->slot = ctx->openCount;
+    ctx->openFiles[ctx->openCount++] = file;
+    ctx->files[fd] = file;
+    return file;
+}
+
+static int compareCacheOffset(const void* a, const void* b)
+{
+    off_t left = (*(cache* const*)a)->offset;
+    off_t right = (*(cache* const*)b)->offset;
+    return (left > right) - (left < right);
+}
+
+static size_t maxRunBlocks(SimContext* ctx, SimFile* file)
+{
+    size_t blocks = MIN(MIN(ctx->config->maxIOBytes, ctx->capacity) / file->blockSize, (size_t)CACHE_MAX_IOV);
+    return (blocks > 0) ? blocks : 1;
+}
+
+// 写回集合中的所有脏块：按偏移排序后相邻的合并成一次写，与 traversalWriteBackCache 一致
+static void flushSimFile(SimContext* ctx, SimFile* file)
+{
+    size_t count = 0;
+    for (unsigned int n = 0; n < file->shardCount; n++)
+    {
+        count += replacementSize(&(file->shards[n].policy));
+    }
+    if (count == 0)
+    {
+        return;
+    }
+
+    cache** dirty = (cache**)malloc(count * sizeof(cache*));
+    if (dirty == NULL)
+    {
+        perror("Failed to allocate write back list");
+        return;
+    }
+
+    size_t dirtyCount = 0;
+    for (unsigned int n = 0; n < file->shardCount; n++)
+    {
+        ReplacementState* policy = &(file->shards[n].policy);
+        for (cache* entry = replacementNext(policy, NULL); entry != NULL; entry = replacementNext(policy, entry))
+        {
+            if (IS_CACHE_DIRTY(entry))
+            {
+                dirty[dirtyCount++] = entry;
+            }
+        }
+    }
+    qsort(dirty, dirtyCount, sizeof(cache*), compareCacheOffset);
+
+    size_t limit = maxRunBlocks(ctx, file);
+    size_t i = 0;
+    while (i < dirtyCount)
+    {
+        size_t run = 1;
+        while (i + run < dirtyCount && run < limit &&
+               dirty[i + run]->offset == dirty[i]->offset + (off_t)(run * file->blockSize))
+        {
+            run++;
+        }
+        for (size_t k = 0; k < run; k++)
+        {
+            CLEAR_CACHE_DIRTY(dirty[i + k]);
+        }
+        ctx->result.writeOps++;
+        ctx->result.writeBytes += run * file->blockSize;
+        ctx->result.writeBackBytes += run * file->blockSize;
+        i += run;
+    }
+    free(dirty);
+}
+
+static void closeSimFile(SimContext* ctx, int fd)
+{
+    SimFile* file = ctx->files[fd];
+    if (file == NULL)
+    {
+        return;
+    }
+
+    flushSimFile(ctx, file);
+    for (unsigned int n = 0; n < file->shardCount; n++)
+    {
+        ReplacementState* policy = &(file->shards[n].policy);
+        cache* entry;
+        while ((entry = replacementNext(policy, NULL)) != NULL)
+        {
+            replacementRemove(policy, entry);
+            free(entry);
+            ctx->residentBytes -= file->blockSize;
+        }
+    }
+    ctx->openCount--;
+    ctx->openFiles[file->slot] = ctx->openFiles[ctx->openCount];
+    ctx->openFiles[file->slot]->slot = file->slot;
+    ctx->files[fd] = NULL;
+    destroySimFile(file);
+}
+
+// 与 selectVictimFdNode 相同：每个集合从轮转的起点抽样最多 CACHE_VICTIM_SAMPLE 个非空分片，
+// 取下一个待淘汰块最久未被访问的分片
+static SimShard* selectSimVictim(SimContext* ctx, SimFile** victimFile)
+{
+    SimShard* victim = NULL;
+    unsigned long oldest = 0;
+
+    for (int i = 0; i < ctx->openCount; i++)
+    {
+        SimFile* file = ctx->openFiles[i];
+        unsigned int start = ++file->victimCursor;
+        unsigned int sampled = 0;
+        for (unsigned int n = 0; n < file->shardCount && sampled < CACHE_VICTIM_SAMPLE; n++)
+        {
+            SimShard* shard = &(file->shards[(start + n) & (file->shardCount - 1)]);
+            cache* tail = replacementNext(&(shard->policy), NULL);
+            if (tail == NULL)
+            {
+                continue;
+            }
+            sampled++;
+            if (victim == NULL || tail->atime < oldest)
+            {
+                victim = shard;
+                *victimFile = file;
+                oldest = tail->atime;
+            }
+        }
+    }
+    return victim;
+}
+
+// 与 evictTailCache 相同：脏块优先让位给淘汰顺序上靠近的干净块，只能淘汰脏块时先写回
+static int evictSimBlock(SimContext* ctx)
+{
+    SimFile* file = NULL;
+    SimShard* shard = selectSimVictim(ctx, &file);
+    cache* victim = (shard != NULL) ? replacementVictim(&(shard->policy)) : NULL;
+    if (victim == NULL)
+    {
+        return -1;
+    }
+
+    cache* candidate = victim;
+    for (int i = 0; i < CACHE_CLEAN_SCAN_DEPTH && candidate != NULL && IS_CACHE_DIRTY(victim); i++)
+    {
+        if (!IS_CACHE_DIRTY(candidate))
+        {
+            victim = candidate;
+        }
+        candidate = replacementNext(&(shard->policy), candidate);
+    }
+
+    if (IS_CACHE_DIRTY(victim))
+    {
+        ctx->result.dirtyEvictions++;
+        ctx->result.writeOps++;
+        ctx->result.writeBytes += file->blockSize;
+        ctx->result.writeBackBytes += file->blockSize;
+    }
+    else
+    {
+        ctx->result.cleanEvictions++;
+    }
+    if ((victim->flags & CACHE_FLAG_READAHEAD) && file->ra != NULL)
+    {
+        noteReadaheadWasted(file->ra);
+    }
+
+    long key = (long)(victim->offset >> file->blockShift);
+    replacementEvict(&(shard->policy), victim, key);
+    removeBlockIndex(shard->index, key);
+    free(victim);
+    ctx->residentBytes -= file->blockSize;
+    return 0;
+}
+
+static cache* insertSimBlock(SimContext* ctx, SimFile* file, off_t offset, unsigned int flags)
+{
+    while (ctx->residentBytes + file->blockSize > ctx->capacity)
+    {
+        if (evictSimBlock(ctx) < 0)
+        {
+            break;
+        }
+    }
+
+    SimShard* shard = getSimShard(file, offset);
+    long key = (long)(offset >> file->blockShift);
+    cache* entry = (cache*)calloc(1, sizeof(cache));
+    if (entry == NULL || insertBlockIndex(shard->index, key, entry) < 0)
+    {
+        fprintf(stderr, "Error: Failed to insert simulated block at offset %lld\n", (long long)offset);
+        free(entry);
+        return NULL;
+    }
+    entry->offset = offset;
+    entry->flags = flags;
+    replacementInsert(&(shard->policy), entry, key);
+    ctx->residentBytes += file->blockSize;
+    return entry;
+}
+
+static void addReadRun(SimContext* ctx, SimFile* file, SimReadRun* run, off_t offset)
+{
+    if (run->blocks > 0 && offset == run->start + (off_t)(run->blocks * file->blockSize) &&
+        run->blocks < maxRunBlocks(ctx, file))
+    {
+        run->blocks++;
+        return;
+    }
+    if (run->blocks > 0)
+    {
+        ctx->result.readOps++;
+        ctx->result.readBytes += run->blocks * file->blockSize;
+    }
+    run->start = offset;
+    run->blocks = 1;
+}
+
+static void finishReadRun(SimContext* ctx, SimFile* file, SimReadRun* run)
+{
+    if (run->blocks > 0)
+    {
+        ctx->result.readOps++;
+        ctx->result.readBytes += run->blocks * file->blockSize;
+        run->blocks = 0;
+    }
+}
+
+// 预读量不超过容量的四分之一，与 prefetchHostCache 一致
+static void prefetchSimFile(SimContext* ctx, SimFile* file, off_t offset, size_t length)
+{
+    off_t blockSize = (off_t)file->blockSize;
+    off_t end = offset + (off_t)MIN(length, MAX(ctx->capacity / 4, file->blockSize));
+    SimReadRun run = { 0, 0 };
+    unsigned long filled = 0;
+
+    for (off_t pos = ROUND_DOWN_TO_BLOCK(offset, blockSize); pos < end; pos += blockSize)
+    {
+        if (findSimBlock(file, pos) == NULL && insertSimBlock(ctx, file, pos, CACHE_FLAG_READAHEAD) != NULL)
+        {
+            addReadRun(ctx, file, &run, pos);
+            filled++;
+        }
+    }
+    finishReadRun(ctx, file, &run);
+    if (filled > 0)
+    {
+        noteReadaheadPrefetched(file->ra, filled);
+        ctx->result.prefetchedBlocks += filled;
+    }
+}
+
+static void readSimFile(SimContext* ctx, SimFile* file, off_t offset, size_t count)
+{
+    off_t blockSize = (off_t)file->blockSize;
+    off_t end = offset + (off_t)count;
+    SimReadRun run = { 0, 0 };
+
+    for (off_t pos = ROUND_DOWN_TO_BLOCK(offset, blockSize); pos < end; pos += blockSize)
+    {
+        SimShard* shard = getSimShard(file, pos);
+        cache* entry = findSimBlock(file, pos);
+        if (entry == NULL)
+        {
+            ctx->result.misses++;
+            if (insertSimBlock(ctx, file, pos, 0) != NULL)
+            {
+                addReadRun(ctx, file, &run, pos);
+            }
+            continue;
+        }
+
+        // 预读进来的块第一次被读到不更新替换状态
+        ctx->result.hits++;
+        if (entry->flags & CACHE_FLAG_READAHEAD)
+        {
+            ctx->result.readaheadHits++;
+            if (file->ra != NULL)
+            {
+                noteReadaheadUsed(file->ra);
+            }
+            entry->flags &= ~CACHE_FLAG_READAHEAD;
+        }
+        else
+        {
+            replacementHit(&(shard->policy), entry);
+        }
+    }
+    finishReadRun(ctx, file, &run);
+
+    if (file->ra != NULL)
+    {
+        off_t prefetchOffset = 0;
+        size_t prefetchBytes = readaheadOnRead(file->ra, offset, count, &prefetchOffset);
+        if (prefetchBytes > 0)
+        {
+            prefetchSimFile(ctx, file, prefetchOffset, prefetchBytes);
+        }
+    }
+}
+
+// 与 writeCacheBlock、writeHostWithoutCache、writeHostThrough 的处理一致
+static void writeSimBlock(SimContext* ctx, SimFile* file, off_t offset, size_t count)
+{
+    const SimConfig* config = ctx->config;
+    off_t alignedOffset = ROUND_DOWN_TO_BLOCK(offset, (off_t)file->blockSize);
+    SimShard* shard = getSimShard(file, alignedOffset);
+    cache* entry = findSimBlock(file, alignedOffset);
+    int fullBlock = (count == file->blockSize);
+
+    if (config->writePolicy != CACHE_WRITE_BACK)
+    {
+        int allocate = (config->writePolicy == CACHE_WRITE_THROUGH);
+        ctx->result.writeOps++;
+        ctx->result.writeBytes += count;
+        if (entry != NULL && allocate)
+        {
+            entry->flags &= ~CACHE_FLAG_READAHEAD;
+            replacementHit(&(shard->policy), entry);
+        }
+        else if (entry == NULL && allocate && (fullBlock || config->writeMissPolicy == CACHE_WRITE_ALLOCATE))
+        {
+            if (insertSimBlock(ctx, file, alignedOffset, 0) != NULL && !fullBlock)
+            {
+                ctx->result.readOps++;
+                ctx->result.readBytes += file->blockSize;
+            }
+        }
+        return;
+    }
+
+    if (entry != NULL)
+    {
+        entry->flags &= ~CACHE_FLAG_READAHEAD;
+        SET_CACHE_DIRTY(entry);
+        replacementHit(&(shard->policy), entry);
+        return;
+    }
+
+    if (!fullBlock && config->writeMissPolicy != CACHE_WRITE_ALLOCATE)
+    {
+        ctx->result.writeOps++;
+        ctx->result.writeBytes += count;
+        return;
+    }
+
+    entry = insertSimBlock(ctx, file, alignedOffset, CACHE_FLAG_DIRTY);
+    if (entry != NULL && !fullBlock)
+    {
+        ctx->result.readOps++;
+        ctx->result.readBytes += file->blockSize;
+    }
+}
+
+static void writeSimFile(SimContext* ctx, SimFile* file, off_t offset, size_t count)
+{
+    off_t blockSize = (off_t)file->blockSize;
+    off_t end = offset + (off_t)count;
+
+    for (off_t pos = offset; pos < end;)
+    {
+        off_t next = MIN(ROUND_DOWN_TO_BLOCK(pos, blockSize) + blockSize, end);
+        writeSimBlock(ctx, file, pos, (size_t)(next - pos));
+        pos = next;
+    }
+    if (file->ra != NULL)
+    {
+        noteOriginExtended(file->ra, end);
+    }
+}
+
+// 记录开始前已经打开、但没有 OPEN 记录的 fd（例如开始记录时 fd 表尚未建立）按默认参数补建
+static SimFile* getSimFile(SimContext* ctx, int fd)
+{
+    if (ctx->files[fd] == NULL)
+    {
+        size_t blockSize = (ctx->config->blockSize != 0) ? ctx->config->blockSize : SIM_DEFAULT_BLOCK_SIZE;
+        return createSimFile(ctx, fd, blockSize, ctx->trace->extent[fd]);
+    }
+    return ctx->files[fd];
+}
+
+static int openSimFile(SimContext* ctx, const CacheTraceRecord* record)
+{
+    size_t blockSize = (ctx->config->blockSize != 0) ? ctx->config->blockSize : record->length;
+    off_t originSize = (record->offset != 0) ? (off_t)record->offset : ctx->trace->extent[record->fd];
+
+    if (blockSize == 0 || (blockSize & (blockSize - 1)) != 0)
+    {
+        blockSize = SIM_DEFAULT_BLOCK_SIZE;
+    }
+    closeSimFile(ctx, record->fd);
+    return (createSimFile(ctx, record->fd, blockSize, originSize) != NULL) ? 0 : -1;
+}
+
+static int runSimulation(const SimConfig* config, const SimTrace* trace, int policy, size_t capacity, SimResult* result)
+{
+    SimContext* ctx = (SimContext*)calloc(1, sizeof(SimContext));
+    if (ctx == NULL)
+    {
+        perror("Failed to allocate simulation state");
+        return -1;
+    }
+    ctx->config = config;
+    ctx->trace = trace;
+    ctx->policy = policy;
+    ctx->capacity = capacity;
+
+    int ret = 0;
+    for (size_t i = 0; i < trace->count && ret == 0; i++)
+    {
+        const CacheTraceRecord* record = &(trace->records[i]);
+        SimFile* file = NULL;
+        switch (record->op)
+        {
+        case CACHE_TRACE_OPEN:
+            ret = openSimFile(ctx, record);
+            break;
+        case CACHE_TRACE_CLOSE:
+            closeSimFile(ctx, record->fd);
+            break;
+        case CACHE_TRACE_READ:
+        case CACHE_TRACE_WRITE:
+            if (record->length == 0)
+            {
+                break;
+            }
+            if ((file = getSimFile(ctx, record->fd)) == NULL)
+            {
+                ret = -1;
+                break;
+            }
+            if (record->op == CACHE_TRACE_READ)
+            {
+                readSimFile(ctx, file, (off_t)record->offset, record->length);
+            }
+            else
+            {
+                writeSimFile(ctx, file, (off_t)record->offset, record->length);
+            }
+            break;
+        default:
+            break;
+        }
+    }
+
+    // 记录结束时仍打开的 fd 按关闭处理，剩余脏块计入写回量
+    while (ctx->openCount > 0)
+    {
+        closeSimFile(ctx, ctx->openFiles[0]->fd);
+    }
+    *result = ctx->result;
+    free(ctx);
+    return ret;
+}
+
+// 排序用的键：时间相同的记录保持文件中的先后顺序，同一线程的记录在文件中是按顺序写入的
+typedef struct SimSortKey
+{
+    uint64_t timeNs;
+    size_t position;
+} SimSortKey;
+
+static int compareSortKey(const void* a, const void* b)
+{
+    const SimSortKey* left = (const SimSortKey*)a;
+    const SimSortKey* right = (const SimSortKey*)b;
+    if (left->timeNs != right->timeNs)
+    {
+        return (left->timeNs > right->timeNs) - (left->timeNs < right->timeNs);
+    }
+    return (left->position > right->position) - (left->position < right->position);
+}
+
+static int sortTrace(SimTrace* trace)
+{
+    SimSortKey* keys = (SimSortKey*)malloc(MAX(trace->count, (size_t)1) * sizeof(SimSortKey));
+    CacheTraceRecord* sorted = (CacheTraceRecord*)malloc(MAX(trace->count, (size_t)1) * sizeof(CacheTraceRecord));
+    if (keys == NULL || sorted == NULL)
+    {
+        perror("Failed to allocate trace");
+        free(keys);
+        free(sorted);
+        return -1;
+    }
+
+    for (size_t i = 0; i < trace->count; i++)
+    {
+        keys[i].timeNs = trace->records[i].timeNs;
+        keys[i].position = i;
+    }
+    qsort(keys, trace->count, sizeof(SimSortKey), compareSortKey);
+    for (size_t i = 0; i < trace->count; i++)
+    {
+        sorted[i] = trace->records[keys[i].position];
+    }
+
+    free(keys);
+    free(trace->records);
+    trace->records = sorted;
+    return 0;
+}
+
+static int loadTrace(const char* path, SimTrace* trace)
+{
+    FILE* fp = fopen(path, "rb");
+    if (fp == NULL)
+    {
+        fprintf(stderr, "Error: Failed to open trace %s: %s\n", path, strerror(errno));
+        return -1;
+    }
+
+    CacheTraceHeader header;
+    struct stat st;
+    if (fread(&header, sizeof(header), 1, fp) != 1 || memcmp(header.magic, CACHE_TRACE_MAGIC, sizeof(header.magic)) != 0 ||
+        header.version != CACHE_TRACE_VERSION || header.recordSize != sizeof(CacheTraceRecord) ||
+        fstat(fileno(fp), &st) < 0)
+    {
+        fprintf(stderr, "Error: %s is not a version %d cache trace\n", path, CACHE_TRACE_VERSION);
+        fclose(fp);
+        return -1;
+    }
+
+    size_t count = ((size_t)st.st_size - sizeof(header)) / sizeof(CacheTraceRecord);
+    trace->records = (CacheTraceRecord*)malloc(MAX(count, (size_t)1) * sizeof(CacheTraceRecord));
+    trace->extent = (off_t*)calloc(SIM_MAX_FDS, sizeof(off_t));
+    if (trace->records == NULL || trace->extent == NULL)
+    {
+        perror("Failed to allocate trace");
+        fclose(fp);
+        return -1;
+    }
+    trace->count = fread(trace->records, sizeof(CacheTraceRecord), count, fp);
+    fclose(fp);
+
+    if (sortTrace(trace) < 0)
+    {
+        return -1;
+    }
+
+    for (size_t i = 0; i < trace->count; i++)
+    {
+        const CacheTraceRecord* record = &(trace->records[i]);
+        off_t end = (off_t)(record->offset + record->length);
+        if ((record->op == CACHE_TRACE_READ || record->op == CACHE_TRACE_WRITE) && end > trace->extent[record->fd])
+        {
+            trace->extent[record->fd] = end;
+        }
+    }
+    return 0;
+}
+
+static int parseSize(const char* text, size_t* value)
+{
+    char* end = NULL;
+    double number = strtod(text, &end);
+    if (end == text || number < 0)
+    {
+        return -1;
+    }
+
+    switch (*end)
+    {
+    case 'k': case 'K': number *= 1024.0; end++; break;
+    case 'm': case 'M': number *= 1024.0 * 1024.0; end++; break;
+    case 'g': case 'G': number *= 1024.0 * 1024.0 * 1024.0; end++; break;
+    default: break;
+    }
+    if (*end != '\0')
+    {
+        return -1;
+    }
+    *value = (size_t)number;
+    return 0;
+}
+
+static int parseName(const char* text, const char* const* names, int count)
+{
+    for (int i = 0; i < count; i++)
+    {
+        if (strcmp(text, names[i]) == 0)
+        {
+            return i;
+        }
+    }
+    return -1;
+}
+
+static int parseSizeList(char* text, SimConfig* config)
+{
+    config->sizeCount = 0;
+    for (char* item = strtok(text, ","); item != NULL; item = strtok(NULL, ","))
+    {
+        size_t size = 0;
+        if (config->sizeCount == SIM_MAX_SIZES || parseSize(item, &size) < 0 || size == 0)
+        {
+            return -1;
+        }
+        config->sizes[config->sizeCount++] = size;
+    }
+    return (config->sizeCount > 0) ? 0 : -1;
+}
+
+static int parsePolicyList(char* text, SimConfig* config, const char* const* names)
+{
+    config->policyCount = 0;
+    if (strcmp(text, "all") == 0)
+    {
+        for (int i = 0; i < CACHE_POLICY_COUNT; i++)
+        {
+            config->policies[config->policyCount++] = i;
+        }
+        return 0;
+    }
+    for (char* item = strtok(text, ","); item != NULL; item = strtok(NULL, ","))
+    {
+        int policy = parseName(item, names, CACHE_POLICY_COUNT);
+        if (policy < 0 || config->policyCount == CACHE_POLICY_COUNT)
+        {
+            return -1;
+        }
+        config->policies[config->policyCount++] = policy;
+    }
+    return (config->policyCount > 0) ? 0 : -1;
+}
+
+static void formatSize(size_t bytes, char* text, size_t length)
+{
+    if (bytes >= (1UL << 30) && bytes % (1UL << 30) == 0)
+    {
+        snprintf(text, length, "%zuG", bytes >> 30);
+    }
+    else if (bytes >= (1UL << 20) && bytes % (1UL << 20) == 0)
+    {
+        snprintf(text, length, "%zuM", bytes >> 20);
+    }
+    else
+    {
+        snprintf(text, length, "%zuK", bytes >> 10);
+    }
+}
+
+static void printTraceSummary(const char* path, const SimTrace* trace)
+{
+    unsigned long long counts[4] = { 0, 0, 0, 0 };
+    unsigned long long bytes[2] = { 0, 0 };
+    for (size_t i = 0; i < trace->count; i++)
+    {
+        const CacheTraceRecord* record = &(trace->records[i]);
+        if (record->op < 4)
+        {
+            counts[record->op]++;
+        }
+        if (record->op == CACHE_TRACE_READ || record->op == CACHE_TRACE_WRITE)
+        {
+            bytes[record->op] += record->length;
+        }
+    }
+    double seconds = (trace->count > 0) ? (double)trace->records[trace->count - 1].timeNs / 1e9 : 0;
+    printf("trace %s: %zu records over %.2f s, %llu reads (%.1f MiB), %llu writes (%.1f MiB), %llu opens, %llu closes\n",
+           path, trace->count, seconds, counts[CACHE_TRACE_READ], (double)bytes[0] / (1 << 20),
+           counts[CACHE_TRACE_WRITE], (double)bytes[1] / (1 << 20), counts[CACHE_TRACE_OPEN], counts[CACHE_TRACE_CLOSE]);
+}
+
+static void usage(const char* program)
+{
+    fprintf(stderr,
+            "Usage: %s --trace PATH [options]\n"
+            "  --sizes LIST           comma separated cache sizes (default 16M,32M,64M,128M,256M,512M,1G)\n"
+            "  --policy LIST          comma separated lru | arc | 2q | s3fifo | clock, or all (default all)\n"
+            "  --block-size BYTES     override the block size recorded at open\n"
+            "  --write-policy NAME    back | through | around (default back)\n"
+            "  --write-miss NAME      allocate | no-allocate (default allocate)\n"
+            "  --readahead BYTES      readahead window, 0 to disable (default 2M)\n"
+            "  --shards N             shards per fd (default %d)\n"
+            "  --max-io BYTES         largest merged read or write back (default 4M)\n"
+            "The whole cache size is one budget shared by all fds, as with the process-wide limit.\n"
+            "Device reads and writes count merged I/Os; write-back counts dirty blocks written on\n"
+            "eviction and at close, including fds still open at the end of the trace.\n",
+            program, CACHE_DEFAULT_SHARD_COUNT);
+}
+
+int main(int argc, char** argv)
+{
+    static const char* const policyNames[] = { "lru", "arc", "2q", "s3fifo", "clock" };
+    static const char* const writePolicyNames[] = { "back", "through", "around" };
+    static const char* const writeMissNames[] = { "allocate", "no-allocate" };
+    static const struct option longOptions[] =
+    {
+        { "trace", required_argument, NULL, 't' },
+        { "sizes", required_argument, NULL, 's' },
+        { "policy", required_argument, NULL, 'P' },
+        { "block-size", required_argument, NULL, 'B' },
+        { "write-policy", required_argument, NULL, 'Y' },
+        { "write-miss", required_argument, NULL, 'W' },
+        { "readahead", required_argument, NULL, 'R' },
+        { "shards", required_argument, NULL, 'C' },
+        { "max-io", required_argument, NULL, 'I' },
+        { "help", no_argument, NULL, 'h' },
+        { NULL, 0, NULL, 0 }
+    };
+    static char defaultSizes[] = "16M,32M,64M,128M,256M,512M,1G";
+
+    SimConfig config;
+    memset(&config, 0, sizeof(config));
+    config.writePolicy = CACHE_WRITE_BACK;
+    config.writeMissPolicy = CACHE_WRITE_ALLOCATE;
+    config.readaheadBytes = READAHEAD_DEFAULT_MAX_WINDOW;
+    config.shardCount = CACHE_DEFAULT_SHARD_COUNT;
+    config.maxIOBytes = CACHE_MAX_IO_BYTES;
+    parseSizeList(defaultSizes, &config);
+    for (int i = 0; i < CACHE_POLICY_COUNT; i++)
+    {
+        config.policies[config.policyCount++] = i;
+    }
+
+    const char* path = NULL;
+    int option;
+    int bad = 0;
+    while ((option = getopt_long(argc, argv, "", longOptions, NULL)) != -1)
+    {
+        size_t size = 0;
+        switch (option)
+        {
+        case 't': path = optarg; break;
+        case 's': bad |= parseSizeList(optarg, &config); break;
+        case 'P': bad |= parsePolicyList(optarg, &config, policyNames); break;
+        case 'B': bad |= parseSize(optarg, &(config.blockSize)); break;
+        case 'Y': bad |= (config.writePolicy = parseName(optarg, writePolicyNames, 3)) < 0; break;
+        case 'W': bad |= (config.writeMissPolicy = parseName(optarg, writeMissNames, 2)) < 0; break;
+        case 'R':
+            bad |= parseSize(optarg, &size);
+            config.readaheadBytes = (size == 0) ? CACHE_READAHEAD_DISABLED : size;
+            break;
+        case 'C': config.shardCount = (unsigned int)atoi(optarg); break;
+        case 'I': bad |= parseSize(optarg, &(config.maxIOBytes)); break;
+        default: bad = 1; break;
+        }
+    }
+
+    if (bad || path == NULL || config.shardCount == 0 || (config.shardCount & (config.shardCount - 1)) != 0 ||
+        config.shardCount > CACHE_MAX_SHARD_COUNT || (config.blockSize & (config.blockSize - 1)) != 0 ||
+        config.maxIOBytes == 0)
+    {
+        usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    SimTrace trace;
+    memset(&trace, 0, sizeof(trace));
+    if (loadTrace(path, &trace) < 0)
+    {
+        return EXIT_FAILURE;
+    }
+    printTraceSummary(path, &trace);
+
+    printf("%-7s %6s %7s %9s %9s %9s %9s %9s %9s %9s\n", "policy", "size", "hit%", "ra-hits", "rd-ops", "rd-MiB",
+           "wr-ops", "wr-MiB", "wb-MiB", "dirty-ev");
+    for (int p = 0; p < config.policyCount; p++)
+    {
+        for (int s = 0; s < config.sizeCount; s++)
+        {
+            SimResult result;
+            char sizeText[32];
+            if (runSimulation(&config, &trace, config.policies[p], config.sizes[s], &result) < 0)
+            {
+                return EXIT_FAILURE;
+            }
+
+            unsigned long long lookups = result.hits + result.misses;
+            formatSize(config.sizes[s], sizeText, sizeof(sizeText));
+            printf("%-7s %6s %6.2f%% %9llu %9llu %9.1f %9llu %9.1f %9.1f %9llu\n", policyNames[config.policies[p]],
+                   sizeText, (lookups > 0) ? 100.0 * (double)result.hits / (double)lookups : 0.0,
+                   result.readaheadHits, result.readOps, (double)result.readBytes / (1 << 20), result.writeOps,
+                   (double)result.writeBytes / (1 << 20), (double)result.writeBackBytes / (1 << 20),
+                   result.dirtyEvictions);
+        }
+    }
+
+    free(trace.records);
+    free(trace.extent);
+    return EXIT_SUCCESS;
+}
@@ -2,326 +2,962 @@
 #include <unistd.h>
 #include <stdlib.h>
 #include <string.h>
+#include <limits.h>
+#include <sys/uio.h>
 
 #include "singleCacheHandler.h"
+#include "cacheIOHandler.h"
 #include "hashTable.h"
+#include "ioEngine.h"
 
 ssize_t writeBackCache(int fd, cache* cache) 
 {
     HashTableFdNode* hashTableFdNode = findFdNode(fd);
+    CacheSet* set = hashTableFdNode->set;
+    size_t blockSize = set->blockSize;
+
     if(hashTableFdNode->cacheType == CACHE_TYPE_HOST)
     {
-        printf("Writebake host cache is Offset: %zu\n", cache->offset);   
-        return pwrite(fd, cache->data, CACHE_SIZE, cache->offset);
+        ssize_t written = pwrite(fd, cache->data, blockSize, cache->offset);
+        if (written > 0)
+        {
+            CACHE_STAT_ADD(set, cache->offset, deviceWriteBytes, (unsigned long long)written);
+            noteDeviceWrite(set, cache->offset, (size_t)written);
+        }
+        return written;
     }
-    else
+
+    // 设备模式的块数据都在内存层，直接写回后端设备；NVMe 层盘上还记着该块的旧槽时先提交
+    if ((hashTableFdNode->tier != NULL && commitDeviceTierBlock(hashTableFdNode->tier, cache->offset) < 0) ||
+        writeBackingBlock(fd, &(hashTableFdNode->ioLock), cache->offset, cache->data, blockSize) < 0)
     {
-        printf("Writebake dev cache is Offset: %zu\n", cache->offset); 
+        return -1;
+    }
+    CACHE_STAT_ADD(set, cache->offset, deviceWriteBytes, blockSize);
+    return (ssize_t)blockSize;
+}
 
-        unsigned char* tempBuffer = (unsigned char*)malloc(CACHE_SIZE);
-        if (tempBuffer == NULL) 
+static int compareCacheOffset(const void* a, const void* b)
+{
+    off_t left = (*(cache* const*)a)->offset;
+    off_t right = (*(cache* const*)b)->offset;
+    return (left > right) - (left < right);
+}
+
+// 把按偏移排好序的脏块中相邻的合并成一次写，各段作为一批交给 I/O 引擎，written[i] 记录每块是否写成功；
+// 不修改块的标记，因此可以在不持有分片锁的情况下调用
+static size_t writeBackSortedRuns(int fd, CacheSet* set, cache** dirty, size_t count, unsigned char* written)
+{
+    size_t maxRunBlocks = MIN(MAX(set->maxIOBytes / set->blockSize, (size_t)1), (size_t)CACHE_MAX_IOV);
+    struct iovec* iov = (struct iovec*)malloc(count * sizeof(struct iovec));
+    IoRequest* requests = (IoRequest*)malloc(count * sizeof(IoRequest));
+    if (iov == NULL || requests == NULL)
+    {
+        perror("Failed to allocate write back requests");
+        free(iov);
+        free(requests);
+        return 0;
+    }
+
+    size_t i = 0;
+    int requestCount = 0;
+    while (i < count)
+    {
+        size_t run = 1;
+        while (i + run < count && run < maxRunBlocks &&
+               dirty[i + run]->offset == dirty[i]->offset + (off_t)(run * set->blockSize))
         {
-            perror("malloc failed");
-            return;
+            run++;
         }
-    
-        int readNumb = pread(fd, tempBuffer, CACHE_SIZE, cache->offset);
 
-        if (readNumb == -1)
+        for (size_t k = 0; k < run; k++)
         {
-            fprintf(stderr, "Error reading data from file descriptor %d at offset %lld\n", fd, (long long)cache->offset);
-            return;
+            iov[i + k].iov_base = dirty[i + k]->data;
+            iov[i + k].iov_len = set->blockSize;
         }
 
-        int ret = lseek(fd, cache->offset, SEEK_SET);
-        if (ret < 0) 
+        IoRequest* request = &requests[requestCount++];
+        initIoRequest(request, fd, 1, &iov[i], (int)run, dirty[i]->offset);
+        if (run == 1)
         {
-            perror("lseek");
-            return;
-        } 
-    
-        ret = ioctl(fd, IOCTL_READ_BLOCK, tempBuffer);
-        if (ret < 0) 
+            request->bufferSlot = dirty[i]->bufferSlot;
+        }
+        i += run;
+    }
+
+    submitIoBatch(requests, requestCount);
+
+    size_t writtenBlocks = 0;
+    for (int r = 0; r < requestCount; r++)
+    {
+        size_t first = (size_t)(requests[r].iov - iov);
+        size_t run = (size_t)requests[r].iovcnt;
+
+        if (requests[r].result != (ssize_t)(run * set->blockSize))
         {
-            perror("ioctl read second device");
-            return;
+            fprintf(stderr, "Write back failed for %zu blocks at offset %ld\n", run, (long)requests[r].offset);
+            continue;
         }
+        memset(written + first, 1, run);
+        writtenBlocks += run;
+        CACHE_STAT_ADD(set, requests[r].offset, deviceWriteBytes, run * set->blockSize);
+        noteDeviceWrite(set, requests[r].offset, run * set->blockSize);
     }
 
+    free(iov);
+    free(requests);
+    return writtenBlocks;
 }
 
-void traversalWriteBackCache(AVLTreeNode* root, int fd)
+// 调用者持有 fdTableLock 写锁，不会与其他线程并发访问该集合
+void traversalWriteBackCache(CacheSet* set, int fd)
 {
-    if (root != NULL) 
+    HashTableFdNode* hashTableFdNode = findFdNode(fd);
+    size_t resident = set->residentBytes / set->blockSize;
+
+    if (resident == 0)
     {
-        traversalWriteBackCache(root->left, fd);
-        if(((cache*)(root->data))->dirty)
+        return;
+    }
+
+    cache** dirty = (cache**)malloc(resident * sizeof(cache*));
+    unsigned char* written = (unsigned char*)calloc(resident, 1);
+    if (dirty == NULL || written == NULL)
+    {
+        perror("Failed to allocate write back list");
+        free(dirty);
+        free(written);
+        return;
+    }
+
+    size_t count = 0;
+    for (unsigned int n = 0; n < set->shardCount; n++)
+    {
+        ReplacementState* policy = &(set->shards[n].policy);
+        for (cache* node = replacementNext(policy, NULL); node != NULL; node = replacementNext(policy, node))
         {
-            size_t writeNumb = writeBackCache(fd ,(cache*)(root->data));
-            if (writeNumb == -1)
+            if(IS_CACHE_DIRTY(node))
             {
-                fprintf(stderr, "Write back failed for node with offset %ld\n", (long)((cache*)(root->data))->offset);
+                dirty[count++] = node;
             }
-            ((cache*)(root->data))->dirty = 0;
         }
-        traversalWriteBackCache(root->right, fd);
     }
-}
 
+    if (count > 0)
+    {
+        qsort(dirty, count, sizeof(cache*), compareCacheOffset);
 
-void checkCacheOverflow(int fd)
-{
-    HashTableFdNode* hashTableFdNode = findFdNode(fd);
-    AVLTreeNode** root = &(hashTableFdNode->root);
-    LRUHash* hostHash = hashTableFdNode->Hash;
+        size_t writtenBlocks = 0;
+        if (hashTableFdNode->cacheType == CACHE_TYPE_HOST)
+        {
+            writtenBlocks = writeBackSortedRuns(fd, set, dirty, count, written);
+        }
+        else
+        {
+            for (size_t i = 0; i < count; i++)
+            {
+                if (writeBackCache(fd, dirty[i]) < 0)
+                {
+                    fprintf(stderr, "Write back failed for node with offset %ld\n", (long)dirty[i]->offset);
+                    continue;
+                }
+                written[i] = 1;
+                writtenBlocks++;
+            }
+        }
 
-    while(hostHash->size > MAX_CACHE_ENTRIES)
-    {
-        traversalWriteBackCache(*root ,fd);
-        deleteTailCache(root, hostHash);
+        for (size_t i = 0; i < count; i++)
+        {
+            if (written[i])
+            {
+                clearCacheDirty(set, dirty[i]);
+            }
+        }
+        CACHE_STAT_ADD(set, dirty[0]->offset, writeBackBatches, 1);
+        CACHE_STAT_ADD(set, dirty[0]->offset, writeBackBlocks, writtenBlocks);
     }
-}
 
-void readWithHostCache(LRUHash* Hash, cache* cache, void* buf, off_t offsetInCache, size_t count)
-{
-    memcpy(buf, (cache->data) + offsetInCache, count);
-    moveNodeToHeadByKey(Hash, (long)(cache->offset/CACHE_SIZE));
+    free(dirty);
+    free(written);
 }
 
-void readWithoutHostCache(int fd, void* buf, off_t alignedOffset)
+// 调用者持有 fdTableLock 读锁。按各分片的淘汰顺序收集最多 maxBytes（0 表示全部）的脏块写回；
+// 写回期间不持分片锁，块带 CACHE_FLAG_WRITEBACK 标记以免被淘汰
+size_t flushCacheSet(HashTableFdNode* hashTableFdNode, size_t maxBytes)
 {
-    HashTableFdNode* hashTableFdNode = findFdNode(fd);
-    AVLTreeNode** root = &(hashTableFdNode->root);
-    LRUHash* Hash = hashTableFdNode->Hash;
+    CacheSet* set = hashTableFdNode->set;
+    int fd = hashTableFdNode->fd;
+    unsigned long long startMs = getMonotonicMs();
+    size_t limit = ATOMIC_LOAD(&(set->dirtyBytes)) / set->blockSize;
+
+    if (maxBytes != 0)
+    {
+        limit = MIN(limit, MAX(maxBytes / set->blockSize, (size_t)1));
+    }
+    if (limit == 0)
+    {
+        return 0;
+    }
 
-    int readNumb = pread(fd, buf, CACHE_SIZE, alignedOffset);
+    cache** dirty = (cache**)malloc(limit * sizeof(cache*));
+    unsigned char* written = (unsigned char*)calloc(limit, 1);
+    if (dirty == NULL || written == NULL)
+    {
+        perror("Failed to allocate flush list");
+        free(dirty);
+        free(written);
+        return 0;
+    }
 
-    if (readNumb == -1)
+    // 限量回写时每轮每个分片最多取 quota 块，避免总是先写回编号小的分片
+    size_t quota = (maxBytes != 0) ? (limit + set->shardCount - 1) / set->shardCount : limit;
+    size_t count = 0;
+    size_t lastCount;
+    do
     {
-        fprintf(stderr, "Error reading data from file descriptor %d at offset %lld\n", fd, (long long)alignedOffset);
-        return;
+        lastCount = count;
+        for (unsigned int n = 0; n < set->shardCount && count < limit; n++)
+        {
+            CacheShard* shard = &(set->shards[n]);
+            size_t taken = 0;
+
+            pthread_rwlock_wrlock(&(shard->lock));
+            ReplacementState* policy = &(shard->policy);
+            for (cache* node = replacementNext(policy, NULL); node != NULL && taken < quota && count < limit;
+                 node = replacementNext(policy, node))
+            {
+                // 先清脏再写：写回期间再被修改的块会重新变脏，留给下一轮
+                if (IS_CACHE_DIRTY(node) && !(node->flags & CACHE_FLAG_WRITEBACK))
+                {
+                    clearCacheDirty(set, node);
+                    node->flags |= CACHE_FLAG_WRITEBACK;
+                    dirty[count++] = node;
+                    taken++;
+                }
+            }
+            pthread_rwlock_unlock(&(shard->lock));
+        }
+    } while (count < limit && count > lastCount);
+
+    // 整个 fd 都已收集时，剩下的脏数据都比本轮开始时新
+    if (maxBytes == 0 && ATOMIC_LOAD(&(set->dirtyBytes)) > 0)
+    {
+        ATOMIC_STORE(&(set->dirtySince), startMs);
     }
 
-    checkCacheOverflow(fd);
-    createCache(root, Hash, alignedOffset, buf);
+    size_t writtenBlocks = 0;
+    if (hashTableFdNode->cacheType != CACHE_TYPE_HOST)
+    {
+        for (size_t i = 0; i < count; i++)
+        {
+            if (writeBackCache(fd, dirty[i]) >= 0)
+            {
+                written[i] = 1;
+                writtenBlocks++;
+            }
+        }
+    }
+    else if (count > 0)
+    {
+        qsort(dirty, count, sizeof(cache*), compareCacheOffset);
+        writtenBlocks = writeBackSortedRuns(fd, set, dirty, count, written);
+    }
+
+    if (count > 0)
+    {
+        CACHE_STAT_ADD(set, dirty[0]->offset, writeBackBatches, 1);
+        CACHE_STAT_ADD(set, dirty[0]->offset, writeBackBlocks, writtenBlocks);
+    }
+
+    for (size_t i = 0; i < count; i++)
+    {
+        CacheShard* shard = lockCacheShard(set, dirty[i]->offset);
+        dirty[i]->flags &= ~CACHE_FLAG_WRITEBACK;
+        if (!written[i])
+        {
+            markCacheDirty(set, dirty[i]);
+        }
+        unlockCacheShard(shard);
+    }
+
+    free(dirty);
+    free(written);
+    return writtenBlocks;
 }
 
 
-void writeHostWithCache(LRUHash* Hash, cache* cache, const void* buf, off_t offsetInCache, size_t count)
+// 从轮转的起点开始，在最多 CACHE_VICTIM_SAMPLE 个非空分片中选下一个待淘汰块最久未被访问的分片，
+// oldest 返回该块的访问时间。只读各分片解锁前留下的 tailAtime，不取分片锁；它可能稍旧，
+// 真正的淘汰对象仍由 evictTailCache 在写锁下选出
+static CacheShard* selectVictimShard(CacheSet* set, unsigned long* oldest)
 {
-    memcpy((cache->data) + offsetInCache, buf, count);
-    cache->dirty = 1;
-    moveNodeToHeadByKey(Hash, (long)(cache->offset/CACHE_SIZE));
+    CacheShard* victim = NULL;
+    unsigned int start = ATOMIC_ADD(&(set->victimCursor), 1);
+    unsigned int sampled = 0;
+
+    for (unsigned int i = 0; i < set->shardCount && sampled < CACHE_VICTIM_SAMPLE; i++)
+    {
+        CacheShard* shard = &(set->shards[(start + i) & (set->shardCount - 1)]);
+        unsigned long atime = ATOMIC_LOAD(&(shard->tailAtime));
+        if (atime == CACHE_NO_VICTIM)
+        {
+            continue;
+        }
+        sampled++;
+        if (victim == NULL || atime < *oldest)
+        {
+            victim = shard;
+            *oldest = atime;
+        }
+    }
+    return victim;
 }
 
-void writeHostWithoutCache(int fd, const void* buf, off_t offset, size_t count)
+// 在所有 fd 的抽样分片中选出下一个待淘汰块最久未被访问的那个
+static HashTableFdNode* selectVictimFdNode(CacheShard** victimShard)
 {
-    HashTableFdNode* hashTableFdNode = findFdNode(fd);
-    AVLTreeNode** root = &(hashTableFdNode->root);
-    LRUHash* Hash = hashTableFdNode->Hash;
+    HashTableFdNode* victim = NULL;
+    unsigned long oldest = 0;
 
-    int writeNumb = pwrite(fd, buf, count, offset);
+    for (int i = 0; i < table->size; i++)
+    {
+        for (HashTableFdNode* node = table->buckets[i]; node != NULL; node = node->next)
+        {
+            unsigned long atime = 0;
+            CacheShard* shard = (node->set != NULL) ? selectVictimShard(node->set, &atime) : NULL;
+            if (shard != NULL && (victim == NULL || atime < oldest))
+            {
+                victim = node;
+                *victimShard = shard;
+                oldest = atime;
+            }
+        }
+    }
+    return victim;
+}
+
+// 由替换策略选出淘汰对象；若它是脏块，再沿淘汰顺序最多查看 CACHE_CLEAN_SCAN_DEPTH 个块，
+// 优先淘汰干净块，找不到时才写回并淘汰策略选出的脏块。正在后台写回或被引用的块不淘汰
+static int evictTailCache(HashTableFdNode* hashTableFdNode, CacheShard* shard)
+{
+    CacheSet* set = hashTableFdNode->set;
 
-    if (writeNumb == -1)
+    pthread_rwlock_wrlock(&(shard->lock));
+    cache* victim = replacementVictim(&(shard->policy));
+    if (victim == NULL)
     {
-        fprintf(stderr, "Error reading data from file descriptor %d at offset %lld\n", fd, (long long)offset);
-        return;
+        unlockCacheShard(shard);
+        return -1;
+    }
+
+    cache* candidate = victim;
+    for (int i = 0; i < CACHE_CLEAN_SCAN_DEPTH && candidate != NULL && IS_CACHE_DIRTY(victim); i++)
+    {
+        if (!IS_CACHE_DIRTY(candidate) && !IS_CACHE_BUSY(candidate))
+        {
+            victim = candidate;
+        }
+        candidate = replacementNext(&(shard->policy), candidate);
     }
 
-    off_t alignedOffset = ROUND_DOWN_TO_4096(offset);
+    // 设备模式下降级到 NVMe 层，脏块在该层保持为脏；降级失败时按原方式写回后丢弃
+    int wasDirty = IS_CACHE_DIRTY(victim);
+    if (hashTableFdNode->tier != NULL &&
+        demoteDeviceTierBlock(hashTableFdNode->tier, victim->offset, victim->data, IS_CACHE_DIRTY(victim)) == 0)
+    {
+        clearCacheDirty(set, victim);
+    }
+    else if (IS_CACHE_DIRTY(victim))
+    {
+        if (writeBackCache(hashTableFdNode->fd, victim) < 0)
+        {
+            fprintf(stderr, "Write back failed for node with offset %ld, keep it cached\n", (long)victim->offset);
+            replacementHit(&(shard->policy), victim);
+            unlockCacheShard(shard);
+            return -1;
+        }
+        clearCacheDirty(set, victim);
+    }
 
-    void* readBuf = (void*)malloc(CACHE_SIZE);
-    if (readBuf == NULL) 
+    if ((victim->flags & CACHE_FLAG_READAHEAD) && hashTableFdNode->ra != NULL)
     {
-        perror("Failed to allocate memory for cache data");
-        free(readBuf); 
-        return; 
+        noteReadaheadWasted(hashTableFdNode->ra);
     }
 
-    memcpy(readBuf, buf, CACHE_SIZE);
+    ATOMIC_ADD(wasDirty ? &(shard->stats.dirtyEvictions) : &(shard->stats.cleanEvictions), 1);
+    evictCache(set, victim);
+    unlockCacheShard(shard);
+    return 0;
+}
+
+// 调用者持有 fdTableLock 读锁且不持有任何分片锁
+void trimCacheToBudget(int fd, size_t incomingBytes)
+{
+    if (fd >= 0)
+    {
+        HashTableFdNode* hashTableFdNode = findFdNode(fd);
+        CacheSet* set = hashTableFdNode->set;
+        size_t capacity = ATOMIC_LOAD(&(set->capacityBytes));
+
+        while (capacity != 0 && ATOMIC_LOAD(&(set->residentBytes)) + incomingBytes > capacity)
+        {
+            unsigned long atime = 0;
+            CacheShard* shard = selectVictimShard(set, &atime);
+            if (shard == NULL || evictTailCache(hashTableFdNode, shard) < 0)
+            {
+                break;
+            }
+        }
+    }
+
+    while (ATOMIC_LOAD(&(cacheBudget.residentBytes)) + incomingBytes > ATOMIC_LOAD(&(cacheBudget.limitBytes)))
+    {
+        CacheShard* shard = NULL;
+        HashTableFdNode* victim = selectVictimFdNode(&shard);
+        if (victim == NULL || evictTailCache(victim, shard) < 0)
+        {
+            break;
+        }
+    }
+}
 
-    readWithoutHostCache(fd, readBuf, alignedOffset);
+// 不淘汰任何块时集合与全局预算还能容纳的字节数
+size_t freeCacheBudget(CacheSet* set)
+{
+    size_t room = SIZE_MAX;
+    size_t capacity = ATOMIC_LOAD(&(set->capacityBytes));
+    size_t resident = ATOMIC_LOAD(&(set->residentBytes));
+    if (capacity != 0)
+    {
+        room = (resident < capacity) ? capacity - resident : 0;
+    }
 
-    free(readBuf);
+    size_t limit = ATOMIC_LOAD(&(cacheBudget.limitBytes));
+    size_t total = ATOMIC_LOAD(&(cacheBudget.residentBytes));
+    return MIN(room, (total < limit) ? limit - total : 0);
 }
 
-void writeBackAndCleanUpCache(int fd)
+void checkCacheOverflow(int fd)
 {
     HashTableFdNode* hashTableFdNode = findFdNode(fd);
 
-    traversalWriteBackCache(hashTableFdNode->root ,fd);
-    cleanUpCache(hashTableFdNode->root, hashTableFdNode->Hash, hashTableFdNode->Hash);
+    trimCacheToBudget(fd, hashTableFdNode->set->blockSize);
 }
 
+// 调用者持有 cache 所在分片的锁，策略允许时读锁即可
+void readWithHostCache(CacheSet* set, cache* cache, void* buf, off_t offsetInCache, size_t count)
+{
+    memcpy(buf, (cache->data) + offsetInCache, count);
+    replacementHit(&(CACHE_SHARD_OF(set, cache->offset)->policy), cache);
+}
 
-void readDevWithCache(int fd, LRUHash* devHash, cache* cache, void* buf, off_t offsetInCache, size_t count)
+void readWithoutHostCache(int fd, void* buf, off_t alignedOffset)
 {
-    size_t cacheSize = CACHE_SIZE;
-    
-    // 使用 malloc 动态分配缓存缓冲区
-    unsigned char* tempBuffer = (unsigned char*)malloc(cacheSize);
-    if (tempBuffer == NULL) {
-        perror("malloc failed");
-        return;
-    }
+    HashTableFdNode* hashTableFdNode = findFdNode(fd);
+    CacheSet* set = hashTableFdNode->set;
 
-    ssize_t ret = pread(fd, tempBuffer, cacheSize, cache->offset);
-    if (ret < 0) 
+    int readNumb = pread(fd, buf, set->blockSize, alignedOffset);
+
+    if (readNumb == -1)
     {
-        perror("pread from blkcache");
-        free(tempBuffer);
+        fprintf(stderr, "Error reading data from file descriptor %d at offset %lld\n", fd, (long long)alignedOffset);
         return;
     }
 
-    size_t remainingBytes = count;
-    size_t offsetInTempBuffer = offsetInCache % cacheSize;
-    if (remainingBytes > cacheSize - offsetInTempBuffer) {
-        remainingBytes = cacheSize - offsetInTempBuffer;
+    checkCacheOverflow(fd);
+    CacheShard* shard = lockCacheShard(set, alignedOffset);
+    if (findCache(set, alignedOffset) == NULL)
+    {
+        createCache(set, alignedOffset, buf);
     }
+    unlockCacheShard(shard);
+}
 
-    memcpy(buf, tempBuffer + offsetInTempBuffer, remainingBytes);
+// 设备上 [offset, offset + length) 的数据刚被改写，在更新驻留块之前调用。此前发出的未命中读可能读到旧数据，
+// 这些块在读盘期间若被写回并淘汰，完成时按 writeEpoch 的变化丢弃，不能把旧数据装入缓存
+void noteDeviceWrite(CacheSet* set, off_t offset, size_t length)
+{
+    off_t first = ROUND_DOWN_TO_BLOCK(offset, set->blockSize);
+    off_t end = offset + (off_t)length;
+    unsigned int shards = 0;
+
+    for (off_t pos = first; pos < end && shards < set->shardCount; pos += (off_t)set->blockSize, shards++)
+    {
+        __atomic_add_fetch(&(CACHE_SHARD_OF(set, pos)->writeEpoch), 1, __ATOMIC_RELEASE);
+    }
+}
 
-    moveNodeToHeadByKey(devHash, (long)(cache->offset / CACHE_SIZE));
+// [offset, offset+length) 所在各分片 writeEpoch 之和，分片与 noteDeviceWrite 取法相同；
+// 前后两次取值不同说明期间有块被写入设备
+unsigned long sampleDeviceWriteEpoch(CacheSet* set, off_t offset, size_t length)
+{
+    off_t first = ROUND_DOWN_TO_BLOCK(offset, set->blockSize);
+    off_t end = offset + (off_t)length;
+    unsigned int shards = 0;
+    unsigned long sum = 0;
 
-    free(tempBuffer);
+    for (off_t pos = first; pos < end && shards < set->shardCount; pos += (off_t)set->blockSize, shards++)
+    {
+        sum += __atomic_load_n(&(CACHE_SHARD_OF(set, pos)->writeEpoch), __ATOMIC_ACQUIRE);
+    }
+    return sum;
 }
 
+// 单批未命中读入允许的最大块数，同时不超过该 fd 及全局的预算
+int maxMissRunBlocks(CacheSet* set)
+{
+    size_t limitBytes = MIN(set->maxIOBytes, ATOMIC_LOAD(&(cacheBudget.limitBytes)));
+    size_t capacity = ATOMIC_LOAD(&(set->capacityBytes));
+    if (capacity != 0)
+    {
+        limitBytes = MIN(limitBytes, capacity);
+    }
+
+    size_t blocks = MIN(limitBytes / set->blockSize, (size_t)CACHE_MAX_IOV);
+    return (blocks > 0) ? (int)blocks : 1;
+}
 
-void readWithoutDevCache(int fd, void* buf, off_t alignedOffset)
+// 从 alignedOffset 起的 blockCount 块中找出不在缓存里的连续段，为它们分配缓存块并组成一批读请求，
+// 每段连续块合并成一个请求。返回要读的块数，没有未命中块时返回 0，分配失败返回 -1；
+// covered 返回本次检查过的块数，受单批块数与段数限制，剩下的留给下一批。
+// flags 带 CACHE_MISS_NO_EVICT 时不为新块腾出空间，没有空余预算时 covered 为 0
+int prepareMissBatch(int fd, off_t alignedOffset, int blockCount, unsigned int flags, int* covered, MissBatch** batchOut)
 {
     HashTableFdNode* hashTableFdNode = findFdNode(fd);
-    AVLTreeNode** root = &(hashTableFdNode->root);
-    LRUHash* devHash = hashTableFdNode->Hash;
+    CacheSet* set = hashTableFdNode->set;
+    size_t blockSize = set->blockSize;
+    int maxBlocks = maxMissRunBlocks(set);
+    int noEvict = (flags & CACHE_MISS_NO_EVICT) != 0;
+    off_t runStart[CACHE_MAX_MISS_RUNS];
+    int runLength[CACHE_MAX_MISS_RUNS];
+    int runCount = 0;
+    int missing = 0;
+    int scanned = 0;
+
+    if (noEvict)
+    {
+        // 没有空余时一块也不读，covered 为 0 告诉调用者停下
+        size_t room = freeCacheBudget(set) / blockSize;
+        maxBlocks = (int)MIN((size_t)maxBlocks, room);
+        if (maxBlocks == 0)
+        {
+            *covered = 0;
+            return 0;
+        }
+    }
 
-    // int readNumb = pread(fd, buf, CACHE_SIZE, alignedOffset);
-    // if (readNumb == -1)
-    // {
-    //     fprintf(stderr, "Error reading data from file descriptor %d at offset %lld\n", fd, (long long)alignedOffset);
-    //     return;
-    // }
+    while (scanned < blockCount && missing < maxBlocks)
+    {
+        off_t pos = alignedOffset + (off_t)scanned * (off_t)blockSize;
+        if (!isCacheResident(set, pos))
+        {
+            if (runCount > 0 && runStart[runCount - 1] + (off_t)runLength[runCount - 1] * (off_t)blockSize == pos)
+            {
+                runLength[runCount - 1]++;
+            }
+            else if (runCount < CACHE_MAX_MISS_RUNS)
+            {
+                runStart[runCount] = pos;
+                runLength[runCount] = 1;
+                runCount++;
+            }
+            else
+            {
+                break;
+            }
+            missing++;
+        }
+        scanned++;
+    }
 
-    //TODO：将数据从块设备中读出
+    *covered = scanned;
+    if (missing == 0)
+    {
+        return 0;
+    }
 
-    int ret = lseek(fd, alignedOffset, SEEK_SET);
-    if (ret < 0) 
+    MissBatch* batch = (MissBatch*)malloc(sizeof(MissBatch) + (size_t)runCount * sizeof(IoRequest) +
+                                          (size_t)missing * (sizeof(struct iovec) + sizeof(cache*) + sizeof(unsigned long)));
+    if (batch == NULL)
     {
-        perror("lseek");
-        return;
-    } 
-    else 
+        perror("Failed to allocate miss batch");
+        return -1;
+    }
+    batch->fd = fd;
+    batch->flags = flags & ~CACHE_MISS_NO_EVICT;
+    batch->requests = (IoRequest*)(batch + 1);
+    batch->iov = (struct iovec*)(batch->requests + runCount);
+    batch->entries = (cache**)(batch->iov + missing);
+    batch->epochs = (unsigned long*)(batch->entries + missing);
+    batch->pinOut = NULL;
+    batch->blockCount = 0;
+    batch->requestCount = 0;
+
+    if (!noEvict)
+    {
+        trimCacheToBudget(fd, (size_t)missing * blockSize);
+    }
+    for (int r = 0; r < runCount; r++)
+    {
+        int first = batch->blockCount;
+        for (int k = 0; k < runLength[r]; k++)
+        {
+            cache* entry = allocCache(set, runStart[r] + (off_t)k * (off_t)blockSize);
+            if (entry == NULL)
+            {
+                break;
+            }
+            batch->entries[batch->blockCount] = entry;
+            batch->epochs[batch->blockCount] = __atomic_load_n(&(CACHE_SHARD_OF(set, entry->offset)->writeEpoch),
+                                                               __ATOMIC_ACQUIRE);
+            batch->iov[batch->blockCount].iov_base = entry->data;
+            batch->iov[batch->blockCount].iov_len = blockSize;
+            batch->blockCount++;
+        }
+
+        int length = batch->blockCount - first;
+        if (length > 0)
+        {
+            IoRequest* request = &(batch->requests[batch->requestCount++]);
+            initIoRequest(request, fd, 0, &(batch->iov[first]), length, runStart[r]);
+            if (length == 1)
+            {
+                request->bufferSlot = batch->entries[first]->bufferSlot;
+            }
+        }
+        if (length < runLength[r])
+        {
+            break;
+        }
+    }
+
+    if (batch->blockCount == 0)
     {
-        printf("File offset set to %ld\n", (long)alignedOffset);
+        free(batch);
+        return -1;
     }
+    *batchOut = batch;
+    return batch->blockCount;
+}
 
-    ret = ioctl(fd, IOCTL_READ_BLOCK, buf);
-    if (ret < 0) 
+// 一批读请求完成后把读到的块插入缓存并释放 batch，返回读入的块数，一块也没读到时返回 -1。
+// 调用者持有 fdTableLock 读锁
+int completeMissBatch(MissBatch* batch)
+{
+    CacheSet* set = findFdNode(batch->fd)->set;
+    size_t blockSize = set->blockSize;
+    int filled = 0;
+    int index = 0;
+
+    for (int r = 0; r < batch->requestCount; r++)
     {
-        perror("ioctl read second device");
-        return;
+        IoRequest* request = &(batch->requests[r]);
+        ssize_t readNumb = request->result;
+        if (readNumb < 0)
+        {
+            fprintf(stderr, "Error reading data from file descriptor %d at offset %lld\n", batch->fd, (long long)request->offset);
+        }
+        else
+        {
+            CACHE_STAT_ADD(set, request->offset, deviceReadBytes, (unsigned long long)readNumb);
+        }
+
+        for (int k = 0; k < request->iovcnt; k++, index++)
+        {
+            cache* entry = batch->entries[index];
+            if (readNumb < 0)
+            {
+                freeBlock(set->pool, entry);
+                continue;
+            }
+
+            size_t blockStart = (size_t)k * blockSize;
+            if ((size_t)readNumb < blockStart + blockSize)
+            {
+                size_t valid = ((size_t)readNumb > blockStart) ? (size_t)readNumb - blockStart : 0;
+                memset((char*)entry->data + valid, 0, blockSize - valid);
+            }
+
+            // 读盘期间其他线程可能已缓存了同一块，以已有的为准；该块期间被写入设备过时读到的可能是旧数据
+            CacheShard* shard = lockCacheShard(set, entry->offset);
+            cache* resident = findCache(set, entry->offset);
+            if (resident != NULL || __atomic_load_n(&(shard->writeEpoch), __ATOMIC_ACQUIRE) != batch->epochs[index])
+            {
+                freeBlock(set->pool, entry);
+            }
+            else
+            {
+                entry->flags |= batch->flags;
+                resident = (insertCache(set, entry) == 0) ? entry : NULL;
+            }
+            if (batch->pinOut != NULL && resident != NULL)
+            {
+                ATOMIC_ADD(&(resident->pins), 1);
+                *(batch->pinOut) = resident;
+            }
+            unlockCacheShard(shard);
+            filled++;
+        }
     }
 
-    checkCacheOverflow(fd);
-    createCache(root, devHash, alignedOffset, buf);
+    free(batch);
+    return (filled > 0) ? filled : -1;
 }
 
-void writeDevWithCache(int fd, LRUHash* devHash, cache* cache, const void* buf, off_t offsetInCache, size_t count)
+// 同步读入一批未命中块，返回值同 completeMissBatch，没有未命中块时返回 0
+int readMissingBlocks(int fd, off_t alignedOffset, int blockCount, unsigned int flags, int* covered)
 {
-    size_t cacheSize = CACHE_SIZE;
-    
-    unsigned char* tempBuffer = (unsigned char*)malloc(cacheSize);
-    if (tempBuffer == NULL) 
+    MissBatch* batch = NULL;
+    int scanned = 0;
+    int missing = prepareMissBatch(fd, alignedOffset, blockCount, flags, &scanned, &batch);
+
+    if (covered != NULL)
     {
-        perror("malloc failed");
-        return;
+        *covered = scanned;
     }
+    if (missing <= 0)
+    {
+        return missing;
+    }
+
+    submitIoBatch(batch->requests, batch->requestCount);
+    return completeMissBatch(batch);
+}
 
-    ssize_t ret = pread(fd, tempBuffer, cacheSize, cache->offset);
-    if (ret < 0) 
+// 读请求没有发出时归还已分配的缓存块并释放 batch
+void discardMissBatch(MissBatch* batch)
+{
+    CacheSet* set = findFdNode(batch->fd)->set;
+    for (int i = 0; i < batch->blockCount; i++)
     {
-        perror("pread from blkcache");
-        free(tempBuffer);
-        return;
+        freeBlock(set->pool, batch->entries[i]);
     }
+    free(batch);
+}
 
-    size_t remainingBytes = count;
-    size_t offsetInTempBuffer = offsetInCache % cacheSize;
-    if (remainingBytes > cacheSize - offsetInTempBuffer) 
+// 预读量不超过预算的四分之一，避免挤掉热点数据
+size_t limitPrefetchBytes(CacheSet* set, size_t length)
+{
+    size_t budgetBytes = ATOMIC_LOAD(&(cacheBudget.limitBytes)) / 4;
+    size_t capacity = ATOMIC_LOAD(&(set->capacityBytes));
+    if (capacity != 0)
     {
-        remainingBytes = cacheSize - offsetInTempBuffer;
+        budgetBytes = MIN(budgetBytes, capacity / 4);
     }
+    return MIN(length, MAX(budgetBytes, set->blockSize));
+}
 
-    memcpy(tempBuffer + offsetInTempBuffer, buf, remainingBytes);
+void prefetchHostCache(int fd, off_t offset, size_t length)
+{
+    HashTableFdNode* hashTableFdNode = findFdNode(fd);
+    CacheSet* set = hashTableFdNode->set;
+    off_t blockSize = (off_t)set->blockSize;
+    off_t end = offset + (off_t)limitPrefetchBytes(set, length);
 
-    ret = pwrite(fd, tempBuffer, CACHE_SIZE, cache->offset);
-    if (ret < 0) 
+    off_t pos = ROUND_DOWN_TO_BLOCK(offset, blockSize);
+    while (pos < end)
     {
-        perror("pwrite from blkcache");
-        free(tempBuffer);
-        return;
-    } 
-    
-    cache->dirty = 1;
-    moveNodeToHeadByKey(devHash, (long)(cache->offset / CACHE_SIZE));
+        int covered = 0;
+        off_t blocks = MIN((end - pos + blockSize - 1) / blockSize, (off_t)INT_MAX);
+        int filled = readMissingBlocks(fd, pos, (int)blocks, CACHE_FLAG_READAHEAD, &covered);
+        if (filled < 0 || covered == 0)
+        {
+            return;
+        }
+        if (filled > 0 && hashTableFdNode->ra != NULL)
+        {
+            noteReadaheadPrefetched(hashTableFdNode->ra, (unsigned long)filled);
+        }
+        pos += (off_t)covered * blockSize;
+    }
+}
 
-    free(tempBuffer);
+// 调用者持有 cache 所在分片的锁
+void writeHostWithCache(CacheSet* set, cache* cache, const void* buf, off_t offsetInCache, size_t count)
+{
+    memcpy((cache->data) + offsetInCache, buf, count);
+    markCacheDirty(set, cache);
+    replacementHit(&(CACHE_SHARD_OF(set, cache->offset)->policy), cache);
 }
 
-void writeDevWithoutCache(int fd, const void* buf, off_t offset, size_t count)
+// 写未命中。覆盖整块时直接把数据装入缓存作为脏块，不读设备；只覆盖部分块时按写分配读入整块再合并，
+// 不写分配时直接写到设备。写入设备失败时返回 -1
+int writeHostWithoutCache(int fd, const void* buf, off_t offset, size_t count)
 {
     HashTableFdNode* hashTableFdNode = findFdNode(fd);
-    AVLTreeNode** root = &(hashTableFdNode->root);
-    LRUHash* devHash = hashTableFdNode->Hash;
+    CacheSet* set = hashTableFdNode->set;
+    size_t blockSize = set->blockSize;
+    off_t alignedOffset = ROUND_DOWN_TO_BLOCK(offset, blockSize);
+    size_t offsetInCache = (size_t)(offset - alignedOffset);
 
+    if (count == blockSize)
+    {
+        checkCacheOverflow(fd);
+    }
+    else if (set->writeMissPolicy == CACHE_WRITE_ALLOCATE)
+    {
+        // 读不到旧数据就无法合并，也不改为直接写设备
+        if (readMissingBlocks(fd, alignedOffset, 1, 0, NULL) < 0)
+        {
+            fprintf(stderr, "Error reading data from file descriptor %d at offset %lld\n", fd, (long long)alignedOffset);
+            return -1;
+        }
+    }
 
-    // -----
+    CacheShard* shard = lockCacheShard(set, alignedOffset);
+    cache* cache = findCache(set, alignedOffset);
+    if (cache == NULL && count == blockSize)
+    {
+        cache = createCache(set, alignedOffset, buf);
+        if (cache != NULL)
+        {
+            markCacheDirty(set, cache);
+            unlockCacheShard(shard);
+            return 0;
+        }
+    }
+    if (cache != NULL)
+    {
+        // 其他线程可能已在此期间读入该块
+        cache->flags &= ~(CACHE_FLAG_READAHEAD | CACHE_FLAG_FRESH);
+        memcpy((char*)cache->data + offsetInCache, buf, count);
+        markCacheDirty(set, cache);
+        unlockCacheShard(shard);
+        return 0;
+    }
+    unlockCacheShard(shard);
 
-    // int writeNumb = pwrite(fd, buf, count, offset);
-    // if (writeNumb == -1)
-    // {
-    //     fprintf(stderr, "Error reading data from file descriptor %d at offset %lld\n", fd, (long long)offset);
-    //     return;
-    // }
+    // 不写分配，或刚读入的块又被淘汰
+    return writeHostThrough(fd, buf, offset, count, 0);
+}
 
-    //TODO:将buf中的内容写到块设备中去
+// 直写与绕写：先写设备，再更新驻留的块，块保持干净。写入落盘前其他线程可能已读入旧数据，这里用新数据覆盖；
+// 正在写回的旧数据可能晚于本次写入落盘，重新标脏。allocate 时未命中的块按整块/写分配规则装入缓存
+int writeHostThrough(int fd, const void* buf, off_t offset, size_t count, int allocate)
+{
+    HashTableFdNode* hashTableFdNode = findFdNode(fd);
+    CacheSet* set = hashTableFdNode->set;
+    size_t blockSize = set->blockSize;
+    off_t alignedOffset = ROUND_DOWN_TO_BLOCK(offset, blockSize);
 
-    size_t cacheSize = CACHE_SIZE;
-    
-    unsigned char* tempBuffer = (unsigned char*)malloc(cacheSize);
-    if (tempBuffer == NULL) 
+    if (pwrite(fd, buf, count, offset) != (ssize_t)count)
     {
-        perror("malloc failed");
-        return;
+        fprintf(stderr, "Error writing data to file descriptor %d at offset %lld\n", fd, (long long)offset);
+        return -1;
     }
+    CACHE_STAT_ADD(set, offset, deviceWriteBytes, count);
+    noteDeviceWrite(set, offset, count);
 
-    off_t alignedOffset = ROUND_DOWN_TO_4096(offset);
+    if (allocate && count == blockSize)
+    {
+        checkCacheOverflow(fd);
+    }
 
-    int ret = lseek(fd, alignedOffset, SEEK_SET);
-    if (ret < 0) 
+    CacheShard* shard = lockCacheShard(set, alignedOffset);
+    cache* cache = findCache(set, alignedOffset);
+    if (cache != NULL)
     {
-        perror("lseek");
-        return;
-    } 
+        memcpy((char*)cache->data + (offset - alignedOffset), buf, count);
+        if (cache->flags & CACHE_FLAG_WRITEBACK)
+        {
+            markCacheDirty(set, cache);
+        }
+        if (allocate)
+        {
+            cache->flags &= ~(CACHE_FLAG_READAHEAD | CACHE_FLAG_FRESH);
+            replacementHit(&(shard->policy), cache);
+        }
+    }
+    else if (allocate && count == blockSize)
+    {
+        createCache(set, alignedOffset, buf);
+    }
+    unlockCacheShard(shard);
 
-    ret = ioctl(fd, IOCTL_READ_BLOCK, tempBuffer);
-    if (ret < 0) 
+    // 设备上已是新数据，部分块直接读入即可
+    if (cache == NULL && allocate && count != blockSize && set->writeMissPolicy == CACHE_WRITE_ALLOCATE)
     {
-        perror("ioctl read second device");
-        return;
+        readMissingBlocks(fd, alignedOffset, 1, 0, NULL);
     }
+    return 0;
+}
 
-    memcpy(tempBuffer + offset, buf, count);
+// 调用者持有 fdTableLock 写锁
+void writeBackAndCleanUpCache(int fd)
+{
+    HashTableFdNode* hashTableFdNode = findFdNode(fd);
+
+    traversalWriteBackCache(hashTableFdNode->set, fd);
+    if (hashTableFdNode->tier != NULL)
+    {
+        flushDeviceTier(hashTableFdNode->tier);
+    }
+    retireCacheSetStats(hashTableFdNode->set, hashTableFdNode->tier);
+
+    cleanUpCache(hashTableFdNode->set);
+    hashTableFdNode->set = NULL;
+    destroyDeviceTier(hashTableFdNode->tier);
+    hashTableFdNode->tier = NULL;
+
+    destroyReadahead(hashTableFdNode->ra);
+    hashTableFdNode->ra = NULL;
+    destroyBypass(hashTableFdNode->bypass);
+    hashTableFdNode->bypass = NULL;
+    free(hashTableFdNode->hotSetPath);
+    hashTableFdNode->hotSetPath = NULL;
+}
 
-    // ret = pwrite(fd, tempBuffer, CACHE_SIZE, alignedOffset);
-    // if (ret < 0) 
-    // {
-    //     perror("pwrite from blkcache");
-    //     free(tempBuffer);
-    //     return;
-    // } 
+
+// 设备模式的内存层未命中：在分片写锁下先查 NVMe 层，命中则从缓存分区读入并提升，否则从后端设备读入。
+// fill 为 0 表示调用者将整块覆盖，不读旧内容。成功时返回装入的块且仍持有分片写锁，失败返回 NULL
+cache* loadDevBlock(int fd, off_t alignedOffset, int fill, CacheShard** shardOut)
+{
+    HashTableFdNode* hashTableFdNode = findFdNode(fd);
+    CacheSet* set = hashTableFdNode->set;
 
     checkCacheOverflow(fd);
-    createCache(root, devHash, alignedOffset, tempBuffer);
+    CacheShard* shard = lockCacheShard(set, alignedOffset);
+    cache* cache = findCache(set, alignedOffset);
+    if (cache != NULL)
+    {
+        *shardOut = shard;
+        return cache;
+    }
+
+    // 持有写锁，先加入索引也不会被其他线程看到未填充的内容
+    cache = allocCache(set, alignedOffset);
+    if (cache == NULL || insertCache(set, cache) < 0)
+    {
+        unlockCacheShard(shard);
+        return NULL;
+    }
+
+    // 持分片锁查 NVMe 层：同一块的降级也在该分片锁下进行，NVMe 层淘汰脏块时先写回后端，因此这里不会读到旧数据
+    int dirty = 0;
+    int found = 0;
+    if (hashTableFdNode->tier != NULL)
+    {
+        found = promoteDeviceTierBlock(hashTableFdNode->tier, alignedOffset, fill ? cache->data : NULL, &dirty);
+    }
+    if (found == 0 && fill)
+    {
+        found = (readBackingBlock(fd, &(hashTableFdNode->ioLock), alignedOffset, cache->data, set->blockSize) < 0) ? -1 : 0;
+        if (found == 0)
+        {
+            CACHE_STAT_ADD(set, alignedOffset, deviceReadBytes, set->blockSize);
+        }
+    }
+    if (found < 0)
+    {
+        deleteCache(set, cache);
+        unlockCacheShard(shard);
+        return NULL;
+    }
 
-    free(tempBuffer);
-    
-}
\ No newline at end of file
+    if (dirty)
+    {
+        markCacheDirty(set, cache);
+    }
+    *shardOut = shard;
+    return cache;
+}
@@ -3,30 +3,63 @@
 
 
 #include "cacheStruct.h"
+#include "ioEngine.h"
 #include <fcntl.h>
 #include <sys/ioctl.h>
 #include <linux/ioctl.h>
 
+struct HashTableFdNode;
+
 #define IOCTL_READ_BLOCK  _IOR('b', 2, char*)
 #define IOCTL_WRITE_BLOCK _IOW('b', 3, char*)
+#define DEVICE_SECTOR_SIZE 512  // 上面两个 ioctl 每次传输的字节数
+
+#define CACHE_MAX_IO_BYTES (4UL << 20)
+#define CACHE_MAX_IOV 1024
+#define CACHE_CLEAN_SCAN_DEPTH 8
+#define CACHE_MAX_MISS_RUNS 32
+#define CACHE_MISS_NO_EVICT 0x100   // prepareMissBatch 只用空余预算，不淘汰已有的块；不记入块的 flags
 
-#define MAX_CACHE_ENTRIES 5
+// 一批未命中读：每段连续块一个请求，请求、iovec 与缓存块数组跟在结构体后面一起分配
+typedef struct MissBatch
+{
+    int fd;
+    unsigned int flags;
+    int blockCount;
+    int requestCount;
+    IoRequest* requests;
+    struct iovec* iov;
+    cache** entries;
+    unsigned long* epochs;      // 发出读请求前各块所在分片的 writeEpoch
+    cache** pinOut;             // 非 NULL 时把装入或已驻留的块在分片锁下加一个引用后存到这里，只用于单块批次
+} MissBatch;
 
-void readWithHostCache(LRUHash* Hash, cache* cache, void* buf, off_t offsetInCache, size_t count);
+void readWithHostCache(CacheSet* set, cache* cache, void* buf, off_t offsetInCache, size_t count);
 void readWithoutHostCache(int fd, void* buf, off_t alignedOffset);
-void writeHostWithCache(LRUHash* Hash, cache* cache, const void* buf, off_t offsetInCache, size_t count);
-void writeHostWithoutCache(int fd, const void* buf, off_t offset, size_t count);
+void noteDeviceWrite(CacheSet* set, off_t offset, size_t length);
+unsigned long sampleDeviceWriteEpoch(CacheSet* set, off_t offset, size_t length);
+int maxMissRunBlocks(CacheSet* set);
+int prepareMissBatch(int fd, off_t alignedOffset, int blockCount, unsigned int flags, int* covered, MissBatch** batchOut);
+int completeMissBatch(MissBatch* batch);
+int readMissingBlocks(int fd, off_t alignedOffset, int blockCount, unsigned int flags, int* covered);
+void discardMissBatch(MissBatch* batch);
+size_t limitPrefetchBytes(CacheSet* set, size_t length);
+void prefetchHostCache(int fd, off_t offset, size_t length);
+void writeHostWithCache(CacheSet* set, cache* cache, const void* buf, off_t offsetInCache, size_t count);
+int writeHostWithoutCache(int fd, const void* buf, off_t offset, size_t count);
+int writeHostThrough(int fd, const void* buf, off_t offset, size_t count, int allocate);
 
-void readDevWithCache(int fd, LRUHash* Hash, cache* cache, void* buf, off_t offsetInCache, size_t count);
-void readWithoutDevCache(int fd, void* buf, off_t alignedOffset);
-void writeDevWithCache(int fd, LRUHash* Hash, cache* cache, const void* buf, off_t offsetInCache, size_t count);
-void writeDevWithoutCache(int fd, const void* buf, off_t offset, size_t count);
+cache* loadDevBlock(int fd, off_t alignedOffset, int fill, CacheShard** shardOut);
 
-void traversalWriteBackCache(AVLTreeNode* root, int fd);
+void traversalWriteBackCache(CacheSet* set, int fd);
+size_t flushCacheSet(struct HashTableFdNode* hashTableFdNode, size_t maxBytes);
+void checkCacheOverflow(int fd);
+void trimCacheToBudget(int fd, size_t incomingBytes);
+size_t freeCacheBudget(CacheSet* set);
 void writeBackAndCleanUpCache(int fd);
 
 
-#define ROUND_UP_TO_4096(size) (((size) + CACHE_SIZE - 1) / CACHE_SIZE * CACHE_SIZE)
-#define ROUND_DOWN_TO_4096(size) ((size) / CACHE_SIZE * CACHE_SIZE)
+#define ROUND_UP_TO_BLOCK(size, blockSize) (((size) + (blockSize) - 1) & ~((off_t)(blockSize) - 1))
+#define ROUND_DOWN_TO_BLOCK(size, blockSize) ((size) & ~((off_t)(blockSize) - 1))
 
 #endif 
\ No newline at end of file
@@ -0,0 +1,61 @@
+#include <string.h>
+
+#include "streamTable.h"
+
+
+void initStreamTable(StreamTable* table, size_t slack)
+{
+    memset(table, 0, sizeof(*table));
+    table->slack = slack;
+}
+
+static int matchStream(StreamTable* table, off_t offset)
+{
+    for (int i = 0; i < STREAM_TABLE_SIZE; i++)
+    {
+        SeqStream* s = &(table->streams[i]);
+        if (s->active && offset + (off_t)table->slack >= s->nextOffset &&
+            offset <= s->nextOffset + (off_t)table->slack)
+        {
+            return i;
+        }
+    }
+    return -1;
+}
+
+static int replaceStream(StreamTable* table)
+{
+    int victim = 0;
+    for (int i = 0; i < STREAM_TABLE_SIZE; i++)
+    {
+        SeqStream* s = &(table->streams[i]);
+        if (!s->active)
+        {
+            return i;
+        }
+        if (s->lastUse < table->streams[victim].lastUse)
+        {
+            victim = i;
+        }
+    }
+    return victim;
+}
+
+int trackStream(StreamTable* table, off_t offset, size_t count, int* isNew)
+{
+    int index = matchStream(table, offset);
+    *isNew = (index < 0);
+    if (index < 0)
+    {
+        index = replaceStream(table);
+        table->streams[index].active = 1;
+        table->streams[index].runBytes = 0;
+    }
+
+    SeqStream* s = &(table->streams[index]);
+    table->clock++;
+    s->runBytes += count;
+    s->nextOffset = offset + (off_t)count;
+    s->lastUse = table->clock;
+    return index;
+}
@@ -0,0 +1,32 @@
+#ifndef STREAM_TABLE_H
+#define STREAM_TABLE_H
+
+#include <stddef.h>
+#include <sys/types.h>
+
+#define STREAM_TABLE_SIZE 8
+
+// 单条顺序流：下一次期望的偏移与累计长度
+typedef struct SeqStream
+{
+    off_t nextOffset;
+    size_t runBytes;
+    unsigned long lastUse;
+    int active;
+} SeqStream;
+
+// 预读与旁路共用的顺序流识别：请求起点落在某条流期望偏移的 slack 范围内即视为延续，
+// 否则替换最久未用的一条。不加锁，由调用者保护
+typedef struct StreamTable
+{
+    SeqStream streams[STREAM_TABLE_SIZE];
+    size_t slack;
+    unsigned long clock;
+} StreamTable;
+
+
+void initStreamTable(StreamTable* table, size_t slack);
+// 记录一次请求，返回所属流的下标；新建流时 isNew 置 1，runBytes 从本次请求开始累计
+int trackStream(StreamTable* table, off_t offset, size_t count, int* isNew);
+
+#endif
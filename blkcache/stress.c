@@ -0,0 +1,709 @@
+// blkcache-stress：多个线程在同一个 fd 上随机读写，各自负责文件中不相交的一段，读到的数据与内存中的副本比对；
+// 同时有一个线程反复打开、读写、关闭另一个文件，记录打开/关闭的最长等待。覆盖同步、向量、异步读写、
+// 块借用、顺序预读与容量调整，结束时核对落盘数据。make check 运行，make check-tsan 在 ThreadSanitizer 下运行
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <getopt.h>
+#include <pthread.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/uio.h>
+
+#include "cacheIOHandler.h"
+#include "cacheAsync.h"
+#include "hashTable.h"
+#include "flusher.h"
+#include "ioEngine.h"
+
+#define STRESS_BLOCK 4096
+#define STRESS_MAX_REQUEST (128UL << 10)
+#define STRESS_SWEEP_STEPS 16
+#define STRESS_CHURN_BYTES (256UL << 10)
+#define STRESS_MAX_REPORTS 10
+
+typedef struct StressConfig
+{
+    const char* path;
+    char churnPath[4096];
+    size_t fileBytes;
+    size_t regionBytes;     // 每个线程负责的字节数，块对齐
+    int threads;
+    unsigned long ops;      // 每个线程的操作数
+    unsigned long seed;
+    size_t cacheMemory;
+    int policy;
+    int writePolicy;
+    int flusher;
+    int ioEngine;           // 0 不启用，1 io_uring，2 io_uring + SQPOLL
+    unsigned int asyncWorkers;  // 异步接口的后台线程数，0 使用默认值
+    size_t bypassBytes;     // 达到该长度的请求绕过缓存，0 表示关闭
+    unsigned long maxWaitMs;    // 打开/关闭的等待超过该值视为失败
+} StressConfig;
+
+typedef struct StressThread
+{
+    int id;
+    unsigned long long rng;
+    pthread_t thread;
+} StressThread;
+
+// 异步请求的完成通知
+typedef struct StressWait
+{
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    int done;
+    ssize_t result;
+} StressWait;
+
+static StressConfig config;
+static int cacheFd = -1;
+static char* shadow = NULL;
+static unsigned long failures = 0;
+static int workersDone = 0;
+static unsigned long long maxOpenNs = 0;
+static unsigned long long maxCloseNs = 0;
+static unsigned long churnCycles = 0;
+
+
+static unsigned long long nowNs(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (unsigned long long)ts.tv_sec * 1000000000ULL + (unsigned long long)ts.tv_nsec;
+}
+
+static unsigned long long nextRandom(unsigned long long* state)
+{
+    // xorshift64*
+    unsigned long long x = *state;
+    x ^= x >> 12;
+    x ^= x << 25;
+    x ^= x >> 27;
+    *state = x;
+    return x * 2685821657736338717ULL;
+}
+
+static void fillRandom(unsigned long long* state, char* buf, size_t length)
+{
+    for (size_t i = 0; i < length; i++)
+    {
+        buf[i] = (char)(nextRandom(state) >> 56);
+    }
+}
+
+static void reportFailure(const char* what, int id, off_t offset, size_t length, ssize_t result)
+{
+    if (__atomic_add_fetch(&failures, 1, __ATOMIC_RELAXED) <= STRESS_MAX_REPORTS)
+    {
+        fprintf(stderr, "FAIL: %s thread %d offset %lld length %zu result %zd\n", what, id, (long long)offset, length,
+                result);
+    }
+}
+
+// 请求长度大多在 16 KiB 以内，偶尔取到 STRESS_MAX_REQUEST，起点不一定块对齐
+static void pickRange(StressThread* t, size_t maxLength, off_t* offset, size_t* length)
+{
+    size_t limit = (nextRandom(&(t->rng)) % 10 == 0) ? maxLength : MIN(maxLength, (size_t)(16UL << 10));
+    *length = 1 + (size_t)(nextRandom(&(t->rng)) % limit);
+    *offset = (off_t)((size_t)t->id * config.regionBytes + nextRandom(&(t->rng)) % (config.regionBytes - *length + 1));
+}
+
+static void checkRead(StressThread* t, const char* what, const char* buf, off_t offset, size_t length, ssize_t result)
+{
+    if (result != (ssize_t)length || memcmp(buf, shadow + offset, length) != 0)
+    {
+        reportFailure(what, t->id, offset, length, result);
+    }
+}
+
+static void stressDone(int fd, ssize_t result, void* arg)
+{
+    StressWait* wait = (StressWait*)arg;
+    (void)fd;
+
+    pthread_mutex_lock(&(wait->lock));
+    wait->result = result;
+    wait->done = 1;
+    pthread_cond_signal(&(wait->cond));
+    pthread_mutex_unlock(&(wait->lock));
+}
+
+static ssize_t waitAsync(StressWait* wait, ssize_t ret)
+{
+    if (ret != CACHE_ASYNC_PENDING)
+    {
+        return ret;
+    }
+
+    pthread_mutex_lock(&(wait->lock));
+    while (!wait->done)
+    {
+        pthread_cond_wait(&(wait->cond), &(wait->lock));
+    }
+    pthread_mutex_unlock(&(wait->lock));
+    return wait->result;
+}
+
+static void runAsync(StressThread* t, char* buf, int isWrite)
+{
+    StressWait wait;
+    off_t offset;
+    size_t length;
+
+    memset(&wait, 0, sizeof(wait));
+    pthread_mutex_init(&(wait.lock), NULL);
+    pthread_cond_init(&(wait.cond), NULL);
+    pickRange(t, STRESS_MAX_REQUEST, &offset, &length);
+
+    if (isWrite)
+    {
+        fillRandom(&(t->rng), buf, length);
+        ssize_t ret = waitAsync(&wait, writeWithCacheAsync(cacheFd, buf, length, offset, stressDone, &wait));
+        if (ret != (ssize_t)length)
+        {
+            reportFailure("async write", t->id, offset, length, ret);
+        }
+        memcpy(shadow + offset, buf, length);
+    }
+    else
+    {
+        ssize_t ret = waitAsync(&wait, readWithCacheAsync(cacheFd, buf, length, offset, stressDone, &wait));
+        checkRead(t, "async read", buf, offset, length, ret);
+    }
+
+    pthread_cond_destroy(&(wait.cond));
+    pthread_mutex_destroy(&(wait.lock));
+}
+
+// 分成三段分散/收集，各段长度随机
+static void runVector(StressThread* t, char* buf, int isWrite)
+{
+    struct iovec iov[3];
+    off_t offset;
+    size_t length;
+
+    pickRange(t, STRESS_MAX_REQUEST, &offset, &length);
+    size_t first = (size_t)(nextRandom(&(t->rng)) % (length + 1));
+    size_t second = (size_t)(nextRandom(&(t->rng)) % (length - first + 1));
+    iov[0].iov_base = buf;
+    iov[0].iov_len = first;
+    iov[1].iov_base = buf + first;
+    iov[1].iov_len = second;
+    iov[2].iov_base = buf + first + second;
+    iov[2].iov_len = length - first - second;
+
+    if (isWrite)
+    {
+        fillRandom(&(t->rng), buf, length);
+        ssize_t ret = writevWithCache(cacheFd, iov, 3, offset);
+        if (ret != (ssize_t)length)
+        {
+            reportFailure("writev", t->id, offset, length, ret);
+        }
+        memcpy(shadow + offset, buf, length);
+    }
+    else
+    {
+        checkRead(t, "readv", buf, offset, length, readvWithCache(cacheFd, iov, 3, offset));
+    }
+}
+
+// 从随机位置起顺序读，触发预读
+static void runSweep(StressThread* t, char* buf)
+{
+    size_t step = 16UL << 10;
+    size_t total = MIN(step * STRESS_SWEEP_STEPS, config.regionBytes);
+    off_t offset = (off_t)((size_t)t->id * config.regionBytes + nextRandom(&(t->rng)) % (config.regionBytes - total + 1));
+
+    for (size_t done = 0; done < total; done += step)
+    {
+        size_t length = MIN(step, total - done);
+        checkRead(t, "sequential read", buf, offset + (off_t)done, length,
+                  readWithCache(cacheFd, buf, length, offset + (off_t)done));
+    }
+}
+
+// 借出自己区域内的一块，持有期间只有本线程会写它；有效的偏移上借出失败算错误
+static void runBlockRef(StressThread* t)
+{
+    off_t offset = (off_t)((size_t)t->id * config.regionBytes +
+                           (nextRandom(&(t->rng)) % (config.regionBytes / STRESS_BLOCK)) * STRESS_BLOCK);
+    BlockRef ref;
+
+    if (getBlockRef(cacheFd, offset, &ref) < 0)
+    {
+        reportFailure("block ref", t->id, offset, STRESS_BLOCK, -1);
+        return;
+    }
+    if (ref.offset != offset || memcmp(ref.data, shadow + offset, STRESS_BLOCK) != 0)
+    {
+        reportFailure("block ref", t->id, offset, STRESS_BLOCK, (ssize_t)ref.length);
+    }
+    putBlockRef(&ref);
+}
+
+static void* stressThreadMain(void* arg)
+{
+    StressThread* t = (StressThread*)arg;
+    char* buf = (char*)malloc(STRESS_MAX_REQUEST);
+    if (buf == NULL)
+    {
+        perror("Failed to allocate stress buffer");
+        __atomic_add_fetch(&failures, 1, __ATOMIC_RELAXED);
+        return NULL;
+    }
+
+    for (unsigned long i = 0; i < config.ops; i++)
+    {
+        unsigned int choice = (unsigned int)(nextRandom(&(t->rng)) % 100);
+        off_t offset;
+        size_t length;
+
+        if (choice < 30)
+        {
+            pickRange(t, STRESS_MAX_REQUEST, &offset, &length);
+            fillRandom(&(t->rng), buf, length);
+            ssize_t ret = writeWithCache(cacheFd, buf, length, offset);
+            if (ret != (ssize_t)length)
+            {
+                reportFailure("write", t->id, offset, length, ret);
+            }
+            memcpy(shadow + offset, buf, length);
+        }
+        else if (choice < 60)
+        {
+            pickRange(t, STRESS_MAX_REQUEST, &offset, &length);
+            checkRead(t, "read", buf, offset, length, readWithCache(cacheFd, buf, length, offset));
+        }
+        else if (choice < 70)
+        {
+            runVector(t, buf, choice < 65);
+        }
+        else if (choice < 78)
+        {
+            runSweep(t, buf);
+        }
+        else if (choice < 90)
+        {
+            runAsync(t, buf, choice < 84);
+        }
+        else if (choice < 97)
+        {
+            runBlockRef(t);
+        }
+        else
+        {
+            // 收缩或放开该 fd 的容量，让淘汰与写回和读写并发
+            size_t capacity = (choice == 99) ? 0 : (size_t)(nextRandom(&(t->rng)) % (config.cacheMemory / 2 + 1));
+            setCacheCapacity(cacheFd, capacity);
+        }
+    }
+
+    free(buf);
+    return NULL;
+}
+
+static void noteMaxNs(unsigned long long* target, unsigned long long value)
+{
+    if (value > *target)
+    {
+        *target = value;
+    }
+}
+
+// 打开/关闭取 fd 表的写锁，读写不断时也必须能在有限时间内完成
+static void* churnThreadMain(void* arg)
+{
+    unsigned long long rng = (unsigned long long)(unsigned long)arg | 1;
+    char* expect = (char*)malloc(STRESS_CHURN_BYTES);
+    char* buf = (char*)malloc(STRESS_CHURN_BYTES);
+    CacheOptions options;
+
+    memset(&options, 0, sizeof(options));
+    options.blockSize = STRESS_BLOCK;
+    while (expect != NULL && buf != NULL && !__atomic_load_n(&workersDone, __ATOMIC_ACQUIRE))
+    {
+        unsigned long long start = nowNs();
+        int fd = openWithCache(config.churnPath, O_RDWR | O_CREAT, 0644, CACHE_TYPE_HOST, &options);
+        noteMaxNs(&maxOpenNs, nowNs() - start);
+        if (fd < 0)
+        {
+            reportFailure("churn open", -1, 0, 0, fd);
+            break;
+        }
+
+        fillRandom(&rng, expect, STRESS_CHURN_BYTES);
+        for (size_t done = 0; done < STRESS_CHURN_BYTES; done += 32UL << 10)
+        {
+            if (writeWithCache(fd, expect + done, 32UL << 10, (off_t)done) != (ssize_t)(32UL << 10))
+            {
+                reportFailure("churn write", -1, (off_t)done, 32UL << 10, -1);
+            }
+        }
+        if (readWithCache(fd, buf, STRESS_CHURN_BYTES, 0) != (ssize_t)STRESS_CHURN_BYTES ||
+            memcmp(buf, expect, STRESS_CHURN_BYTES) != 0)
+        {
+            reportFailure("churn read", -1, 0, STRESS_CHURN_BYTES, -1);
+        }
+
+        CacheStats stats;
+        getGlobalCacheStats(&stats);
+
+        start = nowNs();
+        closeWithCache(fd);
+        noteMaxNs(&maxCloseNs, nowNs() - start);
+
+        // 关闭时脏块已写回
+        int raw = open(config.churnPath, O_RDONLY);
+        if (raw < 0 || pread(raw, buf, STRESS_CHURN_BYTES, 0) != (ssize_t)STRESS_CHURN_BYTES ||
+            memcmp(buf, expect, STRESS_CHURN_BYTES) != 0)
+        {
+            reportFailure("churn persist", -1, 0, STRESS_CHURN_BYTES, -1);
+        }
+        if (raw >= 0)
+        {
+            close(raw);
+        }
+        churnCycles++;
+    }
+
+    free(expect);
+    free(buf);
+    return NULL;
+}
+
+static int writeFull(int fd, const char* data, size_t length)
+{
+    size_t done = 0;
+    while (done < length)
+    {
+        ssize_t n = pwrite(fd, data + done, length - done, (off_t)done);
+        if (n < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        if (n <= 0)
+        {
+            return -1;
+        }
+        done += (size_t)n;
+    }
+    return 0;
+}
+
+static int readFull(int fd, char* data, size_t length)
+{
+    size_t done = 0;
+    while (done < length)
+    {
+        ssize_t n = pread(fd, data + done, length - done, (off_t)done);
+        if (n < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        if (n <= 0)
+        {
+            return -1;
+        }
+        done += (size_t)n;
+    }
+    return 0;
+}
+
+// 用随机内容建立测试文件与内存副本
+static int prepareFile(void)
+{
+    unsigned long long rng = config.seed | 1;
+
+    shadow = (char*)malloc(config.fileBytes);
+    if (shadow == NULL)
+    {
+        perror("Failed to allocate shadow copy");
+        return -1;
+    }
+    fillRandom(&rng, shadow, config.fileBytes);
+
+    int fd = open(config.path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0 || writeFull(fd, shadow, config.fileBytes) < 0)
+    {
+        fprintf(stderr, "Error: Failed to prepare %s: %s\n", config.path, strerror(errno));
+        if (fd >= 0)
+        {
+            close(fd);
+        }
+        return -1;
+    }
+    close(fd);
+    return 0;
+}
+
+// 关闭后按普通文件读回，与副本逐字节比对
+static int verifyFile(void)
+{
+    char* data = (char*)malloc(config.fileBytes);
+    int fd = open(config.path, O_RDONLY);
+    int ret = 0;
+
+    if (data == NULL || fd < 0 || readFull(fd, data, config.fileBytes) < 0)
+    {
+        fprintf(stderr, "Error: Failed to read back %s\n", config.path);
+        ret = -1;
+    }
+    else
+    {
+        for (size_t i = 0; i < config.fileBytes; i++)
+        {
+            if (data[i] != shadow[i])
+            {
+                fprintf(stderr, "FAIL: persisted data differs at offset %zu\n", i);
+                ret = -1;
+                break;
+            }
+        }
+    }
+
+    if (fd >= 0)
+    {
+        close(fd);
+    }
+    free(data);
+    return ret;
+}
+
+static int parseSize(const char* text, size_t* value)
+{
+    char* end = NULL;
+    double number = strtod(text, &end);
+    if (end == text || number < 0)
+    {
+        return -1;
+    }
+
+    switch (*end)
+    {
+    case 'k': case 'K': number *= 1024.0; end++; break;
+    case 'm': case 'M': number *= 1024.0 * 1024.0; end++; break;
+    case 'g': case 'G': number *= 1024.0 * 1024.0 * 1024.0; end++; break;
+    default: break;
+    }
+    if (*end != '\0')
+    {
+        return -1;
+    }
+    *value = (size_t)number;
+    return 0;
+}
+
+static int parseName(const char* text, const char* const* names, int count)
+{
+    for (int i = 0; i < count; i++)
+    {
+        if (strcmp(text, names[i]) == 0)
+        {
+            return i;
+        }
+    }
+    return -1;
+}
+
+static void usage(const char* program)
+{
+    fprintf(stderr,
+            "Usage: %s [options]\n"
+            "  --file PATH            scratch file, overwritten (default /tmp/blkcache-stress.bin)\n"
+            "  --size BYTES           file size (default 32M)\n"
+            "  --threads N            reader/writer threads on the shared fd (default 4)\n"
+            "  --ops N                operations per thread (default 20000)\n"
+            "  --seed N\n"
+            "  --cache-mem BYTES      global cache memory limit, small values force eviction (default 4M)\n"
+            "  --policy NAME          lru | arc | 2q | s3fifo | clock\n"
+            "  --write-policy NAME    back | through | around\n"
+            "  --no-flusher           do not run the background flusher\n"
+            "  --io-engine N          0 off, 1 io_uring, 2 io_uring with SQPOLL (default 0)\n"
+            "  --async-workers N      background threads for the async API (default 4)\n"
+            "  --bypass BYTES         requests of at least BYTES bypass the cache (default off)\n"
+            "  --max-wait-ms N        fail if one open or close waits longer (default 10000)\n"
+            "A second file PATH.churn is opened and closed in a loop while the threads run.\n",
+            program);
+}
+
+int main(int argc, char** argv)
+{
+    static const char* const policyNames[] = { "lru", "arc", "2q", "s3fifo", "clock" };
+    static const char* const writePolicyNames[] = { "back", "through", "around" };
+    static const struct option longOptions[] =
+    {
+        { "file", required_argument, NULL, 'f' },
+        { "size", required_argument, NULL, 's' },
+        { "threads", required_argument, NULL, 't' },
+        { "ops", required_argument, NULL, 'n' },
+        { "seed", required_argument, NULL, 'S' },
+        { "cache-mem", required_argument, NULL, 'M' },
+        { "policy", required_argument, NULL, 'P' },
+        { "write-policy", required_argument, NULL, 'Y' },
+        { "no-flusher", no_argument, NULL, 'F' },
+        { "io-engine", required_argument, NULL, 'E' },
+        { "async-workers", required_argument, NULL, 'A' },
+        { "bypass", required_argument, NULL, 'B' },
+        { "max-wait-ms", required_argument, NULL, 'W' },
+        { "help", no_argument, NULL, 'h' },
+        { NULL, 0, NULL, 0 }
+    };
+
+    memset(&config, 0, sizeof(config));
+    config.path = "/tmp/blkcache-stress.bin";
+    config.fileBytes = 32UL << 20;
+    config.threads = 4;
+    config.ops = 20000;
+    config.seed = 1;
+    config.cacheMemory = 4UL << 20;
+    config.flusher = 1;
+    config.maxWaitMs = 10000;
+
+    int option;
+    int bad = 0;
+    while ((option = getopt_long(argc, argv, "", longOptions, NULL)) != -1)
+    {
+        switch (option)
+        {
+        case 'f': config.path = optarg; break;
+        case 's': bad |= parseSize(optarg, &(config.fileBytes)); break;
+        case 't': config.threads = atoi(optarg); break;
+        case 'n': config.ops = strtoul(optarg, NULL, 0); break;
+        case 'S': config.seed = strtoul(optarg, NULL, 0); break;
+        case 'M': bad |= parseSize(optarg, &(config.cacheMemory)); break;
+        case 'P': bad |= (config.policy = parseName(optarg, policyNames, 5)) < 0; break;
+        case 'Y': bad |= (config.writePolicy = parseName(optarg, writePolicyNames, 3)) < 0; break;
+        case 'F': config.flusher = 0; break;
+        case 'E': config.ioEngine = atoi(optarg); break;
+        case 'B': bad |= parseSize(optarg, &(config.bypassBytes)); break;
+        case 'A': config.asyncWorkers = (unsigned int)strtoul(optarg, NULL, 0); break;
+        case 'W': config.maxWaitMs = strtoul(optarg, NULL, 0); break;
+        default: bad = 1; break;
+        }
+    }
+
+    if (config.threads > 0)
+    {
+        config.regionBytes = config.fileBytes / (size_t)config.threads / STRESS_BLOCK * STRESS_BLOCK;
+    }
+    if (bad || config.threads <= 0 || config.regionBytes < STRESS_MAX_REQUEST || config.cacheMemory == 0)
+    {
+        usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+    snprintf(config.churnPath, sizeof(config.churnPath), "%s.churn", config.path);
+
+    if (prepareFile() < 0)
+    {
+        return EXIT_FAILURE;
+    }
+
+    setCacheMemoryLimit(config.cacheMemory);
+    setCacheAsyncWorkers(config.asyncWorkers);
+    if (config.ioEngine > 0)
+    {
+        IoEngineOptions engineOptions;
+        memset(&engineOptions, 0, sizeof(engineOptions));
+        engineOptions.sqpoll = (config.ioEngine > 1);
+        if (startIoEngine(&engineOptions) < 0)
+        {
+            fprintf(stderr, "Warning: io_uring is not available, running the synchronous path\n");
+        }
+    }
+    if (config.flusher)
+    {
+        // 间隔取短，让回写与读写、关闭充分交错
+        CacheFlusherOptions flusherOptions;
+        memset(&flusherOptions, 0, sizeof(flusherOptions));
+        flusherOptions.intervalMs = 10;
+        flusherOptions.maxDirtyAgeMs = 50;
+        startCacheFlusher(&flusherOptions);
+    }
+
+    CacheOptions options;
+    memset(&options, 0, sizeof(options));
+    options.blockSize = STRESS_BLOCK;
+    options.policy = config.policy;
+    options.writePolicy = config.writePolicy;
+    options.bypassBytes = config.bypassBytes;
+    cacheFd = openWithCache(config.path, O_RDWR, 0, CACHE_TYPE_HOST, &options);
+    if (cacheFd < 0)
+    {
+        fprintf(stderr, "Error: Failed to open %s with cache\n", config.path);
+        return EXIT_FAILURE;
+    }
+
+    StressThread* threads = (StressThread*)calloc((size_t)config.threads, sizeof(StressThread));
+    if (threads == NULL)
+    {
+        perror("Failed to allocate threads");
+        return EXIT_FAILURE;
+    }
+
+    unsigned long long start = nowNs();
+    pthread_t churnThread;
+    int churnStarted = (pthread_create(&churnThread, NULL, churnThreadMain, (void*)(unsigned long)config.seed) == 0);
+    int started = 0;
+    for (; started < config.threads; started++)
+    {
+        threads[started].id = started;
+        threads[started].rng = (config.seed + (unsigned long long)started * 0x9E3779B97F4A7C15ULL) | 1;
+        if (pthread_create(&(threads[started].thread), NULL, stressThreadMain, &(threads[started])) != 0)
+        {
+            perror("Failed to create stress thread");
+            failures++;
+            break;
+        }
+    }
+    for (int i = 0; i < started; i++)
+    {
+        pthread_join(threads[i].thread, NULL);
+    }
+    __atomic_store_n(&workersDone, 1, __ATOMIC_RELEASE);
+    if (churnStarted)
+    {
+        pthread_join(churnThread, NULL);
+    }
+    double seconds = (double)(nowNs() - start) / 1e9;
+
+    // 先停引擎：还在途的预读必须被排空，之后的关闭不能卡住
+    stopIoEngine();
+    CacheStats stats;
+    getCacheStats(cacheFd, &stats);
+    if (closeWithCache(cacheFd) < 0)
+    {
+        fprintf(stderr, "FAIL: close reported an error\n");
+        failures++;
+    }
+    stopCacheFlusher();
+    if (verifyFile() < 0)
+    {
+        failures++;
+    }
+    unlink(config.churnPath);
+
+    printf("%d threads x %lu ops in %.2f s, %lu open/close cycles, hits %llu misses %llu\n",
+           config.threads, config.ops, seconds, churnCycles, stats.hits, stats.misses);
+    printf("max open wait %.2f ms, max close wait %.2f ms\n", (double)maxOpenNs / 1e6, (double)maxCloseNs / 1e6);
+    if (maxOpenNs > config.maxWaitMs * 1000000ULL || maxCloseNs > config.maxWaitMs * 1000000ULL)
+    {
+        fprintf(stderr, "FAIL: open/close waited longer than %lu ms\n", config.maxWaitMs);
+        failures++;
+    }
+
+    free(threads);
+    free(shadow);
+    if (failures > 0)
+    {
+        printf("FAILED: %lu errors\n", failures);
+        return EXIT_FAILURE;
+    }
+    printf("OK\n");
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,83 @@
+#include "cacheStruct.h"
+#include "cacheIOHandler.h"
+#include "replacementPolicy.h"
+
+// 2Q：新块先进 FIFO 的 A1in，从 A1in 淘汰的块号记入 A1out，
+// 在 A1out 中被再次访问的块才进入 LRU 的 Am；扫描只会冲刷 A1in
+#define TWO_QUEUE_A1IN 0
+#define TWO_QUEUE_AM 1
+#define TWO_QUEUE_A1OUT 0
+
+#define TWO_QUEUE_KIN(total) MAX((total) / 4, (size_t)1)
+#define TWO_QUEUE_KOUT(total) MAX((total) / 2, (size_t)1)
+
+
+static void twoQueueInsert(ReplacementState* rs, cache* entry, long key)
+{
+    if (takeGhost(&(rs->ghosts[TWO_QUEUE_A1OUT]), key))
+    {
+        policyListPush(rs, TWO_QUEUE_AM, entry);
+    }
+    else
+    {
+        policyListPush(rs, TWO_QUEUE_A1IN, entry);
+    }
+}
+
+static void twoQueueHit(ReplacementState* rs, cache* entry)
+{
+    // A1in 是 FIFO，命中不调整位置
+    if (entry->policyList == TWO_QUEUE_AM)
+    {
+        moveToHead(&(rs->lists[TWO_QUEUE_AM]), entry);
+    }
+}
+
+static cache* twoQueueVictim(ReplacementState* rs)
+{
+    size_t a1in = (size_t)rs->lists[TWO_QUEUE_A1IN].size;
+    cache* victim = NULL;
+
+    if (a1in > TWO_QUEUE_KIN(replacementSize(rs)) || rs->lists[TWO_QUEUE_AM].size == 0)
+    {
+        victim = policyListVictim(rs, TWO_QUEUE_A1IN);
+    }
+    if (victim == NULL)
+    {
+        victim = policyListVictim(rs, TWO_QUEUE_AM);
+    }
+    if (victim == NULL)
+    {
+        victim = policyListVictim(rs, TWO_QUEUE_A1IN);
+    }
+    return victim;
+}
+
+static void twoQueueEvict(ReplacementState* rs, cache* entry, long key)
+{
+    int list = entry->policyList;
+    size_t total = replacementSize(rs);
+
+    policyListRemove(rs, entry);
+    if (list == TWO_QUEUE_A1IN)
+    {
+        addGhost(&(rs->ghosts[TWO_QUEUE_A1OUT]), key, TWO_QUEUE_KOUT(total));
+    }
+}
+
+static cache* twoQueueNext(ReplacementState* rs, cache* entry)
+{
+    return policyListsNext(rs, entry, 2);
+}
+
+const ReplacementPolicyOps twoQueuePolicyOps =
+{
+    "2q",
+    0,
+    twoQueueInsert,
+    twoQueueHit,
+    twoQueueVictim,
+    twoQueueEvict,
+    policyListRemove,
+    twoQueueNext,
+};